@@ -0,0 +1,247 @@
+﻿#include "aircrafttaskmodel.h"
+
+#include <QBrush>
+#include <QColor>
+
+namespace
+{
+QString requirementText(const Task &task)
+{
+    QStringList parts;
+    if (task.requiresFire)
+        parts << QStringLiteral("开火");
+    if (task.requiresHit)
+        parts << QStringLiteral("命中");
+    if (task.requiresDetection)
+        parts << QStringLiteral("探测");
+    if (task.requiresJam)
+        parts << QStringLiteral("电磁干扰");
+    return parts.isEmpty() ? QStringLiteral("无") : parts.join(QLatin1Char(','));
+}
+}
+
+AircraftTaskModel::AircraftTaskModel(QObject *parent)
+    : QAbstractItemModel(parent)
+{
+}
+
+void AircraftTaskModel::setState(SimulationState *state)
+{
+    beginResetModel();
+    m_state = state;
+    endResetModel();
+}
+
+Task AircraftTaskModel::task(int aircraft, int task) const
+{
+    return m_state->tasks.task(m_state->aircrafts.firstTask(aircraft) + task);
+}
+
+void AircraftTaskModel::tasksChanged(const QVector<TaskRef> &tasks)
+{
+    if (!m_state)
+        return;
+
+    for (const TaskRef &ref : tasks)
+    {
+        if (ref.aircraft < 0 || ref.aircraft >= m_state->aircrafts.size())
+            continue;
+        const QModelIndex aircraftIndex = index(ref.aircraft, 0);
+        const QModelIndex status = index(ref.task, StatusColumn, aircraftIndex);
+        if (status.isValid())
+        {
+            emit dataChanged(status, status);
+        }
+    }
+}
+
+void AircraftTaskModel::allTasksChanged()
+{
+    if (!m_state)
+        return;
+
+    for (int a = 0; a < m_state->aircrafts.size(); ++a)
+    {
+        const int count = taskCount(a);
+        if (count == 0)
+            continue;
+        const QModelIndex aircraftIndex = index(a, 0);
+        emit dataChanged(index(0, 0, aircraftIndex), index(count - 1, ColumnCount - 1, aircraftIndex));
+    }
+}
+
+void AircraftTaskModel::insertTask(int aircraft, const Task &task)
+{
+    if (!m_state || aircraft < 0 || aircraft >= m_state->aircrafts.size())
+        return;
+
+    const int count = taskCount(aircraft);
+    beginInsertRows(index(aircraft, 0), count, count);
+    m_state->tasks.insert(m_state->aircrafts, aircraft, count, task);
+    endInsertRows();
+}
+
+void AircraftTaskModel::removeTask(int aircraft, int task)
+{
+    if (!m_state || aircraft < 0 || aircraft >= m_state->aircrafts.size())
+        return;
+
+    if (task < 0 || task >= taskCount(aircraft))
+        return;
+    beginRemoveRows(index(aircraft, 0), task, task);
+    m_state->tasks.remove(m_state->aircrafts, aircraft, task);
+    endRemoveRows();
+}
+
+void AircraftTaskModel::setTask(int aircraft, int task, const Task &value)
+{
+    if (!m_state || aircraft < 0 || aircraft >= m_state->aircrafts.size())
+        return;
+
+    if (task < 0 || task >= taskCount(aircraft))
+        return;
+    m_state->tasks.set(m_state->aircrafts.firstTask(aircraft) + task, value);
+    const QModelIndex aircraftIndex = index(aircraft, 0);
+    emit dataChanged(index(task, 0, aircraftIndex), index(task, ColumnCount - 1, aircraftIndex));
+}
+
+void AircraftTaskModel::setRoute(int aircraft, const QVector<QPoint> &route)
+{
+    if (!m_state || aircraft < 0 || aircraft >= m_state->aircrafts.size())
+        return;
+
+    m_state->aircrafts.setRoute(aircraft, route);
+    emit dataChanged(index(aircraft, DetailColumn), index(aircraft, DetailColumn));
+}
+
+void AircraftTaskModel::setSecondsPerStep(int aircraft, double secondsPerStep)
+{
+    if (!m_state || aircraft < 0 || aircraft >= m_state->aircrafts.size())
+        return;
+
+    m_state->aircrafts.setSecondsPerStep(aircraft, secondsPerStep);
+    emit dataChanged(index(aircraft, StatusColumn), index(aircraft, StatusColumn));
+}
+
+QModelIndex AircraftTaskModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if (!m_state || row < 0 || column < 0 || column >= ColumnCount)
+        return {};
+
+    if (!parent.isValid())
+    {
+        return row < m_state->aircrafts.size() ? createIndex(row, column, quintptr(0)) : QModelIndex();
+    }
+
+    if (parent.internalId() != 0)
+        return {};
+    const int aircraft = parent.row();
+    if (aircraft >= m_state->aircrafts.size() || row >= taskCount(aircraft))
+        return {};
+    return createIndex(row, column, taskParentId(aircraft));
+}
+
+QModelIndex AircraftTaskModel::parent(const QModelIndex &child) const
+{
+    if (!child.isValid() || child.internalId() == 0)
+        return {};
+    return createIndex(int(child.internalId() - 1), 0, quintptr(0));
+}
+
+int AircraftTaskModel::rowCount(const QModelIndex &parent) const
+{
+    if (!m_state)
+        return 0;
+    if (!parent.isValid())
+        return m_state->aircrafts.size();
+    if (parent.internalId() != 0 || parent.column() != 0)
+        return 0;
+    return parent.row() < m_state->aircrafts.size() ? taskCount(parent.row()) : 0;
+}
+
+int AircraftTaskModel::columnCount(const QModelIndex &) const
+{
+    return ColumnCount;
+}
+
+QVariant AircraftTaskModel::data(const QModelIndex &index, int role) const
+{
+    if (!m_state || !index.isValid())
+        return {};
+
+    if (index.internalId() == 0)
+    {
+        if (index.row() >= m_state->aircrafts.size())
+            return {};
+        return aircraftData(index.row(), index.column(), role);
+    }
+
+    const int aircraft = int(index.internalId() - 1);
+    if (aircraft >= m_state->aircrafts.size() || index.row() >= taskCount(aircraft))
+        return {};
+    return taskData(task(aircraft, index.row()), index.column(), role);
+}
+
+QVariant AircraftTaskModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+        return {};
+
+    switch (section)
+    {
+    case NameColumn:
+        return QStringLiteral("飞机/任务");
+    case StatusColumn:
+        return QStringLiteral("状态/时间");
+    case DetailColumn:
+        return QStringLiteral("详情");
+    default:
+        return {};
+    }
+}
+
+QVariant AircraftTaskModel::aircraftData(int aircraft, int column, int role) const
+{
+    if (role != Qt::DisplayRole)
+        return {};
+
+    switch (column)
+    {
+    case NameColumn:
+        return m_state->aircrafts.name(aircraft);
+    case StatusColumn:
+        return QStringLiteral("速度 %1s/格").arg(m_state->aircrafts.secondsPerStep(aircraft), 0, 'f', 1);
+    case DetailColumn:
+        return QStringLiteral("航迹点 %1").arg(m_state->aircrafts.routeLength(aircraft));
+    default:
+        return {};
+    }
+}
+
+QVariant AircraftTaskModel::taskData(const Task &task, int column, int role) const
+{
+    if (role == Qt::ForegroundRole && column == StatusColumn)
+    {
+        if (task.status == TaskStatus::Success)
+            return QBrush(QColor(0, 128, 0));
+        if (task.status == TaskStatus::Failed)
+            return QBrush(Qt::red);
+        if (task.status == TaskStatus::AwaitingRuling)
+            return QBrush(QColor(200, 120, 0));
+        return {};
+    }
+    if (role != Qt::DisplayRole)
+        return {};
+
+    switch (column)
+    {
+    case NameColumn:
+        return QStringLiteral("- %1").arg(task.name);
+    case StatusColumn:
+        return task.statusText();
+    case DetailColumn:
+        return QStringLiteral("目标(%1,%2) | %3").arg(task.targetCell.x()).arg(task.targetCell.y()).arg(requirementText(task));
+    default:
+        return {};
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <QAbstractItemModel>
+#include <QVector>
+
+#include "models.h"
+#include "taskscheduler.h"
+
+// Two-level tree (aircraft -> tasks) over SimulationState::aircrafts and
+// SimulationState::tasks.
+// Status changes are published as dataChanged for just the affected rows;
+// structural edits go through the mutators below so views keep their
+// expansion and selection state.
+class AircraftTaskModel : public QAbstractItemModel
+{
+    Q_OBJECT
+public:
+    enum Column
+    {
+        NameColumn,
+        StatusColumn,
+        DetailColumn,
+        ColumnCount
+    };
+
+    explicit AircraftTaskModel(QObject *parent = nullptr);
+
+    void setState(SimulationState *state);
+    const AircraftStore *aircrafts() const { return m_state ? &m_state->aircrafts : nullptr; }
+    // Task `task` of aircraft `aircraft`; both must be in range.
+    Task task(int aircraft, int task) const;
+    int taskCount(int aircraft) const { return m_state->aircrafts.taskCount(aircraft); }
+
+    // Status updates coming from the simulation.
+    void tasksChanged(const QVector<TaskRef> &tasks);
+    void allTasksChanged();
+
+    // Edits coming from the task manager.
+    void insertTask(int aircraft, const Task &task);
+    void removeTask(int aircraft, int task);
+    void setTask(int aircraft, int task, const Task &value);
+    void setRoute(int aircraft, const QVector<QPoint> &route);
+    void setSecondsPerStep(int aircraft, double secondsPerStep);
+
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &child) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+private:
+    // internalId 0 marks an aircraft row; otherwise it is the owning aircraft index + 1.
+    static quintptr taskParentId(int aircraft) { return quintptr(aircraft) + 1; }
+
+    QVariant aircraftData(int aircraft, int column, int role) const;
+    QVariant taskData(const Task &task, int column, int role) const;
+
+    SimulationState *m_state = nullptr;
+};
@@ -0,0 +1,32 @@
+QT += core gui widgets
+CONFIG += c++17 console
+CONFIG -= app_bundle
+TEMPLATE = app
+TARGET = ruling
+
+include(../core/core.pri)
+
+SOURCES += \
+    main.cpp \
+    mainwindow.cpp \
+    environmentgridwidget.cpp \
+    manualrulingpanel.cpp \
+    taskmanagerdialog.cpp \
+    rulemodelmanagerdialog.cpp \
+    loglistmodel.cpp \
+    logitemdelegate.cpp \
+    aircrafttaskmodel.cpp
+
+HEADERS += \
+    mainwindow.h \
+    environmentgridwidget.h \
+    manualrulingpanel.h \
+    taskmanagerdialog.h \
+    rulemodelmanagerdialog.h \
+    loglistmodel.h \
+    logitemdelegate.h \
+    aircrafttaskmodel.h
+
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
@@ -0,0 +1,416 @@
+﻿#include "environmentgridwidget.h"
+#include "factorkernels.h"
+
+#include <QPainter>
+#include <QMouseEvent>
+#include <QDialog>
+#include <QFormLayout>
+#include <QSpinBox>
+#include <QDialogButtonBox>
+#include <QLabel>
+#include <QtMath>
+#include <QImage>
+
+namespace
+{
+constexpr int kCellPadding = 1;
+// Below this many pixels per cell the board is sampled per pixel instead of
+// drawn per cell, so large maps cost the widget area rather than the cell count.
+constexpr qreal kMinCellPixels = 4.0;
+const QColor kBackground(18, 27, 39);
+
+QRgb shadeForSum(int sum)
+{
+    static const QVector<QRgb> table = [] {
+        QVector<QRgb> colors(EnvironmentFactorCount * MaxFactorValue + 1);
+        for (int i = 0; i < colors.size(); ++i)
+        {
+            const double avg = i / 500.0;
+            const QColor fill = QColor::fromHsvF(0.55 - avg * 0.25, 0.35 + avg * 0.25, 0.4 + avg * 0.5);
+            const double alpha = 0.6;
+            colors[i] = qRgb(qRound(fill.red() * alpha + kBackground.red() * (1 - alpha)),
+                             qRound(fill.green() * alpha + kBackground.green() * (1 - alpha)),
+                             qRound(fill.blue() * alpha + kBackground.blue() * (1 - alpha)));
+        }
+        return colors;
+    }();
+    return table.at(sum);
+}
+}
+
+EnvironmentGridWidget::EnvironmentGridWidget(QWidget *parent)
+    : QWidget(parent)
+{
+    setMinimumSize(400, 400);
+}
+
+QSize EnvironmentGridWidget::sizeHint() const
+{
+    return {640, 640};
+}
+
+EnvironmentFactors EnvironmentGridWidget::factorsAt(const QPoint &cell) const
+{
+    return m_environment ? m_environment->at(cell) : EnvironmentFactors{};
+}
+
+void EnvironmentGridWidget::setFactorsAt(const QPoint &cell, const EnvironmentFactors &factors)
+{
+    if (!m_environment || !m_environment->contains(cell))
+        return;
+    m_environment->set(cell, factors);
+
+    // Patch the one cell in the cached layer instead of re-rendering the board;
+    // a sampled board has no per-cell rectangles and is rebuilt instead.
+    if (!m_baseLayer.isNull() && cellScale() >= kMinCellPixels)
+    {
+        QPainter painter(&m_baseLayer);
+        paintCell(painter, cell);
+        update(cellRect(cell).toAlignedRect());
+    }
+    else
+    {
+        m_baseLayer = QPixmap();
+        update();
+    }
+    emit cellFactorsChanged(cell, m_environment->at(cell));
+}
+
+void EnvironmentGridWidget::setEnvironment(EnvironmentField *environment)
+{
+    m_environment = environment;
+    invalidateLayers();
+}
+
+void EnvironmentGridWidget::setAircrafts(const AircraftStore *aircrafts)
+{
+    m_aircrafts = aircrafts;
+    invalidateLayers();
+}
+
+void EnvironmentGridWidget::routesChanged()
+{
+    m_routeLayer = QPixmap();
+    m_markerRects.clear();
+    update();
+}
+
+void EnvironmentGridWidget::updateAircraftMarkers()
+{
+    const int count = m_aircrafts ? m_aircrafts->size() : 0;
+    if (m_markerRects.size() != count)
+    {
+        update();
+        return;
+    }
+
+    for (int idx = 0; idx < count; ++idx)
+    {
+        const QRect rect = markerRect(idx);
+        if (rect != m_markerRects.at(idx))
+        {
+            update(m_markerRects.at(idx));
+            update(rect);
+            m_markerRects[idx] = rect;
+        }
+    }
+}
+
+void EnvironmentGridWidget::paintEvent(QPaintEvent *event)
+{
+    QWidget::paintEvent(event);
+    ensureLayers();
+
+    // The layers cover the whole widget; the update region clips the blits,
+    // so a marker move only copies the few pixels around it.
+    QPainter painter(this);
+    painter.drawPixmap(0, 0, m_baseLayer);
+    painter.drawPixmap(0, 0, m_routeLayer);
+
+    if (!m_aircrafts)
+        return;
+
+    const int count = m_aircrafts->size();
+    m_markerRects.resize(count);
+    painter.setClipRect(boardRect());
+    painter.setRenderHint(QPainter::Antialiasing, true);
+    const qreal radius = markerRadius();
+    for (int idx = 0; idx < count; ++idx)
+    {
+        m_markerRects[idx] = markerRect(idx);
+        if (!event->region().intersects(m_markerRects.at(idx)))
+            continue;
+
+        const QColor color = aircraftColor(idx);
+        const QPointF pos = cellRect(m_aircrafts->position(idx)).center();
+        painter.setPen(QPen(color, 2));
+        painter.setBrush(color);
+        painter.drawEllipse(pos, radius, radius);
+        painter.drawText(pos + QPointF(6, -6), m_aircrafts->name(idx));
+    }
+}
+
+void EnvironmentGridWidget::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    invalidateLayers();
+}
+
+void EnvironmentGridWidget::invalidateLayers()
+{
+    m_baseLayer = QPixmap();
+    m_routeLayer = QPixmap();
+    m_markerRects.clear();
+    update();
+}
+
+void EnvironmentGridWidget::ensureLayers()
+{
+    const qreal dpr = devicePixelRatioF();
+    if (m_baseLayer.isNull())
+    {
+        m_baseLayer = QPixmap(size() * dpr);
+        m_baseLayer.setDevicePixelRatio(dpr);
+        m_baseLayer.fill(kBackground);
+        QPainter painter(&m_baseLayer);
+        paintBaseLayer(painter);
+    }
+    if (m_routeLayer.isNull())
+    {
+        m_routeLayer = QPixmap(size() * dpr);
+        m_routeLayer.setDevicePixelRatio(dpr);
+        m_routeLayer.fill(Qt::transparent);
+        QPainter painter(&m_routeLayer);
+        paintRouteLayer(painter);
+    }
+}
+
+void EnvironmentGridWidget::paintBaseLayer(QPainter &painter) const
+{
+    const QRect board = boardRect();
+    const QSize grid = gridSize();
+    const qreal scale = cellScale();
+
+    painter.setPen(QPen(QColor(70, 90, 110)));
+    painter.drawRect(board);
+
+    if (!m_environment || board.isEmpty())
+        return;
+
+    if (scale < kMinCellPixels)
+    {
+        paintSampledBoard(painter, board);
+        return;
+    }
+
+    for (int y = 0; y < grid.height(); ++y)
+    {
+        for (int x = 0; x < grid.width(); ++x)
+        {
+            paintCell(painter, {x, y});
+        }
+    }
+
+    painter.setPen(QColor(45, 60, 80));
+    for (int i = 1; i < grid.width(); ++i)
+    {
+        const int x = board.left() + qRound(i * scale);
+        painter.drawLine(x, board.top(), x, board.bottom() + 1);
+    }
+    for (int i = 1; i < grid.height(); ++i)
+    {
+        const int y = board.top() + qRound(i * scale);
+        painter.drawLine(board.left(), y, board.right() + 1, y);
+    }
+}
+
+void EnvironmentGridWidget::paintSampledBoard(QPainter &painter, const QRect &board) const
+{
+    const QSize grid = gridSize();
+    const qreal scale = cellScale();
+
+    QVector<int> columns(board.width());
+    for (int px = 0; px < columns.size(); ++px)
+    {
+        columns[px] = qMin(grid.width() - 1, int(px / scale));
+    }
+
+    // One field row per factor is fetched per distinct cell row, so the cost
+    // follows the board's pixel size whatever the map dimensions are.
+    QImage image(board.size(), QImage::Format_RGB32);
+    QVector<quint8> rows[EnvironmentFactorCount];
+    const quint8 *planes[EnvironmentFactorCount];
+    for (int f = 0; f < EnvironmentFactorCount; ++f)
+    {
+        rows[f].resize(grid.width());
+        planes[f] = rows[f].constData();
+    }
+    QVector<quint16> sums(grid.width());
+    int loadedRow = -1;
+    for (int py = 0; py < board.height(); ++py)
+    {
+        const int cellY = qMin(grid.height() - 1, int(py / scale));
+        if (cellY != loadedRow)
+        {
+            for (int f = 0; f < EnvironmentFactorCount; ++f)
+            {
+                m_environment->copyRow(EnvironmentFactor(f), cellY, 0, grid.width(), rows[f].data());
+            }
+            FactorKernels::factorSum(planes, sums.data(), grid.width());
+            loadedRow = cellY;
+        }
+
+        QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(py));
+        for (int px = 0; px < board.width(); ++px)
+        {
+            line[px] = shadeForSum(sums.at(columns.at(px)));
+        }
+    }
+    painter.drawImage(board.topLeft(), image);
+}
+
+void EnvironmentGridWidget::paintRouteLayer(QPainter &painter) const
+{
+    if (!m_aircrafts)
+        return;
+
+    painter.setClipRect(boardRect());
+    painter.setRenderHint(QPainter::Antialiasing, true);
+    for (int idx = 0; idx < m_aircrafts->size(); ++idx)
+    {
+        const QPoint *route = m_aircrafts->route(idx);
+        painter.setPen(QPen(aircraftColor(idx), 2));
+        for (int p = 0; p + 1 < m_aircrafts->routeLength(idx); ++p)
+        {
+            const QPointF start = cellRect(route[p]).center();
+            const QPointF end = cellRect(route[p + 1]).center();
+            painter.drawLine(start, end);
+        }
+    }
+}
+
+void EnvironmentGridWidget::paintCell(QPainter &painter, const QPoint &cell) const
+{
+    const QRect inner = cellRect(cell).toAlignedRect().adjusted(kCellPadding, kCellPadding, -kCellPadding, -kCellPadding);
+    painter.fillRect(inner, QColor(shadeForSum(m_environment->factorSum(cell))));
+}
+
+QColor EnvironmentGridWidget::aircraftColor(int index) const
+{
+    const int hueStep = 360 / qMax(1, m_aircrafts ? m_aircrafts->size() : 1);
+    return QColor::fromHsv((index * hueStep) % 360, 200, 255);
+}
+
+QRect EnvironmentGridWidget::markerRect(int index) const
+{
+    const QPoint pos = cellRect(m_aircrafts->position(index)).center().toPoint();
+    const int radius = qCeil(markerRadius()) + 2;
+    const QRect dot(pos.x() - radius, pos.y() - radius, 2 * radius + 1, 2 * radius + 1);
+    const QRect label = fontMetrics().boundingRect(m_aircrafts->name(index)).translated(pos + QPoint(6, -6));
+    return dot.united(label).adjusted(-2, -2, 2, 2);
+}
+
+qreal EnvironmentGridWidget::markerRadius() const
+{
+    return qMax(3.0, cellScale() * 0.3);
+}
+
+void EnvironmentGridWidget::mouseDoubleClickEvent(QMouseEvent *event)
+{
+    const QPoint cell = cellForPosition(event->pos());
+    if (cell.x() < 0 || cell.y() < 0)
+    {
+        return;
+    }
+
+    EnvironmentFactors factors = factorsAt(cell);
+    if (editFactors(QStringLiteral("设置环境因子 (%1, %2)").arg(cell.x()).arg(cell.y()), factors))
+    {
+        setFactorsAt(cell, factors);
+    }
+}
+
+QSize EnvironmentGridWidget::gridSize() const
+{
+    return m_environment ? m_environment->size() : QSize(DefaultGridSize, DefaultGridSize);
+}
+
+qreal EnvironmentGridWidget::cellScale() const
+{
+    const QSize grid = gridSize();
+    const qreal scale = qMin(qreal(width()) / grid.width(), qreal(height()) / grid.height());
+    // Whole pixels per cell while cells are visible, so cell edges stay crisp.
+    return scale >= 1.0 ? qFloor(scale) : scale;
+}
+
+QRect EnvironmentGridWidget::boardRect() const
+{
+    const QSize grid = gridSize();
+    const qreal scale = cellScale();
+    const int boardWidth = qMax(1, qRound(grid.width() * scale));
+    const int boardHeight = qMax(1, qRound(grid.height() * scale));
+    return QRect((width() - boardWidth) / 2, (height() - boardHeight) / 2, boardWidth, boardHeight);
+}
+
+QRectF EnvironmentGridWidget::cellRect(const QPoint &cell) const
+{
+    const qreal scale = cellScale();
+    const QPoint origin = boardRect().topLeft();
+
+    return QRectF(origin.x() + cell.x() * scale,
+                  origin.y() + cell.y() * scale,
+                  scale,
+                  scale);
+}
+
+QPoint EnvironmentGridWidget::cellForPosition(const QPoint &pos) const
+{
+    const QRect board = boardRect();
+    if (!board.contains(pos))
+    {
+        return {-1, -1};
+    }
+
+    const QSize grid = gridSize();
+    const qreal scale = cellScale();
+    return {qMin(grid.width() - 1, int((pos.x() - board.left()) / scale)),
+            qMin(grid.height() - 1, int((pos.y() - board.top()) / scale))};
+}
+
+bool EnvironmentGridWidget::editFactors(QString title, EnvironmentFactors &factors) const
+{
+    QDialog dialog(const_cast<EnvironmentGridWidget *>(this));
+    dialog.setWindowTitle(std::move(title));
+
+    auto *layout = new QFormLayout(&dialog);
+
+    auto spin = [&](const QString &label, int value) {
+        auto *box = new QSpinBox(&dialog);
+        box->setRange(0, 100);
+        box->setValue(value);
+        layout->addRow(new QLabel(label, &dialog), box);
+        return box;
+    };
+
+    QSpinBox *ocean = spin(QStringLiteral("海洋深度"), factors.oceanDepth);
+    QSpinBox *air = spin(QStringLiteral("空气干燥度"), factors.airDryness);
+    QSpinBox *em = spin(QStringLiteral("电磁干扰系数"), factors.emInterference);
+    QSpinBox *temp = spin(QStringLiteral("气温"), factors.temperature);
+    QSpinBox *hum = spin(QStringLiteral("湿度"), factors.humidity);
+
+    auto *buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
+    layout->addRow(buttons);
+    QObject::connect(buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    QObject::connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+
+    if (dialog.exec() == QDialog::Accepted)
+    {
+        factors.oceanDepth = ocean->value();
+        factors.airDryness = air->value();
+        factors.emInterference = em->value();
+        factors.temperature = temp->value();
+        factors.humidity = hum->value();
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <QWidget>
+#include <QPixmap>
+#include <QVector>
+
+#include "models.h"
+
+class EnvironmentGridWidget : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit EnvironmentGridWidget(QWidget *parent = nullptr);
+
+    QSize sizeHint() const override;
+    EnvironmentFactors factorsAt(const QPoint &cell) const;
+    void setFactorsAt(const QPoint &cell, const EnvironmentFactors &factors);
+
+    // The field is owned by the simulation state; edits are written through.
+    void setEnvironment(EnvironmentField *environment);
+    void setAircrafts(const AircraftStore *aircrafts);
+    // Re-renders the cached route layer after waypoints were edited.
+    void routesChanged();
+    // Repaints only the markers whose aircraft moved since the last paint.
+    void updateAircraftMarkers();
+
+signals:
+    void cellFactorsChanged(const QPoint &cell, const EnvironmentFactors &factors);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+
+private:
+    void invalidateLayers();
+    void ensureLayers();
+    void paintBaseLayer(QPainter &painter) const;
+    void paintSampledBoard(QPainter &painter, const QRect &board) const;
+    void paintRouteLayer(QPainter &painter) const;
+    void paintCell(QPainter &painter, const QPoint &cell) const;
+    QColor aircraftColor(int index) const;
+    QRect markerRect(int index) const;
+    qreal markerRadius() const;
+
+    // Map dimensions come from the environment field; pixels per cell are
+    // whole numbers when cells are at least a pixel wide.
+    QSize gridSize() const;
+    qreal cellScale() const;
+    QRect boardRect() const;
+    QRectF cellRect(const QPoint &cell) const;
+    QPoint cellForPosition(const QPoint &pos) const;
+    bool editFactors(QString title, EnvironmentFactors &factors) const;
+
+    EnvironmentField *m_environment = nullptr;
+    const AircraftStore *m_aircrafts = nullptr;
+
+    // Environment cells and grid lines, then route polylines; aircraft
+    // markers are drawn live on top.
+    QPixmap m_baseLayer;
+    QPixmap m_routeLayer;
+    QVector<QRect> m_markerRects;
+};
@@ -0,0 +1,22 @@
+﻿#include "logitemdelegate.h"
+#include "loglistmodel.h"
+
+#include <QPainter>
+
+LogItemDelegate::LogItemDelegate(QObject *parent)
+    : QStyledItemDelegate(parent)
+{
+}
+
+void LogItemDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    QStyledItemDelegate::paint(painter, option, index);
+
+    if (index.data(LogListModel::TaskBoundaryRole).toBool())
+    {
+        painter->save();
+        painter->setPen(option.palette.color(QPalette::Mid));
+        painter->drawLine(option.rect.topLeft(), option.rect.topRight());
+        painter->restore();
+    }
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <QStyledItemDelegate>
+
+// Draws a rule above log rows that start a new aircraft/task group instead
+// of inserting blank separator rows.
+class LogItemDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+public:
+    explicit LogItemDelegate(QObject *parent = nullptr);
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+};
@@ -0,0 +1,93 @@
+﻿#include "loglistmodel.h"
+
+LogListModel::LogListModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+}
+
+void LogListModel::setBuffer(const TaskLogBuffer *buffer)
+{
+    beginResetModel();
+    m_buffer = buffer;
+    m_firstSerial = buffer ? buffer->firstSerial() : 0;
+    m_rowCount = buffer ? buffer->size() : 0;
+    endResetModel();
+}
+
+void LogListModel::sync()
+{
+    if (!m_buffer)
+        return;
+
+    const qint64 first = m_buffer->firstSerial();
+    const qint64 end = m_buffer->endSerial();
+    const qint64 publishedEnd = m_firstSerial + m_rowCount;
+
+    // Cleared, or every published row already evicted.
+    if (m_rowCount > 0 && first >= publishedEnd)
+    {
+        beginResetModel();
+        m_firstSerial = first;
+        m_rowCount = m_buffer->size();
+        endResetModel();
+        return;
+    }
+
+    if (m_rowCount == 0)
+    {
+        m_firstSerial = first;
+    }
+
+    const int removed = int(first - m_firstSerial);
+    if (removed > 0)
+    {
+        beginRemoveRows(QModelIndex(), 0, removed - 1);
+        m_firstSerial = first;
+        m_rowCount -= removed;
+        endRemoveRows();
+    }
+
+    const int inserted = int(end - (m_firstSerial + m_rowCount));
+    if (inserted > 0)
+    {
+        beginInsertRows(QModelIndex(), m_rowCount, m_rowCount + inserted - 1);
+        m_rowCount += inserted;
+        endInsertRows();
+    }
+}
+
+int LogListModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_rowCount;
+}
+
+QVariant LogListModel::data(const QModelIndex &index, int role) const
+{
+    const TaskLogEntry *entry = index.isValid() ? entryForRow(index.row()) : nullptr;
+    if (!entry)
+        return {};
+
+    switch (role)
+    {
+    case Qt::DisplayRole:
+        return QStringLiteral("[%1][%2][%3] %4").arg(entry->timestamp, entry->aircraftName, entry->taskName, entry->message);
+    case TaskBoundaryRole:
+    {
+        const TaskLogEntry *previous = index.row() > 0 ? entryForRow(index.row() - 1) : nullptr;
+        return previous && (previous->aircraftName != entry->aircraftName || previous->taskName != entry->taskName);
+    }
+    default:
+        return {};
+    }
+}
+
+const TaskLogEntry *LogListModel::entryForRow(int row) const
+{
+    if (!m_buffer || row < 0 || row >= m_rowCount)
+        return nullptr;
+
+    const qint64 index = m_firstSerial + row - m_buffer->firstSerial();
+    if (index < 0 || index >= m_buffer->size())
+        return nullptr;
+    return &m_buffer->at(int(index));
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <QAbstractListModel>
+
+#include "models.h"
+
+// Read-only list view over a TaskLogBuffer. Rows are formatted on demand,
+// so only the rows a view actually shows cost anything.
+class LogListModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    enum Roles
+    {
+        TaskBoundaryRole = Qt::UserRole + 1 // row starts a new aircraft/task group
+    };
+
+    explicit LogListModel(QObject *parent = nullptr);
+
+    void setBuffer(const TaskLogBuffer *buffer);
+    // Publishes what was appended to or evicted from the buffer since the
+    // last call as row insertions/removals.
+    void sync();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+private:
+    const TaskLogEntry *entryForRow(int row) const;
+
+    const TaskLogBuffer *m_buffer = nullptr;
+    qint64 m_firstSerial = 0; // buffer serial of row 0
+    int m_rowCount = 0;
+};
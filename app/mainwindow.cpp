@@ -0,0 +1,824 @@
+﻿#include "mainwindow.h"
+
+#include "aircrafttaskmodel.h"
+#include "environmentgridwidget.h"
+#include "environmentraster.h"
+#include "logitemdelegate.h"
+#include "loglistmodel.h"
+#include "manualrulingpanel.h"
+#include "rulemodelmanagerdialog.h"
+#include "seatserver.h"
+#include "taskmanagerdialog.h"
+
+#include <QAction>
+#include <QComboBox>
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QElapsedTimer>
+#include <QFileDialog>
+#include <QFormLayout>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QMessageBox>
+#include <QListView>
+#include <QPushButton>
+#include <QScrollBar>
+#include <QSignalBlocker>
+#include <QSlider>
+#include <QSpinBox>
+#include <QSplitter>
+#include <QStatusBar>
+#include <QThread>
+#include <QTimer>
+#include <QToolBar>
+#include <QTreeView>
+#include <QVBoxLayout>
+#include <QtNumeric>
+
+#include <cmath>
+
+namespace
+{
+// Display refresh interval and the share of it simulation steps may use.
+constexpr int kFrameIntervalMs = 16;
+constexpr qint64 kFrameBudgetMs = 12;
+// Timeline snapshots: one every 10 simulated seconds, within 256 MB.
+constexpr double kSnapshotInterval = 10.0;
+constexpr qint64 kSnapshotBudget = qint64(256) * 1024 * 1024;
+// Adjudication seats connect over the default local socket or this TCP port.
+constexpr quint16 kSeatTcpPort = 47310;
+}
+
+MainWindow::MainWindow(QWidget *parent)
+    : QMainWindow(parent)
+    , m_state(m_core.state())
+{
+    setWindowTitle(QStringLiteral("裁决控制台"));
+    resize(1600, 900);
+
+    m_timer = new QTimer(this);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    connect(m_timer, &QTimer::timeout, this, &MainWindow::advanceSimulation);
+
+    setupUi();
+    setupSimulationCore();
+    loadSampleData();
+
+    refreshModeSelector();
+    refreshRuleModelSelectors();
+    refreshAircraftTree();
+    refreshLogView();
+    updateTimeLabel();
+    pauseSimulation();
+}
+
+void MainWindow::setupUi()
+{
+    auto *central = new QWidget(this);
+    auto *centralLayout = new QHBoxLayout(central);
+    centralLayout->setContentsMargins(0, 0, 0, 0);
+
+    auto *splitter = new QSplitter(Qt::Horizontal, central);
+
+    auto *leftPanel = new QWidget(splitter);
+    auto *leftLayout = new QVBoxLayout(leftPanel);
+    leftLayout->setContentsMargins(6, 6, 6, 6);
+
+    m_taskModel = new AircraftTaskModel(this);
+    m_taskTree = new QTreeView(leftPanel);
+    m_taskTree->setModel(m_taskModel);
+    m_taskTree->setRootIsDecorated(true);
+    m_taskTree->setUniformRowHeights(true);
+    m_taskTree->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    leftLayout->addWidget(m_taskTree, 1);
+
+    m_logModel = new LogListModel(this);
+    m_logModel->setBuffer(&m_state.logs);
+    m_logView = new QListView(leftPanel);
+    m_logView->setModel(m_logModel);
+    m_logView->setItemDelegate(new LogItemDelegate(m_logView));
+    m_logView->setUniformItemSizes(true);
+    m_logView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_logView->setToolTip(QStringLiteral("裁决结果将显示在此"));
+    leftLayout->addWidget(m_logView, 1);
+
+    splitter->addWidget(leftPanel);
+
+    m_grid = new EnvironmentGridWidget(splitter);
+    splitter->addWidget(m_grid);
+
+    splitter->setStretchFactor(0, 2);
+    splitter->setStretchFactor(1, 3);
+
+    centralLayout->addWidget(splitter);
+    setCentralWidget(central);
+
+    m_rulingPanel = new ManualRulingPanel(this);
+    addDockWidget(Qt::RightDockWidgetArea, m_rulingPanel);
+
+    setupToolBar();
+    setupStatusBar();
+}
+
+void MainWindow::setupToolBar()
+{
+    auto *toolbar = addToolBar(QStringLiteral("控制"));
+    toolbar->setMovable(false);
+
+    toolbar->addWidget(new QLabel(QStringLiteral("模式:"), toolbar));
+    m_modeCombo = new QComboBox(toolbar);
+    m_modeCombo->addItem(QStringLiteral("自动裁决"));
+    m_modeCombo->addItem(QStringLiteral("人工裁决"));
+    m_modeCombo->addItem(QStringLiteral("随机裁决"));
+    connect(m_modeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &MainWindow::onModeChanged);
+    toolbar->addWidget(m_modeCombo);
+
+    toolbar->addSeparator();
+    toolbar->addWidget(new QLabel(QStringLiteral("裁决规则:"), toolbar));
+    m_ruleCombo = new QComboBox(toolbar);
+    connect(m_ruleCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &MainWindow::onRuleChanged);
+    toolbar->addWidget(m_ruleCombo);
+
+    toolbar->addWidget(new QLabel(QStringLiteral("裁决模型:"), toolbar));
+    m_modelCombo = new QComboBox(toolbar);
+    connect(m_modelCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &MainWindow::onModelChanged);
+    toolbar->addWidget(m_modelCombo);
+
+    toolbar->addSeparator();
+    m_startButton = new QPushButton(QStringLiteral("开始"), toolbar);
+    connect(m_startButton, &QPushButton::clicked, this, &MainWindow::startSimulation);
+    toolbar->addWidget(m_startButton);
+
+    m_pauseButton = new QPushButton(QStringLiteral("暂停"), toolbar);
+    connect(m_pauseButton, &QPushButton::clicked, this, &MainWindow::pauseSimulation);
+    toolbar->addWidget(m_pauseButton);
+
+    auto *nextEventBtn = new QPushButton(QStringLiteral("下一事件"), toolbar);
+    nextEventBtn->setToolTip(QStringLiteral("直接跳到下一个任务执行或航迹点时刻"));
+    connect(nextEventBtn, &QPushButton::clicked, this, &MainWindow::jumpToNextEvent);
+    toolbar->addWidget(nextEventBtn);
+
+    toolbar->addWidget(new QLabel(QStringLiteral("速度:"), toolbar));
+    m_speedCombo = new QComboBox(toolbar);
+    const double multipliers[] = {0.25, 0.5, 1, 2, 5, 10, 100, 1000};
+    for (double multiplier : multipliers)
+    {
+        m_speedCombo->addItem(QStringLiteral("x%1").arg(multiplier), multiplier);
+    }
+    m_speedCombo->addItem(QStringLiteral("最快"), SimulationPacer::AsFastAsPossible);
+    m_speedCombo->setCurrentIndex(m_speedCombo->findData(1.0));
+    connect(m_speedCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &MainWindow::onSpeedChanged);
+    toolbar->addWidget(m_speedCombo);
+
+    toolbar->addSeparator();
+    auto *taskAction = toolbar->addAction(QStringLiteral("任务管理"));
+    connect(taskAction, &QAction::triggered, this, &MainWindow::openTaskManager);
+
+    auto *ruleAction = toolbar->addAction(QStringLiteral("规则/模型管理"));
+    connect(ruleAction, &QAction::triggered, this, &MainWindow::openRuleModelManager);
+
+    auto *openScenarioAction = toolbar->addAction(QStringLiteral("打开想定"));
+    connect(openScenarioAction, &QAction::triggered, this, &MainWindow::openScenario);
+
+    auto *saveScenarioAction = toolbar->addAction(QStringLiteral("保存想定"));
+    connect(saveScenarioAction, &QAction::triggered, this, &MainWindow::saveScenario);
+
+    m_journalAction = toolbar->addAction(QStringLiteral("记录回放"));
+    m_journalAction->setCheckable(true);
+    connect(m_journalAction, &QAction::toggled, this, &MainWindow::toggleJournal);
+
+    auto *replayAction = toolbar->addAction(QStringLiteral("加载回放"));
+    connect(replayAction, &QAction::triggered, this, &MainWindow::openReplay);
+
+    m_seatAction = toolbar->addAction(QStringLiteral("开放裁决席位"));
+    m_seatAction->setCheckable(true);
+    connect(m_seatAction, &QAction::toggled, this, &MainWindow::toggleSeats);
+
+    auto *resultAction = toolbar->addAction(QStringLiteral("发布裁决结果"));
+    resultAction->setCheckable(true);
+    connect(resultAction, &QAction::toggled, this, [this, resultAction](bool publish) {
+        toggleResultChannel(publish);
+        resultAction->setChecked(m_core.isPublishingResults());
+    });
+
+    auto *mapAction = toolbar->addAction(QStringLiteral("地图尺寸"));
+    connect(mapAction, &QAction::triggered, this, &MainWindow::openMapSizeDialog);
+
+    auto *importEnvAction = toolbar->addAction(QStringLiteral("导入环境"));
+    connect(importEnvAction, &QAction::triggered, this, &MainWindow::importEnvironment);
+
+    auto *exportEnvAction = toolbar->addAction(QStringLiteral("导出环境"));
+    connect(exportEnvAction, &QAction::triggered, this, &MainWindow::exportEnvironment);
+
+    toolbar->addSeparator();
+    auto *clearLogBtn = new QPushButton(QStringLiteral("清除日志"), toolbar);
+    connect(clearLogBtn, &QPushButton::clicked, this, &MainWindow::clearLog);
+    toolbar->addWidget(clearLogBtn);
+
+    auto *resetBtn = new QPushButton(QStringLiteral("重新开始"), toolbar);
+    connect(resetBtn, &QPushButton::clicked, this, &MainWindow::resetSimulation);
+    toolbar->addWidget(resetBtn);
+}
+
+void MainWindow::setupStatusBar()
+{
+    m_timelineSlider = new QSlider(Qt::Horizontal, this);
+    m_timelineSlider->setMinimumWidth(400);
+    m_timelineSlider->setRange(0, 0);
+    connect(m_timelineSlider, &QSlider::valueChanged, this, [this](int value) {
+        if (!m_timelineSlider->isSliderDown())
+            seekTimeline(value);
+    });
+    connect(m_timelineSlider, &QSlider::sliderReleased, this, [this]() { seekTimeline(m_timelineSlider->value()); });
+    statusBar()->addPermanentWidget(new QLabel(QStringLiteral("时间轴:"), this));
+    statusBar()->addPermanentWidget(m_timelineSlider, 1);
+
+    m_seatLabel = new QLabel(QStringLiteral("裁决席位: 未开放"), this);
+    statusBar()->addPermanentWidget(m_seatLabel);
+
+    m_timeLabel = new QLabel(QStringLiteral("仿真时间: 0 s"), this);
+    statusBar()->addPermanentWidget(m_timeLabel);
+}
+
+void MainWindow::onModeChanged(int index)
+{
+    switch (index)
+    {
+    case 1:
+        m_state.mode = AdjudicationMode::Manual;
+        break;
+    case 2:
+        m_state.mode = AdjudicationMode::Stochastic;
+        break;
+    default:
+        m_state.mode = AdjudicationMode::Automatic;
+        break;
+    }
+    const bool automatic = m_state.mode != AdjudicationMode::Manual;
+    if (m_ruleCombo)
+        m_ruleCombo->setEnabled(automatic);
+    if (m_modelCombo)
+        m_modelCombo->setEnabled(automatic);
+    m_core.scenarioEdited();
+}
+
+void MainWindow::onRuleChanged(int index)
+{
+    if (index >= 0)
+    {
+        m_state.currentRuleId = m_ruleCombo->itemData(index).toUInt();
+        m_core.scenarioEdited();
+    }
+}
+
+void MainWindow::onModelChanged(int index)
+{
+    if (index >= 0)
+    {
+        m_state.currentModelId = m_modelCombo->itemData(index).toUInt();
+        m_core.scenarioEdited();
+    }
+}
+
+void MainWindow::onSpeedChanged(int index)
+{
+    if (index >= 0)
+    {
+        m_pacer.setMultiplier(m_speedCombo->itemData(index).toDouble(), m_state.simulationTime);
+    }
+}
+
+void MainWindow::startSimulation()
+{
+    if (!m_timer || !m_state.paused)
+        return;
+
+    m_state.paused = false;
+    m_pacer.start(m_state.simulationTime);
+    m_timer->start(kFrameIntervalMs);
+    if (m_startButton)
+        m_startButton->setEnabled(false);
+    if (m_pauseButton)
+        m_pauseButton->setEnabled(true);
+}
+
+void MainWindow::pauseSimulation()
+{
+    if (!m_timer)
+        return;
+    m_state.paused = true;
+    m_timer->stop();
+    m_pacer.stop();
+    if (m_startButton)
+        m_startButton->setEnabled(true);
+    if (m_pauseButton)
+        m_pauseButton->setEnabled(false);
+}
+
+void MainWindow::advanceSimulation()
+{
+    if (m_state.paused)
+        return;
+    if (m_core.isHeld())
+    {
+        // Time stands still until the queued rulings are given.
+        m_pacer.resync(m_state.simulationTime);
+        return;
+    }
+
+    // Catch up with the wall clock in fixed steps, then render once per frame
+    // however many steps ran.
+    QElapsedTimer frame;
+    frame.start();
+    const qint64 due = m_pacer.stepsDue(m_state.simulationTime);
+    qint64 done = 0;
+    while (done < due && !m_state.paused && !m_core.isHeld())
+    {
+        m_core.step(SimulationPacer::FixedStep);
+        ++done;
+        if (frame.elapsed() >= kFrameBudgetMs)
+            break;
+    }
+
+    if (done == 0)
+        return;
+    if (done < due && !m_state.paused && !m_pacer.isAsFastAsPossible())
+    {
+        m_pacer.resync(m_state.simulationTime);
+    }
+    refreshAfterAdvance();
+}
+
+void MainWindow::jumpToNextEvent()
+{
+    const double next = m_core.nextEventTime();
+    if (qIsInf(next))
+        return;
+
+    m_core.advanceTo(next);
+    refreshAfterAdvance();
+}
+
+void MainWindow::refreshAfterAdvance()
+{
+    if (m_journalAction->isChecked() && !m_core.isJournaling())
+    {
+        // A write failed and the core stopped recording.
+        pauseSimulation();
+        m_journalAction->setChecked(false);
+        QMessageBox::warning(this, QStringLiteral("记录失败"), m_core.journalError());
+    }
+    updateTimeLabel();
+    if (m_grid)
+    {
+        m_grid->updateAircraftMarkers();
+    }
+    refreshChangedTasks();
+    refreshLogView();
+    refreshRulingQueue();
+}
+
+void MainWindow::refreshRulingQueue()
+{
+    if (m_rulingPanel)
+    {
+        m_rulingPanel->refresh();
+    }
+    if (m_seatServer)
+    {
+        m_seatServer->sync();
+    }
+}
+
+void MainWindow::updateSeatLabel()
+{
+    if (!m_seatLabel || !m_seatServer)
+        return;
+    m_seatLabel->setText(m_seatServer->isListening()
+                             ? QStringLiteral("裁决席位: %1").arg(m_seatServer->seatCount())
+                             : QStringLiteral("裁决席位: 未开放"));
+}
+
+void MainWindow::openTaskManager()
+{
+    TaskManagerDialog dialog(this);
+    dialog.setModel(m_taskModel);
+    dialog.setRules(&m_state.rules);
+    dialog.setGridSize(m_state.environment.size());
+
+    dialog.exec();
+    m_core.rebuildSchedule();
+    m_core.scenarioEdited();
+    if (m_grid)
+        m_grid->routesChanged();
+}
+
+void MainWindow::openRuleModelManager()
+{
+    RuleModelManagerDialog dialog(this);
+    dialog.setData(&m_state.rules, &m_state.models);
+    dialog.exec();
+
+    refreshRuleModelSelectors();
+    m_core.scenarioEdited();
+}
+
+void MainWindow::openMapSizeDialog()
+{
+    QDialog dialog(this);
+    dialog.setWindowTitle(QStringLiteral("地图尺寸"));
+    auto *layout = new QFormLayout(&dialog);
+
+    auto *widthSpin = new QSpinBox(&dialog);
+    widthSpin->setRange(1, MaxGridSize);
+    widthSpin->setValue(m_state.environment.width());
+    auto *heightSpin = new QSpinBox(&dialog);
+    heightSpin->setRange(1, MaxGridSize);
+    heightSpin->setValue(m_state.environment.height());
+    layout->addRow(QStringLiteral("宽度 (格)"), widthSpin);
+    layout->addRow(QStringLiteral("高度 (格)"), heightSpin);
+    layout->addRow(new QLabel(QStringLiteral("修改尺寸会将所有环境因子恢复为默认值"), &dialog));
+
+    auto *buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
+    layout->addRow(buttons);
+    connect(buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+
+    if (dialog.exec() != QDialog::Accepted)
+        return;
+
+    m_state.environment.resize(widthSpin->value(), heightSpin->value());
+    m_core.scenarioEdited();
+    if (m_grid)
+    {
+        m_grid->setEnvironment(&m_state.environment);
+    }
+}
+
+void MainWindow::importEnvironment()
+{
+    const QString path = QFileDialog::getOpenFileName(this, QStringLiteral("导入环境栅格"), QString(),
+                                                      QStringLiteral("环境栅格 (*.afenv);;所有文件 (*)"));
+    if (path.isEmpty())
+        return;
+
+    QString error;
+    if (!EnvironmentRaster::load(path, m_state.environment, &error))
+    {
+        QMessageBox::warning(this, QStringLiteral("导入失败"), error);
+        return;
+    }
+    m_core.scenarioEdited();
+    if (m_grid)
+    {
+        m_grid->setEnvironment(&m_state.environment);
+    }
+}
+
+void MainWindow::exportEnvironment()
+{
+    const QString path = QFileDialog::getSaveFileName(this, QStringLiteral("导出环境栅格"), QString(),
+                                                      QStringLiteral("环境栅格 (*.afenv)"));
+    if (path.isEmpty())
+        return;
+
+    QString error;
+    if (!EnvironmentRaster::save(path, m_state.environment, EnvironmentRaster::Layout::Tiled, &error))
+    {
+        QMessageBox::warning(this, QStringLiteral("导出失败"), error);
+    }
+}
+
+void MainWindow::openScenario()
+{
+    const QString path = QFileDialog::getOpenFileName(this, QStringLiteral("打开想定"), QString(),
+                                                      QStringLiteral("想定文件 (*.afscn *.json);;所有文件 (*)"));
+    if (path.isEmpty())
+        return;
+
+    pauseSimulation();
+    QString error;
+    if (!m_core.loadScenario(path, &error))
+    {
+        QMessageBox::warning(this, QStringLiteral("打开失败"), error);
+        return;
+    }
+
+    m_journalAction->setChecked(false);
+    bindScenarioViews();
+    refreshModeSelector();
+    refreshRuleModelSelectors();
+    refreshAircraftTree();
+    refreshLogView();
+    updateTimeLabel();
+}
+
+void MainWindow::saveScenario()
+{
+    const QString path = QFileDialog::getSaveFileName(this, QStringLiteral("保存想定"), QString(),
+                                                      QStringLiteral("二进制想定 (*.afscn);;JSON 想定 (*.json)"));
+    if (path.isEmpty())
+        return;
+
+    QString error;
+    if (!m_core.saveScenario(path, &error))
+    {
+        QMessageBox::warning(this, QStringLiteral("保存失败"), error);
+    }
+}
+
+void MainWindow::toggleJournal(bool record)
+{
+    if (record == m_core.isJournaling())
+        return;
+    if (!record)
+    {
+        m_core.stopJournal();
+        return;
+    }
+
+    const QString path = QFileDialog::getSaveFileName(this, QStringLiteral("记录回放"), QString(),
+                                                      QStringLiteral("回放日志 (*.afjrnl)"));
+    QString error;
+    pauseSimulation();
+    if (path.isEmpty() || !m_core.startJournal(path, &error))
+    {
+        if (!error.isEmpty())
+            QMessageBox::warning(this, QStringLiteral("记录失败"), error);
+        m_journalAction->setChecked(false);
+        return;
+    }
+
+    // The run restarts from a reloaded copy of the scenario.
+    bindScenarioViews();
+    refreshRuleModelSelectors();
+    refreshAircraftTree();
+    refreshLogView();
+    updateTimeLabel();
+}
+
+void MainWindow::openReplay()
+{
+    const QString path = QFileDialog::getOpenFileName(this, QStringLiteral("加载回放"), QString(),
+                                                      QStringLiteral("回放日志 (*.afjrnl);;所有文件 (*)"));
+    if (path.isEmpty())
+        return;
+
+    pauseSimulation();
+    QString error;
+    if (!m_core.loadReplay(path, ReplayJournal::Options(), &error))
+    {
+        QMessageBox::warning(this, QStringLiteral("回放失败"), error);
+        return;
+    }
+
+    m_journalAction->setChecked(false);
+    m_logModel->setBuffer(&m_state.logs);
+    bindScenarioViews();
+    refreshModeSelector();
+    refreshRuleModelSelectors();
+    refreshAircraftTree();
+    refreshLogView();
+    updateTimeLabel();
+}
+
+void MainWindow::toggleSeats(bool open)
+{
+    if (open == m_seatServer->isListening())
+        return;
+    if (!open)
+    {
+        m_seatServer->close();
+        updateSeatLabel();
+        return;
+    }
+
+    QString error;
+    if (!m_seatServer->listen(QString::fromLatin1(SeatProtocol::DefaultServerName), kSeatTcpPort, &error))
+    {
+        QMessageBox::warning(this, QStringLiteral("开放席位失败"), error);
+        m_seatAction->setChecked(false);
+        return;
+    }
+    updateSeatLabel();
+    m_seatServer->sync();
+}
+
+void MainWindow::toggleResultChannel(bool publish)
+{
+    if (publish == m_core.isPublishingResults())
+        return;
+    if (!publish)
+    {
+        m_core.stopResultChannel();
+        return;
+    }
+
+    QString error;
+    if (!m_core.startResultChannel(QString::fromLatin1(ResultPublisher::DefaultName), ResultPublisher::DefaultCapacity, &error))
+        QMessageBox::warning(this, QStringLiteral("发布失败"), error);
+}
+
+void MainWindow::seekTimeline(int seconds)
+{
+    if (double(seconds) == m_state.simulationTime)
+        return;
+
+    const bool resumeAfter = !m_state.paused;
+    pauseSimulation();
+    if (!m_core.seek(seconds))
+    {
+        updateTimeLabel();
+        return;
+    }
+
+    // Going back may have rolled back edits and stopped the journal.
+    m_journalAction->setChecked(m_core.isJournaling());
+    m_logModel->setBuffer(&m_state.logs);
+    bindScenarioViews();
+    refreshModeSelector();
+    refreshRuleModelSelectors();
+    refreshAircraftTree();
+    refreshLogView();
+    updateTimeLabel();
+    if (resumeAfter)
+    {
+        startSimulation();
+    }
+}
+
+void MainWindow::setupSimulationCore()
+{
+    m_core.setChangeTrackingEnabled(true);
+    m_core.setThreadCount(QThread::idealThreadCount());
+    m_core.setSnapshotInterval(kSnapshotInterval);
+    m_core.setSnapshotBudget(kSnapshotBudget);
+
+    // Cached score fields recompute just the edited cell.
+    connect(m_grid, &EnvironmentGridWidget::cellFactorsChanged, this, [this](const QPoint &cell) {
+        m_core.environmentCellChanged(cell);
+    });
+
+    // Manual rulings wait in the queue panel instead of stopping the run.
+    m_core.setManualQueueEnabled(true);
+    m_rulingPanel->setCore(&m_core);
+    connect(m_rulingPanel, &ManualRulingPanel::rulingsApplied, this, &MainWindow::refreshAfterAdvance);
+
+    // Seats in other processes take queued rulings too, while the action is on.
+    m_seatServer = new SeatServer(&m_core, this);
+    connect(m_seatServer, &SeatServer::rulingsApplied, this, &MainWindow::refreshAfterAdvance);
+    connect(m_seatServer, &SeatServer::seatsChanged, this, &MainWindow::updateSeatLabel);
+}
+
+void MainWindow::loadSampleData()
+{
+    m_core.loadSampleScenario();
+    bindScenarioViews();
+}
+
+void MainWindow::bindScenarioViews()
+{
+    if (m_grid)
+    {
+        m_grid->setEnvironment(&m_state.environment);
+        m_grid->setAircrafts(&m_state.aircrafts);
+    }
+    if (m_taskModel)
+    {
+        m_taskModel->setState(&m_state);
+        m_taskTree->expandAll();
+    }
+}
+
+void MainWindow::refreshAircraftTree()
+{
+    if (!m_taskModel)
+        return;
+
+    m_taskModel->allTasksChanged();
+    // Queued rulings follow the task statuses.
+    refreshRulingQueue();
+}
+
+void MainWindow::refreshChangedTasks()
+{
+    if (!m_taskModel)
+        return;
+
+    m_taskModel->tasksChanged(m_core.takeChangedTasks());
+}
+
+void MainWindow::refreshRuleModelSelectors()
+{
+    if (m_ruleCombo)
+    {
+        m_ruleCombo->blockSignals(true);
+        m_ruleCombo->clear();
+        for (const AdjudicationRule &rule : m_state.rules)
+        {
+            m_ruleCombo->addItem(rule.name, rule.id);
+        }
+        int ruleIndex = m_state.rules.indexOf(m_state.currentRuleId);
+        if (ruleIndex < 0 && m_ruleCombo->count() > 0)
+        {
+            ruleIndex = 0;
+            m_state.currentRuleId = m_state.rules.at(0).id;
+        }
+        if (ruleIndex >= 0)
+        {
+            m_ruleCombo->setCurrentIndex(ruleIndex);
+        }
+        m_ruleCombo->setEnabled(m_state.mode != AdjudicationMode::Manual && m_ruleCombo->count() > 0);
+        m_ruleCombo->blockSignals(false);
+    }
+
+    if (m_modelCombo)
+    {
+        m_modelCombo->blockSignals(true);
+        m_modelCombo->clear();
+        for (const AdjudicationModel &model : m_state.models)
+        {
+            m_modelCombo->addItem(model.name, model.id);
+        }
+        int modelIndex = m_state.models.indexOf(m_state.currentModelId);
+        if (modelIndex < 0 && m_modelCombo->count() > 0)
+        {
+            modelIndex = 0;
+            m_state.currentModelId = m_state.models.at(0).id;
+        }
+        if (modelIndex >= 0)
+        {
+            m_modelCombo->setCurrentIndex(modelIndex);
+        }
+        m_modelCombo->setEnabled(m_state.mode != AdjudicationMode::Manual && m_modelCombo->count() > 0);
+        m_modelCombo->blockSignals(false);
+    }
+}
+
+void MainWindow::refreshModeSelector()
+{
+    if (!m_modeCombo)
+        return;
+    m_modeCombo->blockSignals(true);
+    m_modeCombo->setCurrentIndex(m_state.mode == AdjudicationMode::Manual ? 1 : m_state.mode == AdjudicationMode::Stochastic ? 2 : 0);
+    m_modeCombo->blockSignals(false);
+    onModeChanged(m_modeCombo->currentIndex());
+}
+
+void MainWindow::refreshLogView()
+{
+    if (!m_logView || !m_logModel)
+        return;
+
+    // Follow new entries only while the user is looking at the newest ones.
+    QScrollBar *bar = m_logView->verticalScrollBar();
+    const bool atBottom = !bar || bar->value() == bar->maximum();
+    m_logModel->sync();
+    if (atBottom)
+    {
+        m_logView->scrollToBottom();
+    }
+}
+
+void MainWindow::updateTimeLabel()
+{
+    if (m_timeLabel)
+    {
+        m_timeLabel->setText(QStringLiteral("仿真时间: %1 s").arg(m_state.simulationTime, 0, 'f', 1));
+    }
+    if (m_timelineSlider && !m_timelineSlider->isSliderDown())
+    {
+        const SimulationTimeline &timeline = m_core.timeline();
+        const QSignalBlocker blocker(m_timelineSlider);
+        m_timelineSlider->setMaximum(int(std::ceil(m_core.timelineEnd())));
+        m_timelineSlider->setValue(int(m_state.simulationTime));
+        m_timelineSlider->setToolTip(QStringLiteral("快照 %1 个，占用 %2 MB")
+                                         .arg(timeline.size())
+                                         .arg(double(timeline.memoryUsage()) / (1024 * 1024), 0, 'f', 1));
+    }
+}
+
+void MainWindow::clearLog()
+{
+    m_state.logs.clear();
+    refreshLogView();
+}
+
+void MainWindow::resetSimulation()
+{
+    // 暂停仿真
+    pauseSimulation();
+
+    // 重置仿真时间、飞机与任务状态并清除日志
+    m_core.reset();
+
+    // 刷新所有显示
+    refreshAircraftTree();
+    refreshLogView();
+    updateTimeLabel();
+
+    if (m_grid)
+    {
+        m_grid->updateAircraftMarkers();
+    }
+}
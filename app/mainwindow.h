@@ -0,0 +1,97 @@
+#pragma once
+
+#include <QMainWindow>
+
+#include "simulationcore.h"
+#include "simulationpacer.h"
+
+class EnvironmentGridWidget;
+class QTreeView;
+class QListView;
+class QAction;
+class QComboBox;
+class QLabel;
+class QPushButton;
+class QSlider;
+class QTimer;
+class ManualRulingPanel;
+class SeatServer;
+class TaskManagerDialog;
+class RuleModelManagerDialog;
+class LogListModel;
+class AircraftTaskModel;
+
+class MainWindow : public QMainWindow
+{
+    Q_OBJECT
+public:
+    explicit MainWindow(QWidget *parent = nullptr);
+
+private slots:
+    void onModeChanged(int index);
+    void onRuleChanged(int index);
+    void onModelChanged(int index);
+    void onSpeedChanged(int index);
+    void startSimulation();
+    void pauseSimulation();
+    void advanceSimulation();
+    void jumpToNextEvent();
+    void openTaskManager();
+    void openRuleModelManager();
+    void openMapSizeDialog();
+    void importEnvironment();
+    void exportEnvironment();
+    void openScenario();
+    void saveScenario();
+    void toggleJournal(bool record);
+    void openReplay();
+    void toggleSeats(bool open);
+    void toggleResultChannel(bool publish);
+    void seekTimeline(int seconds);
+    void clearLog();
+    void resetSimulation();
+
+private:
+    void setupUi();
+    void setupToolBar();
+    void setupStatusBar();
+
+    void loadSampleData();
+    void bindScenarioViews();
+    void setupSimulationCore();
+    void refreshAircraftTree();
+    void refreshChangedTasks();
+    void refreshRuleModelSelectors();
+    void refreshModeSelector();
+    void refreshLogView();
+    void updateTimeLabel();
+    void refreshAfterAdvance();
+    // Queued manual rulings: the panel and the external seats.
+    void refreshRulingQueue();
+    void updateSeatLabel();
+
+    SimulationCore m_core;
+    SimulationState &m_state;
+
+    EnvironmentGridWidget *m_grid = nullptr;
+    QTreeView *m_taskTree = nullptr;
+    AircraftTaskModel *m_taskModel = nullptr;
+    QListView *m_logView = nullptr;
+    LogListModel *m_logModel = nullptr;
+    QComboBox *m_modeCombo = nullptr;
+    QComboBox *m_ruleCombo = nullptr;
+    QComboBox *m_modelCombo = nullptr;
+    QComboBox *m_speedCombo = nullptr;
+    QLabel *m_timeLabel = nullptr;
+    QSlider *m_timelineSlider = nullptr;
+    QPushButton *m_startButton = nullptr;
+    QPushButton *m_pauseButton = nullptr;
+    QAction *m_journalAction = nullptr;
+    QAction *m_seatAction = nullptr;
+    QLabel *m_seatLabel = nullptr;
+    QTimer *m_timer = nullptr;
+    SimulationPacer m_pacer;
+
+    ManualRulingPanel *m_rulingPanel = nullptr;
+    SeatServer *m_seatServer = nullptr;
+};
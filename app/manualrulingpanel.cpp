@@ -0,0 +1,217 @@
+﻿#include "manualrulingpanel.h"
+
+#include <QComboBox>
+#include <QHash>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QVBoxLayout>
+
+#include <algorithm>
+
+namespace
+{
+enum Column
+{
+    AircraftColumn,
+    TaskColumn,
+    TimeColumn,
+    TargetColumn,
+    FireColumn,
+    HitColumn,
+    DetectColumn,
+    JamColumn,
+    ColumnCount
+};
+
+QTableWidgetItem *eventItem(bool required, bool checked)
+{
+    auto *item = new QTableWidgetItem();
+    if (!required)
+    {
+        item->setText(QStringLiteral("-"));
+        item->setFlags(Qt::NoItemFlags);
+        return item;
+    }
+    item->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsUserCheckable);
+    item->setCheckState(checked ? Qt::Checked : Qt::Unchecked);
+    return item;
+}
+
+QTableWidgetItem *textItem(const QString &text)
+{
+    auto *item = new QTableWidgetItem(text);
+    item->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable);
+    return item;
+}
+}
+
+ManualRulingPanel::ManualRulingPanel(QWidget *parent)
+    : QDockWidget(QStringLiteral("人工裁决队列"), parent)
+{
+    setObjectName(QStringLiteral("manualRulingPanel"));
+    auto *content = new QWidget(this);
+    auto *layout = new QVBoxLayout(content);
+    layout->setContentsMargins(6, 6, 6, 6);
+
+    auto *topRow = new QHBoxLayout();
+    topRow->addWidget(new QLabel(QStringLiteral("等待时:"), content));
+    m_policyCombo = new QComboBox(content);
+    m_policyCombo->addItem(QStringLiteral("仅暂停相关飞机"), int(ManualHoldPolicy::HoldAffected));
+    m_policyCombo->addItem(QStringLiteral("暂停全部仿真"), int(ManualHoldPolicy::HoldAll));
+    topRow->addWidget(m_policyCombo, 1);
+    m_countLabel = new QLabel(content);
+    topRow->addWidget(m_countLabel);
+    layout->addLayout(topRow);
+
+    connect(m_policyCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int index) {
+        if (m_core && index >= 0)
+        {
+            m_core->setManualHoldPolicy(ManualHoldPolicy(m_policyCombo->itemData(index).toInt()));
+            emit rulingsApplied();
+        }
+    });
+
+    m_table = new QTableWidget(content);
+    m_table->setColumnCount(ColumnCount);
+    m_table->setHorizontalHeaderLabels({QStringLiteral("飞机"), QStringLiteral("任务"), QStringLiteral("时间"),
+                                        QStringLiteral("目标"), QStringLiteral("允许开火"), QStringLiteral("命中"),
+                                        QStringLiteral("探测"), QStringLiteral("干扰")});
+    m_table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_table->verticalHeader()->setVisible(false);
+    m_table->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    m_table->horizontalHeader()->setStretchLastSection(true);
+    layout->addWidget(m_table, 1);
+
+    auto *buttonRow = new QHBoxLayout();
+    auto *submitSelectedBtn = new QPushButton(QStringLiteral("裁决选中"), content);
+    auto *submitAllBtn = new QPushButton(QStringLiteral("全部裁决"), content);
+    auto *cancelBtn = new QPushButton(QStringLiteral("取消选中"), content);
+    cancelBtn->setToolTip(QStringLiteral("取消裁决的任务判为失败"));
+    buttonRow->addWidget(submitSelectedBtn);
+    buttonRow->addWidget(submitAllBtn);
+    buttonRow->addStretch(1);
+    buttonRow->addWidget(cancelBtn);
+    layout->addLayout(buttonRow);
+
+    connect(submitSelectedBtn, &QPushButton::clicked, this, [this]() { submitRows(selectedRows()); });
+    connect(submitAllBtn, &QPushButton::clicked, this, [this]() { submitRows(allRows()); });
+    connect(cancelBtn, &QPushButton::clicked, this, [this]() { cancelRows(selectedRows()); });
+
+    setWidget(content);
+    refresh();
+}
+
+void ManualRulingPanel::setCore(SimulationCore *core)
+{
+    m_core = core;
+    if (m_core)
+    {
+        const int index = m_policyCombo->findData(int(m_core->manualHoldPolicy()));
+        m_policyCombo->blockSignals(true);
+        m_policyCombo->setCurrentIndex(index);
+        m_policyCombo->blockSignals(false);
+    }
+    m_pending.clear();
+    m_table->setRowCount(0);
+    refresh();
+}
+
+void ManualRulingPanel::refresh()
+{
+    const QVector<TaskRef> pending = m_core ? m_core->pendingRulings() : QVector<TaskRef>();
+    const bool unchanged = pending.size() == m_pending.size()
+                           && std::equal(pending.cbegin(), pending.cend(), m_pending.cbegin(),
+                                         [](const TaskRef &a, const TaskRef &b) { return a.key() == b.key(); });
+    m_countLabel->setText(QStringLiteral("待裁决 %1 项").arg(pending.size()));
+    if (unchanged)
+        return;
+
+    QHash<quint64, ManualAdjudicationState> ticked;
+    for (int row = 0; row < m_pending.size(); ++row)
+    {
+        ticked.insert(m_pending.at(row).key(), rowRuling(row));
+    }
+
+    m_pending = pending;
+    m_table->setRowCount(m_pending.size());
+    const SimulationState &state = m_core->state();
+    for (int row = 0; row < m_pending.size(); ++row)
+    {
+        const TaskRef &ref = m_pending.at(row);
+        const Task task = state.tasks.task(state.aircrafts.firstTask(ref.aircraft) + ref.task);
+        const ManualAdjudicationState ruling = ticked.value(ref.key(), ManualAdjudicationState());
+        m_table->setItem(row, AircraftColumn, textItem(state.aircrafts.name(ref.aircraft)));
+        m_table->setItem(row, TaskColumn, textItem(task.name));
+        m_table->setItem(row, TimeColumn, textItem(QStringLiteral("%1 s").arg(task.executionTime)));
+        m_table->setItem(row, TargetColumn, textItem(QStringLiteral("(%1, %2)").arg(task.targetCell.x()).arg(task.targetCell.y())));
+        m_table->setItem(row, FireColumn, eventItem(task.requiresFire, ruling.fireAllowed));
+        m_table->setItem(row, HitColumn, eventItem(task.requiresHit, ruling.fireHit));
+        m_table->setItem(row, DetectColumn, eventItem(task.requiresDetection, ruling.detectionSuccess));
+        m_table->setItem(row, JamColumn, eventItem(task.requiresJam, ruling.jamSuccess));
+    }
+}
+
+void ManualRulingPanel::submitRows(const QList<int> &rows)
+{
+    if (!m_core || rows.isEmpty())
+        return;
+    for (int row : rows)
+    {
+        m_core->submitRuling(m_pending.at(row), rowRuling(row));
+    }
+    refresh();
+    emit rulingsApplied();
+}
+
+void ManualRulingPanel::cancelRows(const QList<int> &rows)
+{
+    if (!m_core || rows.isEmpty())
+        return;
+    for (int row : rows)
+    {
+        m_core->cancelRuling(m_pending.at(row));
+    }
+    refresh();
+    emit rulingsApplied();
+}
+
+QList<int> ManualRulingPanel::selectedRows() const
+{
+    QList<int> rows;
+    for (const QModelIndex &index : m_table->selectionModel()->selectedRows())
+    {
+        rows.append(index.row());
+    }
+    std::sort(rows.begin(), rows.end());
+    return rows;
+}
+
+QList<int> ManualRulingPanel::allRows() const
+{
+    QList<int> rows;
+    for (int row = 0; row < m_pending.size(); ++row)
+    {
+        rows.append(row);
+    }
+    return rows;
+}
+
+ManualAdjudicationState ManualRulingPanel::rowRuling(int row) const
+{
+    // Events the task does not require keep their defaults; the engine ignores them.
+    auto checked = [this, row](int column, bool fallback) {
+        const QTableWidgetItem *item = m_table->item(row, column);
+        return item && (item->flags() & Qt::ItemIsUserCheckable) ? item->checkState() == Qt::Checked : fallback;
+    };
+    const ManualAdjudicationState defaults;
+    ManualAdjudicationState ruling;
+    ruling.fireAllowed = checked(FireColumn, defaults.fireAllowed);
+    ruling.fireHit = checked(HitColumn, defaults.fireHit);
+    ruling.detectionSuccess = checked(DetectColumn, defaults.detectionSuccess);
+    ruling.jamSuccess = checked(JamColumn, defaults.jamSuccess);
+    return ruling;
+}
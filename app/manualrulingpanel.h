@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QDockWidget>
+#include <QList>
+#include <QVector>
+
+#include "simulationcore.h"
+
+class QComboBox;
+class QLabel;
+class QTableWidget;
+
+// Dockable queue of tasks awaiting a manual ruling. The adjudicator ticks
+// the outcome of each required event and rules any number of queued tasks
+// in one pass while the simulation runs on under the chosen hold policy.
+class ManualRulingPanel : public QDockWidget
+{
+    Q_OBJECT
+public:
+    explicit ManualRulingPanel(QWidget *parent = nullptr);
+
+    void setCore(SimulationCore *core);
+    // Re-reads the queue; ticks on rows that are still queued are kept.
+    void refresh();
+
+signals:
+    // Rulings were given or cancelled; task and log views should update.
+    void rulingsApplied();
+
+private:
+    void submitRows(const QList<int> &rows);
+    void cancelRows(const QList<int> &rows);
+    QList<int> selectedRows() const;
+    QList<int> allRows() const;
+    ManualAdjudicationState rowRuling(int row) const;
+
+    SimulationCore *m_core = nullptr;
+    QComboBox *m_policyCombo = nullptr;
+    QLabel *m_countLabel = nullptr;
+    QTableWidget *m_table = nullptr;
+    QVector<TaskRef> m_pending; // one per table row
+};
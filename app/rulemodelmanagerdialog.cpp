@@ -1,4 +1,5 @@
 ﻿#include "rulemodelmanagerdialog.h"
+#include "adjudicationengine.h"
 
 #include <QVBoxLayout>
 #include <QHBoxLayout>
@@ -11,6 +12,7 @@
 #include <QDialogButtonBox>
 #include <QCheckBox>
 #include <QLabel>
+#include <QPlainTextEdit>
 #include <QMessageBox>
 
 RuleModelManagerDialog::RuleModelManagerDialog(QWidget *parent)
@@ -29,7 +31,7 @@ RuleModelManagerDialog::RuleModelManagerDialog(QWidget *parent)
     setupModelPanel(modelPanel);
 }
 
-void RuleModelManagerDialog::setData(QVector<AdjudicationRule> *rules, QVector<AdjudicationModel> *models)
+void RuleModelManagerDialog::setData(Catalog<AdjudicationRule> *rules, Catalog<AdjudicationModel> *models)
 {
     m_rules = rules;
     m_models = models;
@@ -43,8 +45,8 @@ void RuleModelManagerDialog::setupRulePanel(QWidget *parent)
     layout->addWidget(new QLabel(QStringLiteral("裁决规则"), parent));
 
     m_ruleTable = new QTableWidget(parent);
-    m_ruleTable->setColumnCount(3);
-    m_ruleTable->setHorizontalHeaderLabels({QStringLiteral("名称"), QStringLiteral("阈值"), QStringLiteral("权重")});
+    m_ruleTable->setColumnCount(4);
+    m_ruleTable->setHorizontalHeaderLabels({QStringLiteral("名称"), QStringLiteral("阈值"), QStringLiteral("权重"), QStringLiteral("得分表达式")});
     m_ruleTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
     m_ruleTable->setSelectionBehavior(QAbstractItemView::SelectRows);
     m_ruleTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
@@ -110,6 +112,7 @@ void RuleModelManagerDialog::refreshRuleTable()
             weights << QStringLiteral("%1:%2").arg(it.key()).arg(it.value());
         }
         m_ruleTable->setItem(row, 2, new QTableWidgetItem(weights.join(QLatin1Char(','))));
+        m_ruleTable->setItem(row, 3, new QTableWidgetItem(rule.expression.isEmpty() ? QStringLiteral("(权重求和)") : rule.expression));
     }
 }
 
@@ -233,25 +236,49 @@ bool RuleModelManagerDialog::editRule(AdjudicationRule &rule, bool isNew)
     weightEdit->setText(weightParts.join(QLatin1Char(',')));
     layout->addRow(QStringLiteral("行为权重"), weightEdit);
 
+    auto *expressionEdit = new QPlainTextEdit(rule.expression, &dialog);
+    expressionEdit->setPlaceholderText(QStringLiteral("留空则按成功行为的权重求和，例如:\n"
+                                                      "fire * w_fire + hit * w_hit * (detect && emInterference < 30 ? 2 : 1)"));
+    expressionEdit->setMinimumWidth(420);
+    expressionEdit->setFixedHeight(80);
+    layout->addRow(QStringLiteral("得分表达式"), expressionEdit);
+
+    auto *help = new QLabel(QStringLiteral("变量: %1\n权重: w_<行为>   函数: min max abs clamp if   运算: + - * / < <= > >= == != && || ! ?:")
+                                .arg(RuleProgram::inputNames().join(QLatin1Char(' '))),
+                            &dialog);
+    help->setWordWrap(true);
+    layout->addRow(help);
+
     auto *buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
     layout->addRow(buttons);
     QObject::connect(buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
     QObject::connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
 
-    if (dialog.exec() == QDialog::Accepted)
+    while (dialog.exec() == QDialog::Accepted)
     {
-        rule.name = nameEdit->text();
-        rule.successThreshold = thresholdSpin->value();
-        rule.behaviorWeights.clear();
+        AdjudicationRule edited = rule;
+        edited.name = nameEdit->text();
+        edited.successThreshold = thresholdSpin->value();
+        edited.behaviorWeights.clear();
         const QStringList entries = weightEdit->text().split(',', Qt::SkipEmptyParts);
         for (const QString &entry : entries)
         {
             const QStringList kv = entry.split(':');
             if (kv.size() == 2)
             {
-                rule.behaviorWeights.insert(kv.at(0).trimmed(), kv.at(1).trimmed().toInt());
+                edited.behaviorWeights.insert(kv.at(0).trimmed(), kv.at(1).trimmed().toInt());
             }
         }
+        edited.expression = expressionEdit->toPlainText().trimmed();
+
+        QString error;
+        if (!AdjudicationEngine::compileRule(edited, &error))
+        {
+            QMessageBox::warning(&dialog, QStringLiteral("得分表达式错误"), error);
+            continue;
+        }
+
+        rule = edited;
         return true;
     }
     return false;
@@ -281,15 +308,26 @@ bool RuleModelManagerDialog::editModel(AdjudicationModel &model, bool isNew)
     QObject::connect(buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
     QObject::connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
 
-    if (dialog.exec() == QDialog::Accepted)
+    while (dialog.exec() == QDialog::Accepted)
     {
-        model.name = nameEdit->text();
-        model.factorKeys = factorsEdit->text().split(',', Qt::SkipEmptyParts);
-        for (QString &key : model.factorKeys)
+        AdjudicationModel edited = model;
+        edited.name = nameEdit->text();
+        edited.factorKeys = factorsEdit->text().split(',', Qt::SkipEmptyParts);
+        for (QString &key : edited.factorKeys)
         {
             key = key.trimmed();
         }
-        model.environmentWeight = weightSpin->value();
+        edited.environmentWeight = weightSpin->value();
+
+        QString error;
+        if (!AdjudicationEngine::compileModel(edited, &error))
+        {
+            QMessageBox::warning(&dialog, QStringLiteral("环境因子错误"),
+                                 QStringLiteral("%1\n可用因子: %2").arg(error, AdjudicationEngine::factorKeyNames().join(QLatin1Char(','))));
+            continue;
+        }
+
+        model = edited;
         return true;
     }
     return false;
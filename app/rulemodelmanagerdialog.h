@@ -13,7 +13,8 @@ class RuleModelManagerDialog : public QDialog
 public:
     explicit RuleModelManagerDialog(QWidget *parent = nullptr);
 
-    void setData(QVector<AdjudicationRule> *rules, QVector<AdjudicationModel> *models);
+    // Edits keep each item's id, so tasks referring to a renamed rule keep it.
+    void setData(Catalog<AdjudicationRule> *rules, Catalog<AdjudicationModel> *models);
 
 private:
     void setupRulePanel(QWidget *parent);
@@ -33,8 +34,8 @@ private:
     bool editRule(AdjudicationRule &rule, bool isNew);
     bool editModel(AdjudicationModel &model, bool isNew);
 
-    QVector<AdjudicationRule> *m_rules = nullptr;
-    QVector<AdjudicationModel> *m_models = nullptr;
+    Catalog<AdjudicationRule> *m_rules = nullptr;
+    Catalog<AdjudicationModel> *m_models = nullptr;
 
     QTableWidget *m_ruleTable = nullptr;
     QTableWidget *m_modelTable = nullptr;
@@ -1,5 +1,5 @@
 ﻿#include "taskmanagerdialog.h"
-#include "environmentgridwidget.h"
+#include "aircrafttaskmodel.h"
 
 #include <QComboBox>
 #include <QPlainTextEdit>
@@ -102,50 +102,56 @@ TaskManagerDialog::TaskManagerDialog(QWidget *parent)
     mainLayout->addWidget(closeButtons);
 }
 
-void TaskManagerDialog::setAircrafts(QVector<Aircraft> *aircrafts)
+void TaskManagerDialog::setModel(AircraftTaskModel *model)
 {
-    m_aircrafts = aircrafts;
+    m_model = model;
     refreshAircraftCombo();
 }
 
-void TaskManagerDialog::setAvailableRuleNames(const QStringList &rules)
+void TaskManagerDialog::setRules(const Catalog<AdjudicationRule> *rules)
 {
-    m_ruleNames = rules;
+    m_rules = rules;
+}
+
+void TaskManagerDialog::setGridSize(const QSize &size)
+{
+    m_gridSize = size;
 }
 
 void TaskManagerDialog::refreshAircraftCombo()
 {
     m_aircraftCombo->blockSignals(true);
     m_aircraftCombo->clear();
-    if (m_aircrafts)
+    if (m_model && m_model->aircrafts())
     {
-        for (const Aircraft &ac : *m_aircrafts)
+        const AircraftStore &aircrafts = *m_model->aircrafts();
+        for (int a = 0; a < aircrafts.size(); ++a)
         {
-            m_aircraftCombo->addItem(ac.name);
+            m_aircraftCombo->addItem(aircrafts.name(a));
         }
     }
     m_aircraftCombo->blockSignals(false);
     loadCurrentAircraft();
 }
 
-Aircraft *TaskManagerDialog::currentAircraft()
+int TaskManagerDialog::currentAircraft() const
 {
-    if (!m_aircrafts)
+    if (!m_model || !m_model->aircrafts())
     {
-        return nullptr;
+        return -1;
     }
     const int idx = m_aircraftCombo->currentIndex();
-    if (idx < 0 || idx >= m_aircrafts->size())
+    if (idx < 0 || idx >= m_model->aircrafts()->size())
     {
-        return nullptr;
+        return -1;
     }
-    return &(*m_aircrafts)[idx];
+    return idx;
 }
 
 void TaskManagerDialog::loadCurrentAircraft()
 {
-    Aircraft *ac = currentAircraft();
-    if (!ac)
+    const int aircraft = currentAircraft();
+    if (aircraft < 0)
     {
         m_routeEdit->clear();
         m_speedSpin->setValue(1.0);
@@ -153,22 +159,25 @@ void TaskManagerDialog::loadCurrentAircraft()
         return;
     }
 
+    const AircraftStore &aircrafts = *m_model->aircrafts();
+    const QPoint *route = aircrafts.route(aircraft);
     QStringList lines;
-    for (const QPoint &pt : ac->route)
+    for (int p = 0; p < aircrafts.routeLength(aircraft); ++p)
     {
-        lines << QStringLiteral("%1,%2").arg(pt.x()).arg(pt.y());
+        lines << QStringLiteral("%1,%2").arg(route[p].x()).arg(route[p].y());
     }
     m_routeEdit->setPlainText(lines.join(QLatin1Char('\n')));
-    m_speedSpin->setValue(ac->secondsPerStep);
-    populateTaskTable(*ac);
+    m_speedSpin->setValue(aircrafts.secondsPerStep(aircraft));
+    populateTaskTable(aircraft);
 }
 
-void TaskManagerDialog::populateTaskTable(const Aircraft &aircraft)
+void TaskManagerDialog::populateTaskTable(int aircraft)
 {
-    m_taskTable->setRowCount(aircraft.tasks.size());
-    for (int row = 0; row < aircraft.tasks.size(); ++row)
+    const int count = m_model->taskCount(aircraft);
+    m_taskTable->setRowCount(count);
+    for (int row = 0; row < count; ++row)
     {
-        const Task &task = aircraft.tasks.at(row);
+        const Task task = m_model->task(aircraft, row);
         auto setItem = [&](int column, const QString &text) {
             auto *item = new QTableWidgetItem(text);
             item->setData(Qt::UserRole, row);
@@ -178,15 +187,16 @@ void TaskManagerDialog::populateTaskTable(const Aircraft &aircraft)
         setItem(1, QString::number(task.executionTime));
         setItem(2, QStringLiteral("(%1,%2)").arg(task.targetCell.x()).arg(task.targetCell.y()));
         setItem(3, taskRequirementText(task));
-        setItem(4, task.ruleName);
+        const AdjudicationRule *rule = m_rules ? m_rules->find(task.ruleId) : nullptr;
+        setItem(4, rule ? rule->name : QStringLiteral("(当前规则)"));
         setItem(5, task.statusText());
     }
 }
 
 void TaskManagerDialog::applyRouteChanges()
 {
-    Aircraft *ac = currentAircraft();
-    if (!ac)
+    const int aircraft = currentAircraft();
+    if (aircraft < 0)
     {
         return;
     }
@@ -206,9 +216,10 @@ void TaskManagerDialog::applyRouteChanges()
         bool okY = false;
         int x = parts.at(0).trimmed().toInt(&okX);
         int y = parts.at(1).trimmed().toInt(&okY);
-        if (!okX || !okY || x < 0 || x >= EnvironmentGridWidget::GridSize || y < 0 || y >= EnvironmentGridWidget::GridSize)
+        if (!okX || !okY || x < 0 || x >= m_gridSize.width() || y < 0 || y >= m_gridSize.height())
         {
-            QMessageBox::warning(this, QStringLiteral("范围错误"), QStringLiteral("坐标需在 0-%1 之间").arg(EnvironmentGridWidget::GridSize - 1));
+            QMessageBox::warning(this, QStringLiteral("范围错误"),
+                                 QStringLiteral("坐标需在 x: 0-%1, y: 0-%2 之间").arg(m_gridSize.width() - 1).arg(m_gridSize.height() - 1));
             return;
         }
         newRoute.append(QPoint(x, y));
@@ -216,47 +227,46 @@ void TaskManagerDialog::applyRouteChanges()
 
     if (!newRoute.isEmpty())
     {
-        ac->route = newRoute;
-        ac->currentRouteIndex = 0;
-        ac->stepAccumulator = 0.0;
+        m_model->setRoute(aircraft, newRoute);
     }
 }
 
 void TaskManagerDialog::applySpeedChanges()
 {
-    Aircraft *ac = currentAircraft();
-    if (!ac)
+    const int aircraft = currentAircraft();
+    if (aircraft < 0)
     {
         return;
     }
-    ac->secondsPerStep = m_speedSpin->value();
+    m_model->setSecondsPerStep(aircraft, m_speedSpin->value());
 }
 
-Task *TaskManagerDialog::taskFromRow(int row)
+bool TaskManagerDialog::taskFromRow(int row, Task *task) const
 {
-    Aircraft *ac = currentAircraft();
-    if (!ac || row < 0 || row >= ac->tasks.size())
+    const int aircraft = currentAircraft();
+    if (aircraft < 0 || row < 0 || row >= m_model->taskCount(aircraft))
     {
-        return nullptr;
+        return false;
     }
-    return &ac->tasks[row];
+    *task = m_model->task(aircraft, row);
+    return true;
 }
 
 void TaskManagerDialog::addTask()
 {
-    Aircraft *ac = currentAircraft();
-    if (!ac)
+    const int aircraft = currentAircraft();
+    if (aircraft < 0)
     {
         return;
     }
 
     Task task;
-    task.name = QStringLiteral("新任务%1").arg(ac->tasks.size() + 1);
-    task.ruleName = !m_ruleNames.isEmpty() ? m_ruleNames.first() : QString();
+    task.name = QStringLiteral("新任务%1").arg(m_model->taskCount(aircraft) + 1);
+    task.ruleId = m_rules && !m_rules->isEmpty() ? m_rules->first().id : NoId;
     if (editTask(task, true))
     {
-        ac->tasks.append(task);
-        populateTaskTable(*ac);
+        m_model->insertTask(aircraft, task);
+        populateTaskTable(aircraft);
     }
 }
 
@@ -268,25 +278,25 @@ void TaskManagerDialog::editSelectedTask()
         return;
     }
     const int row = item->row();
-    Task *task = taskFromRow(row);
-    if (!task)
+    Task copy;
+    if (!taskFromRow(row, &copy))
     {
         return;
     }
 
-    Task copy = *task;
     if (editTask(copy, false))
     {
-        *task = copy;
-        task->status = TaskStatus::Pending;
-        populateTaskTable(*currentAircraft());
+        copy.status = TaskStatus::Pending;
+        const int aircraft = currentAircraft();
+        m_model->setTask(aircraft, row, copy);
+        populateTaskTable(aircraft);
     }
 }
 
 void TaskManagerDialog::removeSelectedTask()
 {
-    Aircraft *ac = currentAircraft();
-    if (!ac)
+    const int aircraft = currentAircraft();
+    if (aircraft < 0)
     {
         return;
     }
@@ -296,12 +306,12 @@ void TaskManagerDialog::removeSelectedTask()
         return;
     }
     const int row = item->row();
-    if (row < 0 || row >= ac->tasks.size())
+    if (row < 0 || row >= m_model->taskCount(aircraft))
     {
         return;
     }
-    ac->tasks.removeAt(row);
-    populateTaskTable(*ac);
+    m_model->removeTask(aircraft, row);
+    populateTaskTable(aircraft);
 }
 
 bool TaskManagerDialog::editTask(Task &task, bool isNew)
@@ -322,10 +332,10 @@ bool TaskManagerDialog::editTask(Task &task, bool isNew)
     auto *targetLayout = new QHBoxLayout(targetRow);
     targetLayout->setContentsMargins(0, 0, 0, 0);
     auto *xSpin = new QSpinBox(&dialog);
-    xSpin->setRange(0, EnvironmentGridWidget::GridSize - 1);
+    xSpin->setRange(0, m_gridSize.width() - 1);
     xSpin->setValue(task.targetCell.x());
     auto *ySpin = new QSpinBox(&dialog);
-    ySpin->setRange(0, EnvironmentGridWidget::GridSize - 1);
+    ySpin->setRange(0, m_gridSize.height() - 1);
     ySpin->setValue(task.targetCell.y());
     targetLayout->addWidget(new QLabel("X", &dialog));
     targetLayout->addWidget(xSpin);
@@ -348,12 +358,16 @@ bool TaskManagerDialog::editTask(Task &task, bool isNew)
     layout->addRow(jamCheck);
 
     auto *ruleCombo = new QComboBox(&dialog);
-    ruleCombo->addItems(m_ruleNames);
-    int ruleIndex = m_ruleNames.indexOf(task.ruleName);
-    if (ruleIndex >= 0)
+    ruleCombo->addItem(QStringLiteral("(当前规则)"), NoId);
+    if (m_rules)
     {
-        ruleCombo->setCurrentIndex(ruleIndex);
+        for (const AdjudicationRule &rule : *m_rules)
+        {
+            ruleCombo->addItem(rule.name, rule.id);
+        }
     }
+    const int ruleIndex = ruleCombo->findData(task.ruleId);
+    ruleCombo->setCurrentIndex(ruleIndex >= 0 ? ruleIndex : 0);
     layout->addRow(QStringLiteral("裁决规则"), ruleCombo);
 
     auto *buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
@@ -371,7 +385,7 @@ bool TaskManagerDialog::editTask(Task &task, bool isNew)
         task.requiresHit = hitCheck->isChecked();
         task.requiresDetection = detectCheck->isChecked();
         task.requiresJam = jamCheck->isChecked();
-        task.ruleName = ruleCombo->currentText();
+        task.ruleId = ruleCombo->currentData().toUInt();
         task.status = TaskStatus::Pending;
         return true;
     }
@@ -10,6 +10,7 @@ class QComboBox;
 class QTableWidget;
 class QPlainTextEdit;
 class QDoubleSpinBox;
+class AircraftTaskModel;
 
 class TaskManagerDialog : public QDialog
 {
@@ -17,16 +18,20 @@ class TaskManagerDialog : public QDialog
 public:
     explicit TaskManagerDialog(QWidget *parent = nullptr);
 
-    void setAircrafts(QVector<Aircraft> *aircrafts);
-    void setAvailableRuleNames(const QStringList &rules);
+    // Edits are applied through the model so the main task tree updates in place.
+    void setModel(AircraftTaskModel *model);
+    // Rules offered for tasks; tasks store the rule id, so renames carry over.
+    void setRules(const Catalog<AdjudicationRule> *rules);
+    // Map dimensions used to validate waypoints and target cells.
+    void setGridSize(const QSize &size);
 
 private:
     void refreshAircraftCombo();
     void loadCurrentAircraft();
-    Aircraft *currentAircraft();
-    Task *taskFromRow(int row);
-    void populateTaskTable(const Aircraft &aircraft);
-    void populateRouteEditor(const Aircraft &aircraft);
+    // Index of the selected aircraft, or -1.
+    int currentAircraft() const;
+    bool taskFromRow(int row, Task *task) const;
+    void populateTaskTable(int aircraft);
     void applyRouteChanges();
     void applySpeedChanges();
 
@@ -35,8 +40,9 @@ private:
     void editSelectedTask();
     void removeSelectedTask();
 
-    QVector<Aircraft> *m_aircrafts = nullptr;
-    QStringList m_ruleNames;
+    AircraftTaskModel *m_model = nullptr;
+    const Catalog<AdjudicationRule> *m_rules = nullptr;
+    QSize m_gridSize{DefaultGridSize, DefaultGridSize};
 
     QComboBox *m_aircraftCombo = nullptr;
     QPlainTextEdit *m_routeEdit = nullptr;
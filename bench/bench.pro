@@ -0,0 +1,19 @@
+QT += core
+QT -= gui
+CONFIG += c++17 console
+CONFIG -= app_bundle
+TEMPLATE = app
+TARGET = ruling_bench
+
+include(../core/core.pri)
+
+SOURCES += \
+    main.cpp \
+    factorkernelsbench.cpp \
+    entitystorebench.cpp \
+    seatloadbench.cpp \
+    resultchannelbench.cpp \
+    workstealingpoolbench.cpp
+
+HEADERS += \
+    benchmarks.h
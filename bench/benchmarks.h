@@ -0,0 +1,28 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QTextStream>
+
+// Best of several runs, in milliseconds.
+template <typename Fn>
+double timeBest(Fn &&fn, int runs = 5)
+{
+    double best = 0.0;
+    for (int r = 0; r < runs; ++r)
+    {
+        QElapsedTimer timer;
+        timer.start();
+        fn();
+        const double ms = timer.nsecsElapsed() / 1e6;
+        if (r == 0 || ms < best)
+            best = ms;
+    }
+    return best;
+}
+
+// Each benchmark prints a small table to `out` and returns 0 on success.
+int runFactorKernelsBenchmark(QTextStream &out, int gridSize);
+int runEntityStoreBenchmark(QTextStream &out);
+int runSeatLoadBenchmark(QTextStream &out);
+int runResultChannelBenchmark(QTextStream &out);
+int runWorkStealingPoolBenchmark(QTextStream &out);
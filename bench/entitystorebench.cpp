@@ -0,0 +1,115 @@
+﻿#include "benchmarks.h"
+#include "simulationcore.h"
+
+#include <random>
+
+namespace
+{
+constexpr int kWaypoints = 64;
+constexpr int kTicks = 100;
+constexpr double kTickSeconds = 0.05;
+
+// The array-of-structs layout the store replaced: every aircraft owns its
+// route, so the motion sweep strides over names and route headers.
+struct AircraftRecord
+{
+    QString name;
+    QVector<QPoint> route;
+    int firstTask = 0;
+    int taskCount = 0;
+    int currentRouteIndex = 0;
+    double secondsPerStep = 1.0;
+    double stepAccumulator = 0.0;
+};
+
+void advanceRecords(QVector<AircraftRecord> &records, double seconds)
+{
+    for (AircraftRecord &ac : records)
+    {
+        if (ac.route.size() < 2)
+            continue;
+        ac.stepAccumulator += seconds;
+        while (ac.stepAccumulator >= ac.secondsPerStep && ac.currentRouteIndex + 1 < ac.route.size())
+        {
+            ac.stepAccumulator -= ac.secondsPerStep;
+            ++ac.currentRouteIndex;
+        }
+    }
+}
+
+Aircraft randomAircraft(std::mt19937 &rng, int index)
+{
+    std::uniform_int_distribution<int> cell(0, DefaultGridSize - 1);
+    std::uniform_real_distribution<double> speed(0.5, 3.0);
+    Aircraft ac;
+    ac.name = QStringLiteral("AC-%1").arg(index);
+    ac.secondsPerStep = speed(rng);
+    ac.route.reserve(kWaypoints);
+    for (int p = 0; p < kWaypoints; ++p)
+    {
+        ac.route.append(QPoint(cell(rng), cell(rng)));
+    }
+    return ac;
+}
+}
+
+int runEntityStoreBenchmark(QTextStream &out)
+{
+    out << "aircraft motion, " << kTicks << " ticks of " << kTickSeconds << "s, " << kWaypoints << " waypoints each\n";
+    out << "aircraft  layout    us/tick   ns/aircraft  nextEvent us  remove+add ns\n";
+
+    for (int count : {1000, 10000, 100000})
+    {
+        std::mt19937 rng(1);
+        SimulationCore core;
+        core.setLoggingEnabled(false);
+        AircraftStore &store = core.state().aircrafts;
+        QVector<AircraftRecord> records;
+        store.reserve(count, count * kWaypoints);
+        records.reserve(count);
+        for (int i = 0; i < count; ++i)
+        {
+            const Aircraft ac = randomAircraft(rng, i);
+            store.add(ac);
+            AircraftRecord record;
+            record.name = ac.name;
+            record.route = ac.route;
+            record.secondsPerStep = ac.secondsPerStep;
+            records.append(record);
+        }
+        core.reset();
+
+        const double recordMs = timeBest([&] {
+            for (int t = 0; t < kTicks; ++t)
+                advanceRecords(records, kTickSeconds);
+        });
+        const double storeMs = timeBest([&] {
+            for (int t = 0; t < kTicks; ++t)
+                core.step(kTickSeconds);
+        });
+        volatile double sink = 0.0;
+        const double nextMs = timeBest([&] { sink = sink + core.nextEventTime(); });
+
+        // Swap-remove a random aircraft and add a fresh one, count times.
+        const Aircraft spare = randomAircraft(rng, count);
+        std::uniform_int_distribution<int> pick(0, count - 1);
+        const double churnMs = timeBest([&] {
+            for (int i = 0; i < count; ++i)
+            {
+                store.removeAt(pick(rng));
+                store.add(spare);
+            }
+        }, 1);
+
+        auto row = [&](const char *layout, double ms, const QString &next, const QString &churn) {
+            out << QString::number(count).leftJustified(10) << QString::fromLatin1(layout).leftJustified(10)
+                << QString::number(ms * 1000.0 / kTicks, 'f', 1).leftJustified(10)
+                << QString::number(ms * 1e6 / kTicks / count, 'f', 2).leftJustified(13)
+                << next.leftJustified(14) << churn << '\n';
+        };
+        row("records", recordMs, QStringLiteral("-"), QStringLiteral("-"));
+        row("store", storeMs, QString::number(nextMs * 1000.0, 'f', 1), QString::number(churnMs * 1e6 / count, 'f', 1));
+    }
+    out.flush();
+    return 0;
+}
@@ -0,0 +1,93 @@
+﻿#include "benchmarks.h"
+#include "factorkernels.h"
+
+#include <cstring>
+#include <functional>
+#include <random>
+#include <vector>
+
+int runFactorKernelsBenchmark(QTextStream &out, int gridSize)
+{
+    using namespace FactorKernels;
+
+    const qint64 cells = qint64(gridSize) * gridSize;
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> value(0, 100);
+    std::vector<quint8> storage[EnvironmentFactorCount];
+    const quint8 *planes[EnvironmentFactorCount];
+    for (int f = 0; f < EnvironmentFactorCount; ++f)
+    {
+        storage[f].resize(size_t(cells));
+        for (quint8 &v : storage[f])
+        {
+            v = quint8(value(rng));
+        }
+        planes[f] = storage[f].data();
+    }
+
+    std::vector<quint16> sums(size_t(cells));
+    std::vector<qint32> weighted(size_t(cells));
+    std::vector<quint8> mask(size_t(cells));
+    const std::array<int, EnvironmentFactorCount> weights{1, 1, 1, 0, 0};
+    const Predicate predicates[] = {
+        {EnvironmentFactor::Humidity, Compare::Less, 70},
+        {EnvironmentFactor::EmInterference, Compare::Less, 40},
+    };
+
+    out << "factor kernels, " << gridSize << "x" << gridSize << " grid (" << cells << " cells), detected "
+        << isaName(detectedIsa()) << '\n';
+    out << "kernel            isa      ms      Mcells/s  speedup\n";
+
+    struct Kernel
+    {
+        const char *name;
+        std::function<void()> run;
+        void *output; // compared byte for byte with the scalar result
+        size_t bytes;
+    };
+    const Kernel kernels[] = {
+        {"factorSum", [&] { factorSum(planes, sums.data(), cells); }, sums.data(), sums.size() * sizeof(quint16)},
+        {"weightedSum", [&] { weightedSum(planes, weights, weighted.data(), cells); }, weighted.data(),
+         weighted.size() * sizeof(qint32)},
+        {"feasibilityMask", [&] { feasibilityMask(planes, predicates, 2, mask.data(), cells); }, mask.data(), mask.size()},
+    };
+
+    const Isa previous = activeIsa();
+    int status = 0;
+    std::vector<char> reference;
+    for (const Kernel &kernel : kernels)
+    {
+        double scalarMs = 0.0;
+        for (Isa isa : {Isa::Scalar, Isa::Sse2, Isa::Avx2})
+        {
+            if (int(isa) > int(detectedIsa()))
+                continue;
+            setIsa(isa);
+            // Poison the output so a path that writes nothing cannot match.
+            std::memset(kernel.output, 0xa5, kernel.bytes);
+            const double ms = timeBest(kernel.run);
+            bool matches = true;
+            if (isa == Isa::Scalar)
+            {
+                scalarMs = ms;
+                const char *bytes = static_cast<const char *>(kernel.output);
+                reference.assign(bytes, bytes + kernel.bytes);
+            }
+            else
+            {
+                matches = std::memcmp(kernel.output, reference.data(), kernel.bytes) == 0;
+            }
+            out << QString::fromLatin1(kernel.name).leftJustified(18)
+                << QString::fromLatin1(isaName(isa)).leftJustified(9)
+                << QString::number(ms, 'f', 2).leftJustified(8)
+                << QString::number(cells / ms / 1000.0, 'f', 0).leftJustified(10)
+                << QString::number(scalarMs / ms, 'f', 2) << "x"
+                << (matches ? "" : "  MISMATCH with scalar") << '\n';
+            if (!matches)
+                status = 1;
+        }
+    }
+    setIsa(previous);
+    out.flush();
+    return status;
+}
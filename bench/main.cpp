@@ -0,0 +1,50 @@
+﻿#include "benchmarks.h"
+#include "environmentfield.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("ruling_bench"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Micro-benchmarks for the simulation core."));
+    parser.addHelpOption();
+    parser.addPositionalArgument(QStringLiteral("benchmark"), QStringLiteral("Benchmark to run: kernels, entities, seats, results, pool (default all)."));
+    QCommandLineOption gridOption(QStringList{QStringLiteral("g"), QStringLiteral("grid-size")},
+                                  QStringLiteral("Grid side for the kernel benchmark (default 4096)."),
+                                  QStringLiteral("cells"),
+                                  QStringLiteral("4096"));
+    parser.addOption(gridOption);
+    parser.process(app);
+
+    const QStringList selected = parser.positionalArguments();
+    auto wanted = [&](const QString &name) { return selected.isEmpty() || selected.contains(name); };
+
+    QTextStream out(stdout);
+    int status = 0;
+    if (wanted(QStringLiteral("kernels")))
+    {
+        const int grid = qBound(1, parser.value(gridOption).toInt(), MaxGridSize);
+        status |= runFactorKernelsBenchmark(out, grid);
+    }
+    if (wanted(QStringLiteral("entities")))
+    {
+        status |= runEntityStoreBenchmark(out);
+    }
+    if (wanted(QStringLiteral("seats")))
+    {
+        status |= runSeatLoadBenchmark(out);
+    }
+    if (wanted(QStringLiteral("results")))
+    {
+        status |= runResultChannelBenchmark(out);
+    }
+    if (wanted(QStringLiteral("pool")))
+    {
+        status |= runWorkStealingPoolBenchmark(out);
+    }
+    return status;
+}
@@ -0,0 +1,199 @@
+﻿#include "benchmarks.h"
+#include "resultchannel.h"
+#include "simulationcore.h"
+
+#include <QCoreApplication>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+constexpr int kRecords = 2000000;
+constexpr int kReadBatch = 256;
+constexpr int kAircraft = 1000;
+constexpr int kTasksPerAircraft = 100;
+constexpr int kDuration = 3600;
+
+qint64 nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+struct ReaderResult
+{
+    qint64 read = 0;
+    quint64 dropped = 0;
+    double latencyNs = 0.0; // summed
+    double maxLatencyNs = 0.0;
+};
+
+// Tails the channel until the publisher closes; `time` carries the publish timestamp.
+void tail(const QString &name, std::atomic<int> *attached, ReaderResult *result)
+{
+    ResultSubscriber subscriber;
+    if (!subscriber.attach(name))
+    {
+        attached->fetch_add(1);
+        return;
+    }
+    attached->fetch_add(1);
+
+    std::vector<ResultRecord> records(kReadBatch);
+    for (;;)
+    {
+        const bool open = subscriber.isPublisherOpen();
+        const int count = subscriber.read(records.data(), kReadBatch);
+        const double now = double(nowNs());
+        for (int i = 0; i < count; ++i)
+        {
+            const double latency = now - records[size_t(i)].time;
+            result->latencyNs += latency;
+            result->maxLatencyNs = std::max(result->maxLatencyNs, latency);
+        }
+        result->read += count;
+        if (count == 0 && !open)
+            break;
+    }
+    result->dropped = subscriber.droppedCount();
+}
+
+// kAircraft aircraft with kTasksPerAircraft automatic tasks each, spread over kDuration.
+void buildScenario(SimulationCore &core)
+{
+    core.loadSampleScenario();
+    SimulationState &state = core.state();
+    state.tasks.clear();
+    state.aircrafts.clear();
+    state.tasks.reserve(kAircraft * kTasksPerAircraft);
+
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> cell(0, DefaultGridSize - 1);
+    std::uniform_int_distribution<int> due(1, kDuration);
+    for (int a = 0; a < kAircraft; ++a)
+    {
+        Aircraft ac;
+        ac.name = QStringLiteral("AC-%1").arg(a);
+        ac.route = {QPoint(cell(rng), cell(rng)), QPoint(cell(rng), cell(rng))};
+        state.aircrafts.add(ac);
+
+        std::vector<int> times(kTasksPerAircraft);
+        for (int &t : times)
+        {
+            t = due(rng);
+        }
+        std::sort(times.begin(), times.end());
+        for (int t = 0; t < kTasksPerAircraft; ++t)
+        {
+            Task task;
+            task.name = QStringLiteral("T-%1").arg(t);
+            task.executionTime = times[size_t(t)];
+            task.requiresFire = true;
+            task.requiresHit = true;
+            task.targetCell = QPoint(cell(rng), cell(rng));
+            state.tasks.append(a, task);
+        }
+    }
+    state.tasks.assignRanges(state.aircrafts);
+    core.setLoggingEnabled(false);
+    core.setThreadCount(1);
+    core.reset();
+}
+}
+
+int runResultChannelBenchmark(QTextStream &out)
+{
+    const QString name = QStringLiteral("ruling-bench-results-%1").arg(QCoreApplication::applicationPid());
+    out << "result channel, " << kRecords << " records of " << sizeof(ResultRecord) << " bytes, ring of "
+        << ResultPublisher::DefaultCapacity << '\n';
+    out << "readers  ns/publish  Mrec/s    read/reader  dropped/reader  mean latency us  max latency us\n";
+
+    int status = 0;
+    ResultRecord record;
+    std::memset(&record, 0, sizeof(record));
+    ResultRecord::setName(record.aircraftName, int(sizeof(record.aircraftName)), QStringLiteral("AC-0"));
+    ResultRecord::setName(record.taskName, int(sizeof(record.taskName)), QStringLiteral("T-0"));
+    for (int readers : {0, 1, 2, 4})
+    {
+        ResultPublisher publisher;
+        QString error;
+        if (!publisher.open(name, ResultPublisher::DefaultCapacity, &error))
+        {
+            out << error << '\n';
+            return 1;
+        }
+        std::atomic<int> attached(0);
+        std::vector<ReaderResult> results(size_t(readers));
+        std::vector<std::thread> threads;
+        for (int r = 0; r < readers; ++r)
+        {
+            threads.emplace_back(tail, name, &attached, &results[size_t(r)]);
+        }
+        while (attached.load() < readers)
+        {
+            std::this_thread::yield();
+        }
+
+        // Each publish also reads the clock for the latency stamp.
+        const qint64 start = nowNs();
+        for (int i = 0; i < kRecords; ++i)
+        {
+            record.time = double(nowNs());
+            record.task = i;
+            publisher.publish(record);
+        }
+        const double ns = double(nowNs() - start);
+        publisher.close();
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+
+        ReaderResult total;
+        for (const ReaderResult &result : results)
+        {
+            total.read += result.read;
+            total.dropped += result.dropped;
+            total.latencyNs += result.latencyNs;
+            total.maxLatencyNs = std::max(total.maxLatencyNs, result.maxLatencyNs);
+            if (result.read + qint64(result.dropped) != kRecords)
+                status = 1;
+        }
+        const int n = qMax(readers, 1);
+        out << QString::number(readers).leftJustified(9) << QString::number(ns / kRecords, 'f', 1).leftJustified(12)
+            << QString::number(kRecords * 1e3 / ns, 'f', 1).leftJustified(10)
+            << QString::number(total.read / n).leftJustified(13) << QString::number(total.dropped / quint64(n)).leftJustified(16)
+            << QString::number(total.read ? total.latencyNs / total.read / 1e3 : 0.0, 'f', 2).leftJustified(17)
+            << QString::number(total.maxLatencyNs / 1e3, 'f', 1) << '\n';
+        out.flush();
+    }
+
+    // What publishing costs the simulation itself.
+    out << "\nrun to completion, " << kAircraft * kTasksPerAircraft << " automatic tasks, logging off\n";
+    out << "channel   ms\n";
+    for (bool publish : {false, true})
+    {
+        SimulationCore core;
+        buildScenario(core);
+        QString error;
+        if (publish && !core.startResultChannel(name, ResultPublisher::DefaultCapacity, &error))
+        {
+            out << error << '\n';
+            return 1;
+        }
+        const double ms = timeBest([&] {
+            core.reset();
+            core.runToCompletion(kDuration);
+        });
+        core.stopResultChannel();
+        out << QString::fromLatin1(publish ? "on" : "off").leftJustified(10) << QString::number(ms, 'f', 1) << '\n';
+    }
+    out.flush();
+    return status;
+}
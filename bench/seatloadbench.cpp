@@ -0,0 +1,175 @@
+﻿#include "benchmarks.h"
+#include "seatclient.h"
+#include "seatserver.h"
+#include "simulationcore.h"
+
+#include <QCoreApplication>
+#include <QTimer>
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+constexpr int kSeats = 50;
+constexpr int kAircraft = 200;
+constexpr int kTasksPerAircraft = 25;
+constexpr int kDuration = 60; // simulated seconds over which tasks fall due
+constexpr int kConnectTimeoutMs = 5000;
+constexpr int kDrainTimeoutMs = 60000;
+
+struct LoadCase
+{
+    const char *name;
+    int thinkMs;     // before each ruling
+    int silentSeats; // seats that never answer, so their requests time out
+    int timeoutMs;
+};
+
+// Every aircraft carries kTasksPerAircraft manual tasks spread over kDuration.
+void buildScenario(SimulationCore &core)
+{
+    core.loadSampleScenario();
+    SimulationState &state = core.state();
+    state.mode = AdjudicationMode::Manual;
+    state.tasks.clear();
+    state.aircrafts.clear();
+    state.tasks.reserve(kAircraft * kTasksPerAircraft);
+
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> cell(0, DefaultGridSize - 1);
+    std::uniform_int_distribution<int> due(1, kDuration);
+    for (int a = 0; a < kAircraft; ++a)
+    {
+        Aircraft ac;
+        ac.name = QStringLiteral("AC-%1").arg(a);
+        ac.route = {QPoint(cell(rng), cell(rng)), QPoint(cell(rng), cell(rng))};
+        state.aircrafts.add(ac);
+
+        QVector<int> times;
+        for (int t = 0; t < kTasksPerAircraft; ++t)
+        {
+            times.append(due(rng));
+        }
+        std::sort(times.begin(), times.end());
+        for (int t = 0; t < kTasksPerAircraft; ++t)
+        {
+            Task task;
+            task.name = QStringLiteral("T-%1").arg(t);
+            task.executionTime = times.at(t);
+            task.requiresFire = true;
+            task.requiresDetection = true;
+            task.targetCell = QPoint(cell(rng), cell(rng));
+            state.tasks.append(a, task);
+        }
+    }
+    state.tasks.assignRanges(state.aircrafts);
+    core.setManualQueueEnabled(true);
+    core.setManualHoldPolicy(ManualHoldPolicy::HoldAffected);
+    core.reset();
+}
+
+bool waitFor(const std::function<bool()> &done, int timeoutMs)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (!done())
+    {
+        if (timer.elapsed() > timeoutMs)
+            return false;
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents, 10);
+    }
+    return true;
+}
+
+bool runCase(QTextStream &out, const LoadCase &load, const QString &serverName)
+{
+    SimulationCore core;
+    buildScenario(core);
+    SeatServer server(&core);
+    server.setTimeout(load.timeoutMs);
+    QString error;
+    if (!server.listen(serverName, 0, &error))
+    {
+        out << error << '\n';
+        return false;
+    }
+
+    std::vector<std::unique_ptr<SeatClient>> seats;
+    for (int s = 0; s < kSeats; ++s)
+    {
+        seats.emplace_back(new SeatClient(QStringLiteral("seat-%1").arg(s)));
+        SeatClient *seat = seats.back().get();
+        if (s >= load.silentSeats)
+        {
+            const int thinkMs = load.thinkMs;
+            QObject::connect(seat, &SeatClient::requestReceived, seat, [seat, thinkMs](const SeatMessage &request) {
+                const quint64 id = request.requestId;
+                const ManualAdjudicationState ruling = ManualAdjudicationState::fromBits(request.ruling);
+                if (thinkMs == 0)
+                    seat->submit(id, ruling);
+                else
+                    QTimer::singleShot(thinkMs, seat, [seat, id, ruling] { seat->submit(id, ruling); });
+            });
+        }
+        seat->connectToLocal(serverName);
+    }
+    if (!waitFor([&] { return server.seatCount() == kSeats; }, kConnectTimeoutMs))
+    {
+        out << "only " << server.seatCount() << " of " << kSeats << " seats connected\n";
+        return false;
+    }
+
+    QElapsedTimer wall;
+    wall.start();
+    for (int t = 1; t <= kDuration; ++t)
+    {
+        core.advanceTo(t);
+        server.sync();
+        QCoreApplication::processEvents();
+    }
+    const bool drained = waitFor(
+        [&] {
+            server.sync();
+            return core.isFinished();
+        },
+        kDrainTimeoutMs);
+    const double ms = wall.nsecsElapsed() / 1e6;
+
+    const SeatServer::Stats &stats = server.stats();
+    const qint64 decided = stats.ruled + stats.timedOut;
+    out << QString::fromLatin1(load.name).leftJustified(12) << QString::number(decided).leftJustified(10)
+        << QString::number(ms, 'f', 0).leftJustified(10)
+        << QString::number(decided * 60000.0 / qMax(ms, 1.0), 'f', 0).leftJustified(13)
+        << QString::number(stats.ruled ? stats.latencyNs / 1e6 / stats.ruled : 0.0, 'f', 2).leftJustified(14)
+        << QString::number(stats.maxLatencyNs / 1e6, 'f', 2).leftJustified(13) << stats.timedOut << '\n';
+    out.flush();
+    server.close();
+    return drained && decided == kAircraft * kTasksPerAircraft;
+}
+}
+
+int runSeatLoadBenchmark(QTextStream &out)
+{
+    out << "adjudication seats, " << kSeats << " local-socket clients, " << kAircraft * kTasksPerAircraft
+        << " manual rulings due over " << kDuration << " simulated s\n";
+    out << "case        rulings   wall ms   rulings/min  mean latency  max latency  timed out\n";
+
+    const QString serverName = QStringLiteral("ruling-bench-%1").arg(QCoreApplication::applicationPid());
+    const LoadCase cases[] = {
+        {"instant", 0, 0, SeatServer::DefaultTimeoutMs},
+        {"think 5ms", 5, 0, SeatServer::DefaultTimeoutMs},
+        {"5 silent", 0, 5, 250},
+    };
+    int status = 0;
+    for (const LoadCase &load : cases)
+    {
+        if (!runCase(out, load, serverName))
+            status = 1;
+    }
+    out.flush();
+    return status;
+}
@@ -0,0 +1,81 @@
+﻿#include "benchmarks.h"
+#include "workstealingpool.h"
+
+#include <QThread>
+
+#include <atomic>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+constexpr int kChunks = 4096;
+constexpr int kChunkWork = 2000; // inner iterations per chunk
+constexpr int kResizeRuns = 200;
+
+// Busy work whose result depends only on the chunk index.
+double chunkValue(int chunk)
+{
+    double value = chunk;
+    for (int i = 0; i < kChunkWork; ++i)
+    {
+        value = std::sqrt(value + i);
+    }
+    return value;
+}
+} // namespace
+
+int runWorkStealingPoolBenchmark(QTextStream &out)
+{
+    out << "work-stealing pool, " << kChunks << " chunks of " << kChunkWork << " steps\n";
+    out << "threads  ms        speedup  result\n";
+
+    std::vector<double> expected(kChunks);
+    for (int c = 0; c < kChunks; ++c)
+    {
+        expected[size_t(c)] = chunkValue(c);
+    }
+
+    int status = 0;
+    const int maxThreads = qMax(1, QThread::idealThreadCount());
+    double baseline = 0.0;
+    for (int threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        WorkStealingPool pool(threads);
+        std::vector<double> values(kChunks);
+        const double ms = timeBest([&] {
+            pool.run(kChunks, [&](int chunk) { values[size_t(chunk)] = chunkValue(chunk); });
+        });
+        if (threads == 1)
+            baseline = ms;
+        const bool same = values == expected;
+        out << QString::number(threads).leftJustified(9) << QString::number(ms, 'f', 2).leftJustified(10)
+            << QString::number(baseline / ms, 'f', 2).leftJustified(9) << (same ? "ok" : "MISMATCH") << '\n';
+        if (!same)
+            status = 1;
+    }
+
+    // Workers started by setThreadCount() must sit out until the next run()
+    // and then run each chunk exactly once.
+    WorkStealingPool pool;
+    std::vector<std::atomic<int>> hits(kChunks);
+    bool resizedOk = true;
+    for (int i = 0; i < kResizeRuns && resizedOk; ++i)
+    {
+        pool.setThreadCount(2 + i % 6);
+        for (std::atomic<int> &hit : hits)
+        {
+            hit.store(0, std::memory_order_relaxed);
+        }
+        pool.run(kChunks, [&](int chunk) { hits[size_t(chunk)].fetch_add(1, std::memory_order_relaxed); });
+        for (const std::atomic<int> &hit : hits)
+        {
+            if (hit.load(std::memory_order_relaxed) != 1)
+                resizedOk = false;
+        }
+    }
+    out << "\nthread count changed before each of " << kResizeRuns << " runs: " << (resizedOk ? "ok" : "MISMATCH") << '\n';
+    if (!resizedOk)
+        status = 1;
+    return status;
+}
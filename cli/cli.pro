@@ -0,0 +1,15 @@
+QT += core
+QT -= gui
+CONFIG += c++17 console
+CONFIG -= app_bundle
+TEMPLATE = app
+TARGET = ruling_cli
+
+include(../core/core.pri)
+
+SOURCES += \
+    main.cpp
+
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
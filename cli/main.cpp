@@ -0,0 +1,273 @@
+﻿#include "environmentraster.h"
+#include "replicationrunner.h"
+#include "simulationcore.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QTextStream>
+#include <QThread>
+
+namespace
+{
+QString statusName(TaskStatus status)
+{
+    switch (status)
+    {
+    case TaskStatus::Pending:
+        return QStringLiteral("pending");
+    case TaskStatus::Success:
+        return QStringLiteral("success");
+    case TaskStatus::Failed:
+        return QStringLiteral("failed");
+    case TaskStatus::AwaitingRuling:
+        return QStringLiteral("awaiting");
+    }
+    return {};
+}
+
+void writeResults(QTextStream &out, const SimulationState &state)
+{
+    for (int i = 0; i < state.logs.size(); ++i)
+    {
+        const TaskLogEntry &entry = state.logs.at(i);
+        out << QStringLiteral("[%1][%2][%3] %4").arg(entry.timestamp, entry.aircraftName, entry.taskName, entry.message) << '\n';
+    }
+
+    out << '\n' << "aircraft,task,executionTime,status" << '\n';
+    const TaskTable &tasks = state.tasks;
+    for (int row = 0; row < tasks.size(); ++row)
+    {
+        out << state.aircrafts.name(tasks.aircraft(row)) << ',' << tasks.name(row) << ',' << tasks.executionTime(row)
+            << ',' << statusName(tasks.status(row)) << '\n';
+    }
+    out << "simulationTime," << state.simulationTime << '\n';
+}
+
+void writeEstimate(QTextStream &out, const OutcomeEstimate &e)
+{
+    out << e.aircraftName << ',' << e.taskName << ',' << e.successes << ',' << e.trials << ','
+        << QString::number(e.rate, 'f', 4) << ',' << QString::number(e.lower, 'f', 4) << ','
+        << QString::number(e.upper, 'f', 4) << '\n';
+}
+
+void writeReport(QTextStream &out, const ReplicationReport &report)
+{
+    out << "replications," << report.replications << '\n';
+    out << "seed," << report.seed << '\n';
+    out << '\n' << "aircraft,task,successes,trials,rate,ci95Low,ci95High" << '\n';
+    for (const OutcomeEstimate &e : report.tasks)
+    {
+        writeEstimate(out, e);
+    }
+    out << '\n' << "aircraft,allTasks,successes,trials,rate,ci95Low,ci95High" << '\n';
+    for (const OutcomeEstimate &e : report.aircraft)
+    {
+        writeEstimate(out, e);
+    }
+}
+
+bool parseCount(const QString &text, int *value)
+{
+    bool ok = false;
+    *value = text.toInt(&ok);
+    return ok && *value >= 0;
+}
+
+bool parseGridSize(const QString &text, QSize *size)
+{
+    const QStringList parts = text.split(QLatin1Char('x'));
+    if (parts.size() != 2)
+        return false;
+    bool okW = false;
+    bool okH = false;
+    size->setWidth(parts.at(0).toInt(&okW));
+    size->setHeight(parts.at(1).toInt(&okH));
+    return okW && okH && size->width() >= 1 && size->height() >= 1
+           && size->width() <= MaxGridSize && size->height() <= MaxGridSize;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("ruling_cli"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Runs an adjudication scenario headless and writes the results."));
+    parser.addHelpOption();
+    QCommandLineOption maxTimeOption(QStringList{QStringLiteral("t"), QStringLiteral("max-time")},
+                                     QStringLiteral("Stop after <seconds> of simulated time (default 3600)."),
+                                     QStringLiteral("seconds"),
+                                     QStringLiteral("3600"));
+    QCommandLineOption outputOption(QStringList{QStringLiteral("o"), QStringLiteral("output")},
+                                    QStringLiteral("Write results to <file> instead of stdout."),
+                                    QStringLiteral("file"));
+    QCommandLineOption replicationsOption(QStringList{QStringLiteral("n"), QStringLiteral("replications")},
+                                          QStringLiteral("Run <count> stochastic replications and report success rates."),
+                                          QStringLiteral("count"));
+    QCommandLineOption seedOption(QStringList{QStringLiteral("s"), QStringLiteral("seed")},
+                                  QStringLiteral("Random seed for stochastic adjudication (default 1)."),
+                                  QStringLiteral("seed"),
+                                  QStringLiteral("1"));
+    QCommandLineOption threadsOption(QStringList{QStringLiteral("j"), QStringLiteral("threads")},
+                                     QStringLiteral("Worker threads for replications or for the simulation tick (default: all cores)."),
+                                     QStringLiteral("count"),
+                                     QStringLiteral("0"));
+    QCommandLineOption gridOption(QStringList{QStringLiteral("g"), QStringLiteral("grid-size")},
+                                  QStringLiteral("Map size in cells as <width>x<height>, up to 4096x4096 (default 50x50)."),
+                                  QStringLiteral("size"),
+                                  QStringLiteral("50x50"));
+    QCommandLineOption environmentOption(QStringList{QStringLiteral("e"), QStringLiteral("environment")},
+                                         QStringLiteral("Map the environment raster <file>; its size replaces --grid-size."),
+                                         QStringLiteral("file"));
+    QCommandLineOption scenarioOption(QStringList{QStringLiteral("S"), QStringLiteral("scenario")},
+                                      QStringLiteral("Load the JSON or binary scenario <file> instead of the built-in sample."),
+                                      QStringLiteral("file"));
+    QCommandLineOption saveScenarioOption(QStringLiteral("save-scenario"),
+                                          QStringLiteral("Write the loaded scenario to <file> (.json for JSON, otherwise binary)."),
+                                          QStringLiteral("file"));
+    QCommandLineOption journalOption(QStringLiteral("journal"),
+                                     QStringLiteral("Record the run to the replay journal <file>."),
+                                     QStringLiteral("file"));
+    QCommandLineOption replayOption(QStringLiteral("replay"),
+                                    QStringLiteral("Rebuild a run from the replay journal <file> instead of simulating."),
+                                    QStringLiteral("file"));
+    QCommandLineOption resultsOption(QStringLiteral("results"),
+                                     QStringLiteral("Publish every ruling to the shared-memory result channel <name> (see ruling_display)."),
+                                     QStringLiteral("name"));
+    parser.addOption(maxTimeOption);
+    parser.addOption(outputOption);
+    parser.addOption(replicationsOption);
+    parser.addOption(seedOption);
+    parser.addOption(threadsOption);
+    parser.addOption(gridOption);
+    parser.addOption(environmentOption);
+    parser.addOption(scenarioOption);
+    parser.addOption(saveScenarioOption);
+    parser.addOption(journalOption);
+    parser.addOption(replayOption);
+    parser.addOption(resultsOption);
+    parser.process(app);
+
+    int maxTime = 0;
+    int replications = 0;
+    int threads = 0;
+    bool seedOk = false;
+    const quint64 seed = parser.value(seedOption).toULongLong(&seedOk);
+    if (!parseCount(parser.value(maxTimeOption), &maxTime)
+        || (parser.isSet(replicationsOption) && !parseCount(parser.value(replicationsOption), &replications))
+        || !parseCount(parser.value(threadsOption), &threads)
+        || !seedOk)
+    {
+        QTextStream(stderr) << "invalid numeric option value\n";
+        return 1;
+    }
+    QSize gridSize;
+    if (!parseGridSize(parser.value(gridOption), &gridSize))
+    {
+        QTextStream(stderr) << "invalid grid size, expected <width>x<height> with sides 1-" << MaxGridSize << "\n";
+        return 1;
+    }
+
+    SimulationCore core;
+    QString error;
+    const bool replay = parser.isSet(replayOption);
+    if (replay)
+    {
+        if (!core.loadReplay(parser.value(replayOption), ReplayJournal::Options(), &error))
+        {
+            QTextStream(stderr) << error << '\n';
+            return 1;
+        }
+    }
+    else if (parser.isSet(scenarioOption))
+    {
+        if (!core.loadScenario(parser.value(scenarioOption), &error))
+        {
+            QTextStream(stderr) << error << '\n';
+            return 1;
+        }
+    }
+    else
+    {
+        core.loadSampleScenario(gridSize);
+    }
+    if (!replay && parser.isSet(environmentOption)
+        && !EnvironmentRaster::load(parser.value(environmentOption), core.state().environment, &error))
+    {
+        QTextStream(stderr) << error << '\n';
+        return 1;
+    }
+    if (parser.isSet(saveScenarioOption) && !core.saveScenario(parser.value(saveScenarioOption), &error))
+    {
+        QTextStream(stderr) << error << '\n';
+        return 1;
+    }
+
+    ReplicationReport report;
+    const bool replicate = parser.isSet(replicationsOption);
+    if (replicate)
+    {
+        ReplicationSettings settings;
+        settings.replications = replications;
+        settings.threadCount = threads;
+        settings.seed = seed;
+        settings.maxSimulationTime = maxTime;
+        report = ReplicationRunner::run(core.state(), settings);
+    }
+    else if (!replay)
+    {
+        core.state().randomSeed = seed;
+        core.setThreadCount(threads > 0 ? threads : QThread::idealThreadCount());
+        if (parser.isSet(journalOption) && !core.startJournal(parser.value(journalOption), &error))
+        {
+            QTextStream(stderr) << error << '\n';
+            return 1;
+        }
+        if (parser.isSet(resultsOption) && !core.startResultChannel(parser.value(resultsOption), ResultPublisher::DefaultCapacity, &error))
+        {
+            QTextStream(stderr) << error << '\n';
+            return 1;
+        }
+        core.runToCompletion(maxTime);
+        core.stopJournal();
+        core.stopResultChannel();
+        if (!core.journalError().isEmpty())
+        {
+            QTextStream(stderr) << core.journalError() << '\n';
+            return 1;
+        }
+    }
+
+    QFile file;
+    if (parser.isSet(outputOption))
+    {
+        file.setFileName(parser.value(outputOption));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+        {
+            QTextStream(stderr) << "cannot open " << file.fileName() << ": " << file.errorString() << '\n';
+            return 1;
+        }
+    }
+    else
+    {
+        file.open(stdout, QIODevice::WriteOnly | QIODevice::Text);
+    }
+
+    QTextStream out(&file);
+    out.setCodec("UTF-8");
+    if (replicate)
+    {
+        writeReport(out, report);
+        out.flush();
+        return 0;
+    }
+
+    writeResults(out, core.state());
+    out.flush();
+
+    if (replay)
+        return 0;
+    return core.isFinished() ? 0 : 2;
+}
@@ -0,0 +1,424 @@
+﻿#include "adjudicationengine.h"
+#include "counterrng.h"
+
+#include <QtMath>
+
+namespace
+{
+// Indexed by EnvironmentFactor.
+const char *const kFactorKeys[EnvironmentFactorCount] = {
+    "oceanDepth",
+    "airDryness",
+    "emInterference",
+    "temperature",
+    "humidity",
+};
+
+// Behaviour weight keys with a fixed meaning, indexed by TaskEvent.
+const char *const kEventKeys[TaskEventCount] = {
+    "fire",
+    "hit",
+    "detect",
+    "jam",
+};
+
+int factorIndex(const QString &key)
+{
+    for (int i = 0; i < EnvironmentFactorCount; ++i)
+    {
+        if (key == QLatin1String(kFactorKeys[i]))
+            return i;
+    }
+    return -1;
+}
+
+void fillRuleInputs(double *inputs, quint8 requirements, quint8 outcomes, const EnvironmentFactors &factors, double base)
+{
+    inputs[int(RuleInput::Fire)] = (outcomes & RequiresFire) ? 1.0 : 0.0;
+    inputs[int(RuleInput::Hit)] = (outcomes & RequiresHit) ? 1.0 : 0.0;
+    inputs[int(RuleInput::Detect)] = (outcomes & RequiresDetection) ? 1.0 : 0.0;
+    inputs[int(RuleInput::Jam)] = (outcomes & RequiresJam) ? 1.0 : 0.0;
+    inputs[int(RuleInput::RequiresFire)] = (requirements & RequiresFire) ? 1.0 : 0.0;
+    inputs[int(RuleInput::RequiresHit)] = (requirements & RequiresHit) ? 1.0 : 0.0;
+    inputs[int(RuleInput::RequiresDetection)] = (requirements & RequiresDetection) ? 1.0 : 0.0;
+    inputs[int(RuleInput::RequiresJam)] = (requirements & RequiresJam) ? 1.0 : 0.0;
+    inputs[int(RuleInput::OceanDepth)] = factors.oceanDepth;
+    inputs[int(RuleInput::AirDryness)] = factors.airDryness;
+    inputs[int(RuleInput::EmInterference)] = factors.emInterference;
+    inputs[int(RuleInput::Temperature)] = factors.temperature;
+    inputs[int(RuleInput::Humidity)] = factors.humidity;
+    inputs[int(RuleInput::Base)] = base;
+}
+}
+
+void AdjudicationEngine::setRandomStream(quint64 seed, quint64 stream)
+{
+    m_seed = seed;
+    m_stream = stream;
+}
+
+double AdjudicationEngine::drawUniform(quint64 taskKey, TaskEvent event) const
+{
+    return CounterRng::uniform(m_seed, m_stream, taskKey * 4 + quint64(event));
+}
+
+bool AdjudicationEngine::compileModel(AdjudicationModel &model, QString *errorMessage)
+{
+    std::array<int, EnvironmentFactorCount> counts{};
+    for (const QString &key : model.factorKeys)
+    {
+        const int index = factorIndex(key);
+        if (index < 0)
+        {
+            if (errorMessage)
+            {
+                *errorMessage = QStringLiteral("未知的环境因子: %1").arg(key);
+            }
+            return false;
+        }
+        ++counts[index];
+    }
+
+    model.factorCounts = counts;
+    model.factorTotal = model.factorKeys.size();
+    return true;
+}
+
+bool AdjudicationEngine::compileRule(AdjudicationRule &rule, QString *errorMessage)
+{
+    RuleProgram program;
+    if (!rule.expression.trimmed().isEmpty()
+        && !RuleProgram::compile(rule.expression, rule.behaviorWeights, &program, errorMessage))
+    {
+        return false;
+    }
+
+    for (int i = 0; i < TaskEventCount; ++i)
+    {
+        rule.eventWeights[i] = rule.behaviorWeights.value(QLatin1String(kEventKeys[i]), 0);
+    }
+    rule.program = std::move(program);
+    return true;
+}
+
+QStringList AdjudicationEngine::factorKeyNames()
+{
+    QStringList names;
+    for (const char *key : kFactorKeys)
+    {
+        names << QLatin1String(key);
+    }
+    return names;
+}
+
+double AdjudicationEngine::computeEnvironmentScore(const EnvironmentFactors &factors, const AdjudicationModel &model) const
+{
+    if (model.factorTotal == 0)
+    {
+        return 0.5;
+    }
+    return weightedFactorSum(factors, model) / (100.0 * model.factorTotal);
+}
+
+int AdjudicationEngine::weightedFactorSum(const EnvironmentFactors &factors, const AdjudicationModel &model)
+{
+    const std::array<int, EnvironmentFactorCount> &c = model.factorCounts;
+    return c[0] * factors.oceanDepth
+           + c[1] * factors.airDryness
+           + c[2] * factors.emInterference
+           + c[3] * factors.temperature
+           + c[4] * factors.humidity;
+}
+
+double AdjudicationEngine::successBase(int weightedSum, const AdjudicationModel &model)
+{
+    const double envScore = model.factorTotal == 0 ? 0.5 : weightedSum / (100.0 * model.factorTotal);
+    const double manualWeight = 1.0 - model.environmentWeight;
+    return model.environmentWeight * envScore + manualWeight * 0.9; // assume manual factors succeed
+}
+
+bool AdjudicationEngine::eventSuccess(TaskEvent event,
+                                      const EnvironmentFactors &factors,
+                                      const AdjudicationModel &model,
+                                      AdjudicationMode mode,
+                                      const ManualAdjudicationState &manualState,
+                                      quint64 taskKey) const
+{
+    const double base = mode == AdjudicationMode::Manual ? 0.0 : successBase(weightedFactorSum(factors, model), model);
+    return eventSuccess(event, base, mode, manualState, taskKey);
+}
+
+bool AdjudicationEngine::eventSuccess(TaskEvent event,
+                                      double base,
+                                      AdjudicationMode mode,
+                                      const ManualAdjudicationState &manualState,
+                                      quint64 taskKey) const
+{
+    if (mode == AdjudicationMode::Manual)
+    {
+        switch (event)
+        {
+        case TaskEvent::Fire:
+            return manualState.fireAllowed;
+        case TaskEvent::Hit:
+            return manualState.fireHit;
+        case TaskEvent::Detect:
+            return manualState.detectionSuccess;
+        case TaskEvent::Jam:
+            return manualState.jamSuccess;
+        }
+    }
+
+    //判断最终分数 = 环境得分+人为得分 >= 0.5 则通过
+    //环境得分=环境因子/100（累加） * 环境权重
+    //人为得分=0.9 * 人为权重
+
+    //修正
+//    switch (event)
+//    {
+//    case TaskEvent::Fire:
+//        base += 0.05;
+//        break;
+//    case TaskEvent::Hit:
+//        base -= 0.05;
+//        break;
+//    case TaskEvent::Detect:
+//        base += 0.02;
+//        break;
+//    case TaskEvent::Jam:
+//        base -= 0.02;
+//        break;
+//    }
+
+    if (mode == AdjudicationMode::Stochastic)
+    {
+        // base 作为成功概率
+        return drawUniform(taskKey, event) < base;
+    }
+    return base >= 0.5;
+}
+
+TaskStatus AdjudicationEngine::adjudicate(Task &task,
+                                          const EnvironmentFactors &factors,
+                                          const AdjudicationRule &rule,
+                                          const AdjudicationModel &model,
+                                          AdjudicationMode mode,
+                                          const ManualAdjudicationState &manualState,
+                                          quint64 taskKey,
+                                          QStringList *log,
+                                          AdjudicationOutcome *outcome) const
+{
+    double score = 0;
+    quint8 outcomes = 0;
+    const double base = mode == AdjudicationMode::Manual ? 0.0 : successBase(weightedFactorSum(factors, model), model);
+
+    auto logEvent = [&](const QString &text) {
+        if (log)
+        {
+            log->append(text);
+        }
+    };
+
+    if (task.requiresFire)
+    {
+        const bool ok = eventSuccess(TaskEvent::Fire, base, mode, manualState, taskKey);
+        outcomes |= ok ? RequiresFire : 0;
+        score += ok ? rule.eventWeights[int(TaskEvent::Fire)] : 0;
+        logEvent(ok ? QStringLiteral("开火许可通过") : QStringLiteral("开火许可被拒"));
+
+        if (task.requiresHit)
+        {
+            const bool hit = ok && eventSuccess(TaskEvent::Hit, base, mode, manualState, taskKey);
+            outcomes |= hit ? RequiresHit : 0;
+            score += hit ? rule.eventWeights[int(TaskEvent::Hit)] : 0;
+            logEvent(hit ? QStringLiteral("命中目标") : QStringLiteral("未命中目标"));
+        }
+    }
+
+    if (task.requiresDetection)
+    {
+        const bool detect = eventSuccess(TaskEvent::Detect, base, mode, manualState, taskKey);
+        outcomes |= detect ? RequiresDetection : 0;
+        score += detect ? rule.eventWeights[int(TaskEvent::Detect)] : 0;
+        logEvent(detect ? QStringLiteral("探测成功") : QStringLiteral("探测失败"));
+    }
+
+    if (task.requiresJam)
+    {
+        const bool jam = eventSuccess(TaskEvent::Jam, base, mode, manualState, taskKey);
+        outcomes |= jam ? RequiresJam : 0;
+        score += jam ? rule.eventWeights[int(TaskEvent::Jam)] : 0;
+        logEvent(jam ? QStringLiteral("电磁干扰成功") : QStringLiteral("电磁干扰失败"));
+    }
+
+    // An expression rule scores the same event outcomes its own way.
+    if (!rule.program.isEmpty())
+    {
+        double inputs[RuleProgram::InputCount];
+        fillRuleInputs(inputs, task.requirementMask(), outcomes, factors, base);
+        score = rule.program.evaluate(inputs);
+    }
+
+    TaskStatus result = score >= rule.successThreshold ? TaskStatus::Success : TaskStatus::Failed;
+    logEvent(QStringLiteral("任务得分 %1 / %2").arg(score).arg(rule.successThreshold));
+    task.status = result;
+    if (outcome)
+    {
+        outcome->outcomes = outcomes;
+        outcome->score = score;
+    }
+    return result;
+}
+
+void AdjudicationBatchStorage::resize(int count)
+{
+    const size_t n = size_t(qMax(0, count));
+    requirements.resize(n);
+    taskKeys.resize(n);
+    baseScores.resize(n);
+    fireWeights.resize(n);
+    hitWeights.resize(n);
+    detectWeights.resize(n);
+    jamWeights.resize(n);
+    thresholds.resize(n);
+    programs.resize(n);
+    factors.resize(n);
+    statuses.resize(n);
+    outcomes.resize(n);
+    scores.resize(n);
+}
+
+AdjudicationBatch AdjudicationBatchStorage::view()
+{
+    AdjudicationBatch batch;
+    batch.count = int(requirements.size());
+    batch.requirements = requirements.data();
+    batch.taskKeys = taskKeys.data();
+    batch.baseScores = baseScores.data();
+    batch.fireWeights = fireWeights.data();
+    batch.hitWeights = hitWeights.data();
+    batch.detectWeights = detectWeights.data();
+    batch.jamWeights = jamWeights.data();
+    batch.thresholds = thresholds.data();
+    batch.programs = programs.data();
+    batch.factors = factors.data();
+    batch.statuses = statuses.data();
+    batch.outcomes = outcomes.data();
+    batch.scores = scores.data();
+    return batch;
+}
+
+void AdjudicationEngine::adjudicateBatch(const AdjudicationBatch &batch, AdjudicationMode mode) const
+{
+    Q_ASSERT(mode != AdjudicationMode::Manual);
+    if (mode == AdjudicationMode::Stochastic)
+    {
+        adjudicateBatchStochastic(batch);
+        scoreBatchPrograms(batch);
+        return;
+    }
+
+    const quint8 *__restrict req = batch.requirements;
+    const double *__restrict base = batch.baseScores;
+    const qint32 *__restrict fireW = batch.fireWeights;
+    const qint32 *__restrict hitW = batch.hitWeights;
+    const qint32 *__restrict detectW = batch.detectWeights;
+    const qint32 *__restrict jamW = batch.jamWeights;
+    const qint32 *__restrict threshold = batch.thresholds;
+    quint8 *__restrict statuses = batch.statuses;
+    quint8 *__restrict outcomes = batch.outcomes;
+    double *__restrict scores = batch.scores;
+
+    const qint32 success = qint32(TaskStatus::Success);
+    const qint32 failed = qint32(TaskStatus::Failed);
+
+    for (int i = 0; i < batch.count; ++i)
+    {
+        // In automatic mode every event shares one environment verdict.
+        const qint32 ok = base[i] >= 0.5;
+
+        const qint32 r = req[i];
+        const qint32 fire = r & 1;
+        const qint32 hit = (r >> 1) & fire; // hit is only judged after fire
+        const qint32 detect = (r >> 2) & 1;
+        const qint32 jam = (r >> 3) & 1;
+
+        const qint32 score = ok * (fire * fireW[i] + hit * hitW[i] + detect * detectW[i] + jam * jamW[i]);
+        scores[i] = score;
+        statuses[i] = quint8(score >= threshold[i] ? success : failed);
+        outcomes[i] = quint8(ok * (fire | (hit << 1) | (detect << 2) | (jam << 3)));
+    }
+
+    scoreBatchPrograms(batch);
+}
+
+void AdjudicationEngine::scoreBatchPrograms(const AdjudicationBatch &batch)
+{
+    if (!batch.programs)
+        return;
+
+    double inputs[RuleProgram::InputCount];
+    for (int i = 0; i < batch.count; ++i)
+    {
+        const RuleProgram *program = batch.programs[i];
+        if (!program)
+            continue;
+        fillRuleInputs(inputs, batch.requirements[i], batch.outcomes[i], batch.factors[i], batch.baseScores[i]);
+        const double score = program->evaluate(inputs);
+        batch.scores[i] = score;
+        batch.statuses[i] = quint8(score >= batch.thresholds[i] ? TaskStatus::Success : TaskStatus::Failed);
+    }
+}
+
+void AdjudicationEngine::adjudicateBatchStochastic(const AdjudicationBatch &batch) const
+{
+    const qint32 success = qint32(TaskStatus::Success);
+    const qint32 failed = qint32(TaskStatus::Failed);
+
+    for (int i = 0; i < batch.count; ++i)
+    {
+        const double base = batch.baseScores[i];
+
+        const quint64 key = batch.taskKeys[i];
+        const qint32 r = batch.requirements[i];
+        const qint32 fire = (r & 1) & qint32(drawUniform(key, TaskEvent::Fire) < base);
+        const qint32 hit = ((r >> 1) & fire) & qint32(drawUniform(key, TaskEvent::Hit) < base);
+        const qint32 detect = ((r >> 2) & 1) & qint32(drawUniform(key, TaskEvent::Detect) < base);
+        const qint32 jam = ((r >> 3) & 1) & qint32(drawUniform(key, TaskEvent::Jam) < base);
+
+        const qint32 score = fire * batch.fireWeights[i] + hit * batch.hitWeights[i]
+                             + detect * batch.detectWeights[i] + jam * batch.jamWeights[i];
+        batch.scores[i] = score;
+        batch.statuses[i] = quint8(score >= batch.thresholds[i] ? success : failed);
+        batch.outcomes[i] = quint8(fire | (hit << 1) | (detect << 2) | (jam << 3));
+    }
+}
+
+void AdjudicationEngine::describeBatchResult(const AdjudicationBatch &batch, int index, QStringList *log)
+{
+    describeOutcome(batch.requirements[index], batch.outcomes[index], batch.scores[index], batch.thresholds[index], log);
+}
+
+void AdjudicationEngine::describeOutcome(quint8 req, quint8 outcome, double score, int threshold, QStringList *log)
+{
+    if (!log)
+        return;
+
+    if (req & RequiresFire)
+    {
+        log->append(outcome & RequiresFire ? QStringLiteral("开火许可通过") : QStringLiteral("开火许可被拒"));
+        if (req & RequiresHit)
+        {
+            log->append(outcome & RequiresHit ? QStringLiteral("命中目标") : QStringLiteral("未命中目标"));
+        }
+    }
+    if (req & RequiresDetection)
+    {
+        log->append(outcome & RequiresDetection ? QStringLiteral("探测成功") : QStringLiteral("探测失败"));
+    }
+    if (req & RequiresJam)
+    {
+        log->append(outcome & RequiresJam ? QStringLiteral("电磁干扰成功") : QStringLiteral("电磁干扰失败"));
+    }
+    log->append(QStringLiteral("任务得分 %1 / %2").arg(score).arg(threshold));
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include "models.h"
+
+#include <vector>
+
+// Structure-of-arrays view over a block of tasks adjudicated automatically
+// against one model. Every array holds `count` entries; baseScores holds the
+// model's success base at each task's target cell (see successBase()).
+// Tasks whose rule has a compiled expression carry it in `programs` (null
+// for weight-sum rules); `factors` is only read for those tasks.
+struct AdjudicationBatch
+{
+    int count = 0;
+    const quint8 *requirements = nullptr; // TaskRequirementFlag bits
+    const quint64 *taskKeys = nullptr;    // stable task identity, Stochastic mode only
+    const double *baseScores = nullptr;
+    const qint32 *fireWeights = nullptr;
+    const qint32 *hitWeights = nullptr;
+    const qint32 *detectWeights = nullptr;
+    const qint32 *jamWeights = nullptr;
+    const qint32 *thresholds = nullptr;
+    const RuleProgram *const *programs = nullptr;
+    const EnvironmentFactors *factors = nullptr;
+
+    quint8 *statuses = nullptr; // TaskStatus
+    quint8 *outcomes = nullptr; // TaskRequirementFlag bits of the events that succeeded
+    double *scores = nullptr;
+
+    // Entries [begin, begin + n) as a batch of their own; slices that do not
+    // overlap may be adjudicated concurrently.
+    AdjudicationBatch slice(int begin, int n) const
+    {
+        AdjudicationBatch part = *this;
+        part.count = n;
+        part.requirements += begin;
+        part.taskKeys += begin;
+        part.baseScores += begin;
+        part.fireWeights += begin;
+        part.hitWeights += begin;
+        part.detectWeights += begin;
+        part.jamWeights += begin;
+        part.thresholds += begin;
+        if (programs)
+            part.programs += begin;
+        if (factors)
+            part.factors += begin;
+        part.statuses += begin;
+        part.outcomes += begin;
+        part.scores += begin;
+        return part;
+    }
+};
+
+// Owns the columns behind an AdjudicationBatch so they can be reused between ticks.
+struct AdjudicationBatchStorage
+{
+    void resize(int count);
+    AdjudicationBatch view();
+
+    std::vector<quint8> requirements;
+    std::vector<quint64> taskKeys;
+    std::vector<double> baseScores;
+    std::vector<qint32> fireWeights;
+    std::vector<qint32> hitWeights;
+    std::vector<qint32> detectWeights;
+    std::vector<qint32> jamWeights;
+    std::vector<qint32> thresholds;
+    std::vector<const RuleProgram *> programs;
+    std::vector<EnvironmentFactors> factors;
+    std::vector<quint8> statuses;
+    std::vector<quint8> outcomes;
+    std::vector<double> scores;
+};
+
+// Event outcomes and score behind an adjudicate() verdict.
+struct AdjudicationOutcome
+{
+    quint8 outcomes = 0; // TaskRequirementFlag bits of the events that succeeded
+    double score = 0.0;
+};
+
+class AdjudicationEngine
+{
+public:
+    AdjudicationEngine() = default;
+
+    // Selects the random stream used in Stochastic mode. Each draw is keyed by
+    // (seed, stream, task key, event), so a replication is reproducible.
+    void setRandomStream(quint64 seed, quint64 stream);
+
+    // Resolves model.factorKeys into model.factorCounts. Unknown keys leave
+    // the model untouched and are reported through errorMessage.
+    static bool compileModel(AdjudicationModel &model, QString *errorMessage = nullptr);
+    static QStringList factorKeyNames();
+    // Resolves rule.behaviorWeights into rule.eventWeights and compiles
+    // rule.expression into rule.program (cleared when the expression is
+    // empty). On error the rule is left untouched.
+    static bool compileRule(AdjudicationRule &rule, QString *errorMessage = nullptr);
+
+    double computeEnvironmentScore(const EnvironmentFactors &factors, const AdjudicationModel &model) const;
+    // Count-weighted factor sum of a compiled model, 0..100 * factorTotal.
+    static int weightedFactorSum(const EnvironmentFactors &factors, const AdjudicationModel &model);
+    // environmentWeight * envScore + manualWeight * 0.9 for a weighted sum:
+    // the pass threshold in Automatic mode and the success probability in
+    // Stochastic mode. ScoreFieldCache precomputes it per cell.
+    static double successBase(int weightedSum, const AdjudicationModel &model);
+
+    bool eventSuccess(TaskEvent event,
+                      const EnvironmentFactors &factors,
+                      const AdjudicationModel &model,
+                      AdjudicationMode mode,
+                      const ManualAdjudicationState &manualState,
+                      quint64 taskKey = 0) const;
+    // Same verdict from an already computed success base.
+    bool eventSuccess(TaskEvent event,
+                      double base,
+                      AdjudicationMode mode,
+                      const ManualAdjudicationState &manualState,
+                      quint64 taskKey = 0) const;
+
+    TaskStatus adjudicate(Task &task,
+                          const EnvironmentFactors &factors,
+                          const AdjudicationRule &rule,
+                          const AdjudicationModel &model,
+                          AdjudicationMode mode,
+                          const ManualAdjudicationState &manualState,
+                          quint64 taskKey,
+                          QStringList *log = nullptr,
+                          AdjudicationOutcome *outcome = nullptr) const;
+
+    // Automatic/Stochastic-mode equivalent of adjudicate() for a whole block
+    // of tasks. Results match the per-task path exactly; the automatic kernel
+    // is branch-free so the compiler can vectorize it.
+    void adjudicateBatch(const AdjudicationBatch &batch, AdjudicationMode mode) const;
+    // Appends the log lines adjudicate() would have produced for batch entry `index`.
+    static void describeBatchResult(const AdjudicationBatch &batch, int index, QStringList *log);
+    // The same lines from the recorded requirements, outcomes and score.
+    static void describeOutcome(quint8 requirements, quint8 outcomes, double score, int threshold, QStringList *log);
+
+private:
+    void adjudicateBatchStochastic(const AdjudicationBatch &batch) const;
+    // Rescores the batch entries that have a rule program from their outcomes.
+    static void scoreBatchPrograms(const AdjudicationBatch &batch);
+
+    double drawUniform(quint64 taskKey, TaskEvent event) const;
+
+    quint64 m_seed = 1;
+    quint64 m_stream = 0;
+};
@@ -0,0 +1,280 @@
+﻿#include "aircraftstore.h"
+#include "memoryledger.h"
+#include "models.h"
+
+#include <algorithm>
+#include <limits>
+
+void AircraftStore::clear()
+{
+    m_routeIndices.clear();
+    m_stepAccumulators.clear();
+    m_secondsPerStep.clear();
+    m_held.clear();
+    m_routeOffsets.clear();
+    m_routeLengths.clear();
+    m_waypoints.clear();
+    m_deadWaypoints = 0;
+    m_firstTasks.clear();
+    m_taskCounts.clear();
+    m_names.clear();
+    m_handles.clear();
+    m_slotIndices.clear();
+    m_slotGenerations.clear();
+    m_freeSlots.clear();
+}
+
+void AircraftStore::reserve(int aircraft, int waypoints)
+{
+    m_routeIndices.reserve(aircraft);
+    m_stepAccumulators.reserve(aircraft);
+    m_secondsPerStep.reserve(aircraft);
+    m_held.reserve(aircraft);
+    m_routeOffsets.reserve(aircraft);
+    m_routeLengths.reserve(aircraft);
+    m_waypoints.reserve(waypoints);
+    m_firstTasks.reserve(aircraft);
+    m_taskCounts.reserve(aircraft);
+    m_names.reserve(aircraft);
+    m_handles.reserve(aircraft);
+    m_slotIndices.reserve(aircraft);
+    m_slotGenerations.reserve(aircraft);
+}
+
+AircraftHandle AircraftStore::add(const Aircraft &aircraft)
+{
+    const int index = size();
+    AircraftHandle handle;
+    if (!m_freeSlots.isEmpty())
+    {
+        handle.slot = m_freeSlots.takeLast();
+        handle.generation = ++m_slotGenerations[int(handle.slot)];
+        m_slotIndices[int(handle.slot)] = index;
+    }
+    else
+    {
+        handle.slot = quint32(m_slotIndices.size());
+        handle.generation = 1;
+        m_slotIndices.append(index);
+        m_slotGenerations.append(1);
+    }
+
+    m_routeIndices.append(aircraft.currentRouteIndex);
+    m_stepAccumulators.append(aircraft.stepAccumulator);
+    m_secondsPerStep.append(aircraft.secondsPerStep);
+    m_held.append(0);
+    m_routeOffsets.append(m_waypoints.size());
+    m_routeLengths.append(aircraft.route.size());
+    m_waypoints.append(aircraft.route);
+    m_firstTasks.append(m_firstTasks.isEmpty() ? 0 : m_firstTasks.last() + m_taskCounts.last());
+    m_taskCounts.append(0);
+    m_names.append(aircraft.name);
+    m_handles.append(handle);
+    return handle;
+}
+
+void AircraftStore::removeAt(int index)
+{
+    Q_ASSERT(m_taskCounts.at(index) == 0);
+    const AircraftHandle removed = m_handles.at(index);
+    m_slotIndices[int(removed.slot)] = -1;
+    m_freeSlots.append(removed.slot);
+    m_deadWaypoints += m_routeLengths.at(index);
+
+    const int last = size() - 1;
+    if (index != last)
+    {
+        m_routeIndices.set(index, m_routeIndices.at(last));
+        m_stepAccumulators.set(index, m_stepAccumulators.at(last));
+        m_secondsPerStep[index] = m_secondsPerStep.at(last);
+        m_held[index] = m_held.at(last);
+        m_routeOffsets[index] = m_routeOffsets.at(last);
+        m_routeLengths[index] = m_routeLengths.at(last);
+        m_firstTasks[index] = m_firstTasks.at(last);
+        m_taskCounts[index] = m_taskCounts.at(last);
+        m_names[index] = std::move(m_names[last]);
+        m_handles[index] = m_handles.at(last);
+        m_slotIndices[int(m_handles.at(index).slot)] = index;
+    }
+    m_routeIndices.removeLast();
+    m_stepAccumulators.removeLast();
+    m_secondsPerStep.removeLast();
+    m_held.removeLast();
+    m_routeOffsets.removeLast();
+    m_routeLengths.removeLast();
+    m_firstTasks.removeLast();
+    m_taskCounts.removeLast();
+    m_names.removeLast();
+    m_handles.removeLast();
+
+    if (m_deadWaypoints > m_waypoints.size() / 2)
+        compactWaypoints();
+}
+
+int AircraftStore::indexOf(AircraftHandle handle) const
+{
+    if (handle.isNull() || handle.slot >= quint32(m_slotIndices.size()))
+        return -1;
+    if (m_slotGenerations.at(int(handle.slot)) != handle.generation)
+        return -1;
+    return m_slotIndices.at(int(handle.slot));
+}
+
+Aircraft AircraftStore::aircraft(int index) const
+{
+    Aircraft aircraft;
+    aircraft.name = m_names.at(index);
+    aircraft.route = m_waypoints.mid(m_routeOffsets.at(index), m_routeLengths.at(index));
+    aircraft.currentRouteIndex = m_routeIndices.at(index);
+    aircraft.secondsPerStep = m_secondsPerStep.at(index);
+    aircraft.stepAccumulator = m_stepAccumulators.at(index);
+    return aircraft;
+}
+
+void AircraftStore::setRoute(int index, const QVector<QPoint> &route)
+{
+    const int length = m_routeLengths.at(index);
+    if (route.size() <= length)
+    {
+        // Fits in place; the tail of the old range becomes a hole.
+        std::copy(route.cbegin(), route.cend(), m_waypoints.begin() + m_routeOffsets.at(index));
+        m_deadWaypoints += length - route.size();
+    }
+    else
+    {
+        m_deadWaypoints += length;
+        m_routeOffsets[index] = m_waypoints.size();
+        m_waypoints.append(route);
+    }
+    m_routeLengths[index] = route.size();
+    m_routeIndices.set(index, 0);
+    m_stepAccumulators.set(index, 0.0);
+
+    if (m_deadWaypoints > m_waypoints.size() / 2)
+        compactWaypoints();
+}
+
+QPoint AircraftStore::position(int index) const
+{
+    const int length = m_routeLengths.at(index);
+    if (length == 0)
+        return {0, 0};
+    return m_waypoints.at(m_routeOffsets.at(index) + qBound(0, m_routeIndices.at(index), length - 1));
+}
+
+void AircraftStore::setTaskRange(int index, int firstTask, int taskCount)
+{
+    m_firstTasks[index] = firstTask;
+    m_taskCounts[index] = taskCount;
+}
+
+void AircraftStore::advance(double seconds, int begin, int end)
+{
+    constexpr int chunkSize = ChunkedColumn<qint32>::ChunkSize;
+    const qint32 *lengths = m_routeLengths.constData();
+    const double *secondsPerStep = m_secondsPerStep.constData();
+    const quint8 *held = m_held.constData();
+    for (int i = begin; i < end;)
+    {
+        // One chunk of the motion columns at a time, taken for writing only
+        // once an aircraft in it moves.
+        const int chunk = i / chunkSize;
+        const int chunkEnd = qMin(end, (chunk + 1) * chunkSize);
+        const qint32 *indices = m_routeIndices.constChunk(chunk);
+        qint32 *routeIndices = nullptr;
+        double *accumulators = nullptr;
+        for (; i < chunkEnd; ++i)
+        {
+            const int local = i % chunkSize;
+            if (lengths[i] < 2 || held[i] || indices[local] + 1 >= lengths[i])
+                continue;
+            if (!routeIndices)
+            {
+                routeIndices = m_routeIndices.chunk(chunk);
+                accumulators = m_stepAccumulators.chunk(chunk);
+                indices = routeIndices;
+            }
+
+            double accumulator = accumulators[local] + seconds;
+            qint32 routeIndex = routeIndices[local];
+            while (accumulator >= secondsPerStep[i] && routeIndex + 1 < lengths[i])
+            {
+                accumulator -= secondsPerStep[i];
+                ++routeIndex;
+            }
+            accumulators[local] = accumulator;
+            routeIndices[local] = routeIndex;
+        }
+    }
+}
+
+void AircraftStore::detachMotion()
+{
+    constexpr int chunkSize = ChunkedColumn<qint32>::ChunkSize;
+    for (int chunk = 0; chunk < m_routeIndices.chunkCount(); ++chunk)
+    {
+        const int end = qMin(size(), (chunk + 1) * chunkSize);
+        for (int i = chunk * chunkSize; i < end; ++i)
+        {
+            if (isMoving(i))
+            {
+                m_routeIndices.chunk(chunk);
+                m_stepAccumulators.chunk(chunk);
+                break;
+            }
+        }
+    }
+}
+
+double AircraftStore::timeToNextStep() const
+{
+    double next = std::numeric_limits<double>::infinity();
+    for (int i = 0; i < size(); ++i)
+    {
+        if (!isMoving(i))
+            continue;
+        next = qMin(next, qMax(0.0, m_secondsPerStep.at(i) - m_stepAccumulators.at(i)));
+    }
+    return next;
+}
+
+void AircraftStore::resetMotion()
+{
+    m_routeIndices.fill(0);
+    m_stepAccumulators.fill(0.0);
+}
+
+void AircraftStore::compactWaypoints()
+{
+    QVector<QPoint> packed;
+    packed.reserve(m_waypoints.size() - m_deadWaypoints);
+    for (int i = 0; i < size(); ++i)
+    {
+        const int offset = m_routeOffsets.at(i);
+        m_routeOffsets[i] = packed.size();
+        for (int p = 0; p < m_routeLengths.at(i); ++p)
+        {
+            packed.append(m_waypoints.at(offset + p));
+        }
+    }
+    m_waypoints.swap(packed);
+    m_deadWaypoints = 0;
+}
+
+void AircraftStore::accountMemory(MemoryLedger &ledger) const
+{
+    m_routeIndices.accountMemory(ledger);
+    m_stepAccumulators.accountMemory(ledger);
+    ledger.add(m_secondsPerStep);
+    ledger.add(m_held);
+    ledger.add(m_routeOffsets);
+    ledger.add(m_routeLengths);
+    ledger.add(m_waypoints);
+    ledger.add(m_firstTasks);
+    ledger.add(m_taskCounts);
+    ledger.add(m_names);
+    ledger.add(m_handles);
+    ledger.add(m_slotIndices);
+    ledger.add(m_slotGenerations);
+    ledger.add(m_freeSlots);
+}
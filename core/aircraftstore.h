@@ -0,0 +1,131 @@
+#pragma once
+
+#include <QPoint>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+#include "chunkedcolumn.h"
+
+struct Aircraft;
+class MemoryLedger;
+
+// Refers to one aircraft across removals of others. A handle whose aircraft
+// was removed is stale: AircraftStore::indexOf() returns -1 for it, even if
+// its slot has been reused.
+struct AircraftHandle
+{
+    quint32 slot = 0;
+    quint32 generation = 0; // 0 is never issued
+
+    bool isNull() const { return generation == 0; }
+    bool operator==(const AircraftHandle &other) const { return slot == other.slot && generation == other.generation; }
+    bool operator!=(const AircraftHandle &other) const { return !(*this == other); }
+};
+
+// Every aircraft of a scenario as packed columns indexed 0..size()-1:
+// motion state (route index, step accumulator, speed), routes (offset and
+// length into one shared waypoint pool), task ranges and identity. The
+// per-tick sweep in advance() reads only the motion columns and route
+// lengths. Aircraft is the value type at the edit and serialization
+// boundary.
+//
+// add() appends; removeAt() moves the last aircraft into the hole, so both
+// are O(1) and indices are dense but not stable. Keep an AircraftHandle to
+// refer to an aircraft across removals. Columns are implicitly shared, so
+// copying the store (replications, timeline snapshots) is cheap until a
+// column is written. The route index and step accumulator, written every
+// tick, are ChunkedColumns: a tick copies only the chunks that hold an
+// aircraft still moving.
+class AircraftStore
+{
+public:
+    int size() const { return m_names.size(); }
+    bool isEmpty() const { return m_names.isEmpty(); }
+    void clear();
+    void reserve(int aircraft, int waypoints = 0);
+
+    // Appends the aircraft with an empty task range and returns its handle.
+    AircraftHandle add(const Aircraft &aircraft);
+    // Removes aircraft `index`; the last aircraft takes its index. Its task
+    // rows must already be gone (see TaskTable::removeAircraft).
+    void removeAt(int index);
+
+    // -1 for null and stale handles.
+    int indexOf(AircraftHandle handle) const;
+    AircraftHandle handle(int index) const { return m_handles.at(index); }
+
+    Aircraft aircraft(int index) const;
+    const QString &name(int index) const { return m_names.at(index); }
+    void setName(int index, const QString &name) { m_names[index] = name; }
+
+    // Waypoints stay valid until the next add(), setRoute() or removeAt().
+    const QPoint *route(int index) const { return m_waypoints.constData() + m_routeOffsets.at(index); }
+    int routeLength(int index) const { return m_routeLengths.at(index); }
+    // Resets the aircraft to the start of the new route.
+    void setRoute(int index, const QVector<QPoint> &route);
+    QPoint position(int index) const;
+
+    int currentRouteIndex(int index) const { return m_routeIndices.at(index); }
+    double stepAccumulator(int index) const { return m_stepAccumulators.at(index); }
+    double secondsPerStep(int index) const { return m_secondsPerStep.at(index); }
+    void setSecondsPerStep(int index, double secondsPerStep) { m_secondsPerStep[index] = secondsPerStep; }
+
+    // Rows of SimulationState::tasks owned by the aircraft, maintained by TaskTable.
+    int firstTask(int index) const { return m_firstTasks.at(index); }
+    int taskCount(int index) const { return m_taskCounts.at(index); }
+    void setTaskRange(int index, int firstTask, int taskCount);
+
+    // A held aircraft stays where it is until released (manual rulings
+    // pending on it); advance() and timeToNextStep() skip it.
+    bool isHeld(int index) const { return m_held.at(index) != 0; }
+    void setHeld(int index, bool held) { m_held[index] = held ? 1 : 0; }
+
+    // Moves every aircraft `seconds` further along its route.
+    void advance(double seconds) { advance(seconds, 0, size()); }
+    // Moves aircraft [begin, end). Concurrent calls on disjoint ranges are
+    // safe after detachMotion().
+    void advance(double seconds, int begin, int end);
+    // Gives this store its own copy of the motion chunks advance() will
+    // write, those holding an aircraft that is still moving.
+    void detachMotion();
+    // Seconds until the next aircraft reaches a waypoint, or infinity if
+    // every aircraft has stopped.
+    double timeToNextStep() const;
+    // Puts every aircraft back at the start of its route.
+    void resetMotion();
+
+    // Adds the column buffers to `ledger`.
+    void accountMemory(MemoryLedger &ledger) const;
+
+private:
+    // Not held, and short of the end of a route with at least two waypoints.
+    bool isMoving(int index) const
+    {
+        return m_routeLengths.at(index) >= 2 && !m_held.at(index)
+               && m_routeIndices.at(index) + 1 < m_routeLengths.at(index);
+    }
+    void compactWaypoints();
+
+    // Motion, read every tick; the first two are written for moving aircraft.
+    ChunkedColumn<qint32> m_routeIndices;
+    ChunkedColumn<double> m_stepAccumulators;
+    QVector<double> m_secondsPerStep;
+    QVector<quint8> m_held;
+    // Routes: [offset, offset + length) of m_waypoints. Replaced and removed
+    // routes leave holes that compactWaypoints() squeezes out.
+    QVector<qint32> m_routeOffsets;
+    QVector<qint32> m_routeLengths;
+    QVector<QPoint> m_waypoints;
+    int m_deadWaypoints = 0;
+    // Task ranges.
+    QVector<qint32> m_firstTasks;
+    QVector<qint32> m_taskCounts;
+    // Identity.
+    QVector<QString> m_names;
+    QVector<AircraftHandle> m_handles;
+    // Handle slot -> index (-1 when free), and each slot's current generation.
+    QVector<qint32> m_slotIndices;
+    QVector<quint32> m_slotGenerations;
+    QVector<quint32> m_freeSlots;
+};
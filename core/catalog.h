@@ -0,0 +1,94 @@
+#pragma once
+
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+using CatalogId = quint32;
+constexpr CatalogId NoId = 0;
+
+// Ordered list of named items (rules, models) addressed by stable integer
+// ids. append() assigns each item a fresh `id` that is not reused until
+// clear(), so references survive renames and removals of other items; find() is a
+// direct table lookup. Names are only looked up at the edit and
+// serialization boundary (findByName).
+//
+// Items may be edited in place through operator[], but their id must not
+// be changed.
+template <typename T>
+class Catalog
+{
+public:
+    int size() const { return m_items.size(); }
+    bool isEmpty() const { return m_items.isEmpty(); }
+    const T &at(int index) const { return m_items.at(index); }
+    T &operator[](int index) { return m_items[index]; }
+    const T &first() const { return m_items.first(); }
+
+    typename QVector<T>::const_iterator begin() const { return m_items.cbegin(); }
+    typename QVector<T>::const_iterator end() const { return m_items.cend(); }
+    typename QVector<T>::iterator begin() { return m_items.begin(); }
+    typename QVector<T>::iterator end() { return m_items.end(); }
+
+    CatalogId append(T item)
+    {
+        item.id = m_nextId++;
+        m_slots.append(m_items.size());
+        m_items.append(std::move(item));
+        return m_items.last().id;
+    }
+
+    void removeAt(int index)
+    {
+        m_slots[int(m_items.at(index).id)] = -1;
+        m_items.removeAt(index);
+        for (int i = index; i < m_items.size(); ++i)
+        {
+            m_slots[int(m_items.at(i).id)] = i;
+        }
+    }
+
+    void clear()
+    {
+        m_items.clear();
+        m_slots = {-1};
+        m_nextId = 1;
+    }
+
+    // -1 for NoId and for ids that were removed or never issued.
+    int indexOf(CatalogId id) const
+    {
+        return id < CatalogId(m_slots.size()) ? m_slots.at(int(id)) : -1;
+    }
+    const T *find(CatalogId id) const
+    {
+        const int index = indexOf(id);
+        return index >= 0 ? &m_items.at(index) : nullptr;
+    }
+    T *find(CatalogId id)
+    {
+        const int index = indexOf(id);
+        return index >= 0 ? &m_items[index] : nullptr;
+    }
+
+    // First item with this name; linear, for UI and file formats only.
+    CatalogId findByName(const QString &name) const
+    {
+        for (const T &item : m_items)
+        {
+            if (item.name == name)
+                return item.id;
+        }
+        return NoId;
+    }
+    QString nameOf(CatalogId id) const
+    {
+        const T *item = find(id);
+        return item ? item->name : QString();
+    }
+
+private:
+    QVector<T> m_items;
+    QVector<int> m_slots{-1}; // id -> index; slot 0 is NoId
+    CatalogId m_nextId = 1;
+};
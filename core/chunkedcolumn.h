@@ -0,0 +1,130 @@
+#pragma once
+
+#include <QSharedData>
+#include <QSharedDataPointer>
+#include <QVector>
+#include <QtGlobal>
+
+#include <type_traits>
+
+#include "memoryledger.h"
+
+// A column of plain values kept in fixed-size chunks that copies share until
+// written, like EnvironmentField's tiles and TaskLogBuffer's chunks. Copying
+// the column (a timeline snapshot) shares every chunk; writing a value then
+// copies only the chunk it lies in. set() leaves a chunk shared when the
+// value does not change. Inserting and removing rewrite everything after the
+// edit, so they are for editing, not for sweeps.
+template <typename T>
+class ChunkedColumn
+{
+    Q_STATIC_ASSERT(std::is_trivially_copyable<T>::value);
+
+public:
+    static constexpr int ChunkShift = 10;
+    static constexpr int ChunkSize = 1 << ChunkShift;
+
+    int size() const { return m_size; }
+    bool isEmpty() const { return m_size == 0; }
+    int chunkCount() const { return m_chunks.size(); }
+
+    T at(int index) const
+    {
+        Q_ASSERT(index >= 0 && index < m_size);
+        return m_chunks.at(index >> ChunkShift)->values[index & (ChunkSize - 1)];
+    }
+    void set(int index, T value)
+    {
+        if (at(index) == value)
+            return;
+        m_chunks[index >> ChunkShift]->values[index & (ChunkSize - 1)] = value;
+    }
+
+    // Values [index * ChunkSize, (index + 1) * ChunkSize) of the column.
+    // chunk() first gives this column its own copy, if the chunk is shared.
+    const T *constChunk(int index) const { return m_chunks.at(index)->values; }
+    T *chunk(int index) { return m_chunks[index]->values; }
+
+    void clear()
+    {
+        m_chunks.clear();
+        m_size = 0;
+    }
+    void reserve(int size) { m_chunks.reserve((size + ChunkSize - 1) >> ChunkShift); }
+
+    void append(T value)
+    {
+        if (m_size == m_chunks.size() << ChunkShift)
+            m_chunks.append(QSharedDataPointer<Chunk>(new Chunk()));
+        m_chunks.last()->values[m_size & (ChunkSize - 1)] = value;
+        ++m_size;
+    }
+    void insert(int index, T value)
+    {
+        append(value);
+        for (int i = m_size - 1; i > index; --i)
+        {
+            set(i, at(i - 1));
+        }
+        set(index, value);
+    }
+    void remove(int index, int count)
+    {
+        for (int i = index; i + count < m_size; ++i)
+        {
+            set(i, at(i + count));
+        }
+        shrink(m_size - count);
+    }
+    void removeAt(int index) { remove(index, 1); }
+    void removeLast() { shrink(m_size - 1); }
+    void fill(T value)
+    {
+        for (int i = 0; i < m_size; ++i)
+        {
+            set(i, value);
+        }
+    }
+    // Moves [middle, size()) to start at `first`, as std::rotate does.
+    void rotate(int first, int middle)
+    {
+        QVector<T> tail;
+        tail.reserve(m_size - middle);
+        for (int i = middle; i < m_size; ++i)
+        {
+            tail.append(at(i));
+        }
+        for (int i = middle - 1; i >= first; --i)
+        {
+            set(i + tail.size(), at(i));
+        }
+        for (int i = 0; i < tail.size(); ++i)
+        {
+            set(first + i, tail.at(i));
+        }
+    }
+
+    void accountMemory(MemoryLedger &ledger) const
+    {
+        ledger.add(m_chunks);
+        for (const QSharedDataPointer<Chunk> &chunk : m_chunks)
+        {
+            ledger.add(chunk.constData(), qint64(sizeof(Chunk)));
+        }
+    }
+
+private:
+    struct Chunk : QSharedData
+    {
+        T values[ChunkSize];
+    };
+
+    void shrink(int size)
+    {
+        m_size = size;
+        m_chunks.resize((size + ChunkSize - 1) >> ChunkShift);
+    }
+
+    QVector<QSharedDataPointer<Chunk>> m_chunks;
+    int m_size = 0;
+};
@@ -0,0 +1,16 @@
+# Link against the SimulationCore static library built by core.pro.
+
+# The seat server and client use QtNetwork.
+QT += network
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+SIMULATION_CORE_DIR = $$OUT_PWD/../core
+win32:CONFIG(release, debug|release): SIMULATION_CORE_DIR = $$SIMULATION_CORE_DIR/release
+else:win32:CONFIG(debug, debug|release): SIMULATION_CORE_DIR = $$SIMULATION_CORE_DIR/debug
+
+LIBS += -L$$SIMULATION_CORE_DIR -lSimulationCore
+
+win32-g++|!win32: PRE_TARGETDEPS += $$SIMULATION_CORE_DIR/libSimulationCore.a
+else: PRE_TARGETDEPS += $$SIMULATION_CORE_DIR/SimulationCore.lib
@@ -0,0 +1,54 @@
+QT += core network
+QT -= gui
+CONFIG += c++17 staticlib
+TEMPLATE = lib
+TARGET = SimulationCore
+
+SOURCES += \
+    aircraftstore.cpp \
+    adjudicationengine.cpp \
+    environmentfield.cpp \
+    environmentraster.cpp \
+    factorkernels.cpp \
+    simulationcore.cpp \
+    simulationpacer.cpp \
+    simulationtimeline.cpp \
+    taskscheduler.cpp \
+    tasktable.cpp \
+    workstealingpool.cpp \
+    replayjournal.cpp \
+    replicationrunner.cpp \
+    resultchannel.cpp \
+    ruleprogram.cpp \
+    scenariofile.cpp \
+    scorefieldcache.cpp \
+    seatclient.cpp \
+    seatprotocol.cpp \
+    seatserver.cpp
+
+HEADERS += \
+    models.h \
+    aircraftstore.h \
+    adjudicationengine.h \
+    environmentfield.h \
+    environmentraster.h \
+    factorkernels.h \
+    catalog.h \
+    chunkedcolumn.h \
+    counterrng.h \
+    memoryledger.h \
+    simulationcore.h \
+    simulationpacer.h \
+    simulationtimeline.h \
+    taskscheduler.h \
+    tasktable.h \
+    workstealingpool.h \
+    replayjournal.h \
+    replicationrunner.h \
+    resultchannel.h \
+    ruleprogram.h \
+    scenariofile.h \
+    scorefieldcache.h \
+    seatclient.h \
+    seatprotocol.h \
+    seatserver.h
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <QtGlobal>
+
+// Stateless counter-based random numbers: every draw is a pure function of
+// (seed, stream, counter), so results do not depend on evaluation order or
+// on how work is split across threads.
+namespace CounterRng
+{
+inline quint64 mix(quint64 z)
+{
+    // SplitMix64 finalizer.
+    z += Q_UINT64_C(0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * Q_UINT64_C(0xbf58476d1ce4e5b9);
+    z = (z ^ (z >> 27)) * Q_UINT64_C(0x94d049bb133111eb);
+    return z ^ (z >> 31);
+}
+
+inline quint64 draw(quint64 seed, quint64 stream, quint64 counter)
+{
+    return mix(mix(mix(seed) ^ stream) ^ counter);
+}
+
+// Uniform double in [0, 1) with 53 random bits.
+inline double uniform(quint64 seed, quint64 stream, quint64 counter)
+{
+    return (draw(seed, stream, counter) >> 11) * (1.0 / 9007199254740992.0);
+}
+}
@@ -0,0 +1,285 @@
+﻿#include "environmentfield.h"
+#include "environmentraster.h"
+#include "memoryledger.h"
+
+#include <atomic>
+#include <cstring>
+
+namespace
+{
+int factorField(const EnvironmentFactors &factors, int factor)
+{
+    switch (EnvironmentFactor(factor))
+    {
+    case EnvironmentFactor::OceanDepth:
+        return factors.oceanDepth;
+    case EnvironmentFactor::AirDryness:
+        return factors.airDryness;
+    case EnvironmentFactor::EmInterference:
+        return factors.emInterference;
+    case EnvironmentFactor::Temperature:
+        return factors.temperature;
+    case EnvironmentFactor::Humidity:
+        return factors.humidity;
+    }
+    return DefaultFactorValue;
+}
+
+quint64 nextContentId()
+{
+    static std::atomic<quint64> counter(0);
+    return ++counter;
+}
+
+// Mapped raster cells may exceed the factor range; see EnvironmentRaster.
+void clampValues(quint8 *values, int count)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        values[i] = qMin(values[i], quint8(MaxFactorValue));
+    }
+}
+}
+
+EnvironmentField::EnvironmentField(int width, int height)
+{
+    resize(width, height);
+}
+
+void EnvironmentField::resize(int width, int height)
+{
+    m_raster.reset();
+    resetTiles(width, height);
+}
+
+void EnvironmentField::resetTiles(int width, int height)
+{
+    m_width = qBound(1, width, MaxGridSize);
+    m_height = qBound(1, height, MaxGridSize);
+    m_tilesX = (m_width + TileSize - 1) >> TileShift;
+    m_tilesY = (m_height + TileSize - 1) >> TileShift;
+    m_tiles.clear();
+    m_tiles.resize(m_tilesX * m_tilesY);
+    m_views.clear();
+    m_views.resize(m_tilesX * m_tilesY);
+    m_contentId = nextContentId();
+}
+
+void EnvironmentField::attachRaster(const QSharedPointer<const EnvironmentRaster> &raster)
+{
+    if (!raster)
+        return;
+    resetTiles(raster->width(), raster->height());
+    m_raster = raster;
+    for (int ty = 0; ty < m_tilesY; ++ty)
+    {
+        for (int tx = 0; tx < m_tilesX; ++tx)
+        {
+            m_views[ty * m_tilesX + tx] = raster->tileView(tx, ty);
+        }
+    }
+}
+
+int EnvironmentField::allocatedTileCount() const
+{
+    int count = 0;
+    for (const QSharedDataPointer<Tile> &tile : m_tiles)
+    {
+        if (tile.constData())
+            ++count;
+    }
+    return count;
+}
+
+void EnvironmentField::accountMemory(MemoryLedger &ledger) const
+{
+    ledger.add(m_tiles);
+    ledger.add(m_views);
+    for (const QSharedDataPointer<Tile> &tile : m_tiles)
+    {
+        ledger.add(tile.constData(), qint64(sizeof(Tile)));
+    }
+}
+
+bool factorValuesInRange(const quint8 *values, qint64 count)
+{
+    quint8 highest = 0;
+    for (qint64 i = 0; i < count; ++i)
+    {
+        highest = qMax(highest, values[i]);
+    }
+    return highest <= MaxFactorValue;
+}
+
+quint8 EnvironmentField::clampValue(int value)
+{
+    return quint8(qBound(0, value, MaxFactorValue));
+}
+
+EnvironmentField::Tile *EnvironmentField::writableTile(int index)
+{
+    QSharedDataPointer<Tile> &tile = m_tiles[index];
+    if (!tile.constData())
+    {
+        tile = new Tile;
+        std::memset(tile->values, DefaultFactorValue, sizeof(tile->values));
+
+        // A mapped tile is copied out on its first edit.
+        const TileView &source = m_views.at(index);
+        if (source.data)
+        {
+            const int tileX = index % m_tilesX;
+            const int tileY = index / m_tilesX;
+            const int columns = qMin(TileSize, m_width - (tileX << TileShift));
+            const int rows = qMin(TileSize, m_height - (tileY << TileShift));
+            for (int f = 0; f < EnvironmentFactorCount; ++f)
+            {
+                for (int y = 0; y < rows; ++y)
+                {
+                    std::memcpy(tile->values[f] + (y << TileShift), source.data + f * source.bandStep + qint64(y) * source.stride, size_t(columns));
+                    clampValues(tile->values[f] + (y << TileShift), columns);
+                }
+            }
+        }
+    }
+    // Non-const access detaches a tile still shared with another copy.
+    Tile *writable = tile.data();
+    m_views[index] = {writable->values[0], TileCells, TileSize};
+    return writable;
+}
+
+EnvironmentFactors EnvironmentField::at(const QPoint &cell) const
+{
+    EnvironmentFactors f;
+    if (!contains(cell))
+        return f;
+    f.oceanDepth = value(EnvironmentFactor::OceanDepth, cell);
+    f.airDryness = value(EnvironmentFactor::AirDryness, cell);
+    f.emInterference = value(EnvironmentFactor::EmInterference, cell);
+    f.temperature = value(EnvironmentFactor::Temperature, cell);
+    f.humidity = value(EnvironmentFactor::Humidity, cell);
+    return f;
+}
+
+void EnvironmentField::set(const QPoint &cell, const EnvironmentFactors &factors)
+{
+    if (!contains(cell))
+        return;
+    Tile *tile = writableTile(tileIndex(cell));
+    const int i = cellInTile(cell);
+    for (int f = 0; f < EnvironmentFactorCount; ++f)
+    {
+        tile->values[f][i] = clampValue(factorField(factors, f));
+    }
+}
+
+void EnvironmentField::setValue(EnvironmentFactor factor, const QPoint &cell, int value)
+{
+    if (!contains(cell))
+        return;
+    writableTile(tileIndex(cell))->values[int(factor)][cellInTile(cell)] = clampValue(value);
+}
+
+int EnvironmentField::factorSum(const QPoint &cell) const
+{
+    const TileView &view = m_views.at(tileIndex(cell));
+    if (!view.data)
+        return DefaultFactorValue * EnvironmentFactorCount;
+    const quint8 *p = view.data + (cell.y() & (TileSize - 1)) * view.stride + (cell.x() & (TileSize - 1));
+    int sum = 0;
+    for (int f = 0; f < EnvironmentFactorCount; ++f)
+    {
+        sum += qMin(p[f * view.bandStep], quint8(MaxFactorValue));
+    }
+    return sum;
+}
+
+void EnvironmentField::copyRow(EnvironmentFactor factor, int y, int x, int count, quint8 *out) const
+{
+    const int rowInTile = y & (TileSize - 1);
+    const int end = x + count;
+    while (x < end)
+    {
+        const int tileEnd = qMin(end, (x | (TileSize - 1)) + 1);
+        const int span = tileEnd - x;
+        const TileView &view = m_views.at(tileIndex({x, y}));
+        if (view.data)
+        {
+            std::memcpy(out, view.data + int(factor) * view.bandStep + rowInTile * view.stride + (x & (TileSize - 1)), size_t(span));
+            clampValues(out, span);
+        }
+        else
+            std::memset(out, DefaultFactorValue, size_t(span));
+        out += span;
+        x = tileEnd;
+    }
+}
+
+bool EnvironmentField::copyTile(int tileX, int tileY, quint8 *out) const
+{
+    const int cells = TileCells * EnvironmentFactorCount;
+    std::memset(out, DefaultFactorValue, size_t(cells));
+    if (!m_views.at(tileY * m_tilesX + tileX).data)
+        return false;
+
+    const int columns = qMin(TileSize, m_width - (tileX << TileShift));
+    const int rows = qMin(TileSize, m_height - (tileY << TileShift));
+    for (int f = 0; f < EnvironmentFactorCount; ++f)
+    {
+        for (int y = 0; y < rows; ++y)
+        {
+            copyRow(EnvironmentFactor(f), (tileY << TileShift) + y, tileX << TileShift, columns, out + f * TileCells + (y << TileShift));
+        }
+    }
+    for (int i = 0; i < cells; ++i)
+    {
+        if (out[i] != DefaultFactorValue)
+            return true;
+    }
+    return false;
+}
+
+void EnvironmentField::setTile(int tileX, int tileY, const quint8 *bandMajor)
+{
+    Q_ASSERT(factorValuesInRange(bandMajor, qint64(sizeof(Tile::values))));
+    Tile *tile = writableTile(tileY * m_tilesX + tileX);
+    std::memcpy(tile->values, bandMajor, sizeof(tile->values));
+}
+
+void EnvironmentField::fill(const EnvironmentFactors &factors)
+{
+    fill(QRect(0, 0, m_width, m_height), factors);
+}
+
+void EnvironmentField::fill(const QRect &rect, const EnvironmentFactors &factors)
+{
+    for (int f = 0; f < EnvironmentFactorCount; ++f)
+    {
+        fill(EnvironmentFactor(f), rect, factorField(factors, f));
+    }
+}
+
+void EnvironmentField::fill(EnvironmentFactor factor, const QRect &rect, int value)
+{
+    const QRect clipped = rect.intersected(QRect(0, 0, m_width, m_height));
+    if (clipped.isEmpty())
+        return;
+    const quint8 v = clampValue(value);
+
+    for (int ty = clipped.top() >> TileShift; ty <= clipped.bottom() >> TileShift; ++ty)
+    {
+        for (int tx = clipped.left() >> TileShift; tx <= clipped.right() >> TileShift; ++tx)
+        {
+            const int index = ty * m_tilesX + tx;
+            if (v == DefaultFactorValue && !m_views.at(index).data)
+                continue;
+
+            const QRect part = clipped.intersected(QRect(tx << TileShift, ty << TileShift, TileSize, TileSize));
+            quint8 *plane = writableTile(index)->values[int(factor)];
+            for (int y = part.top(); y <= part.bottom(); ++y)
+            {
+                std::memset(plane + ((y & (TileSize - 1)) << TileShift) + (part.left() & (TileSize - 1)), v, size_t(part.width()));
+            }
+        }
+    }
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <QPoint>
+#include <QRect>
+#include <QSharedPointer>
+#include <QSharedData>
+#include <QSharedDataPointer>
+#include <QSize>
+#include <QVector>
+#include <QtGlobal>
+
+enum class EnvironmentFactor
+{
+    OceanDepth,
+    AirDryness,
+    EmInterference,
+    Temperature,
+    Humidity
+};
+
+constexpr int EnvironmentFactorCount = 5;
+constexpr int DefaultGridSize = 50;
+constexpr int MaxGridSize = 4096;
+constexpr quint8 DefaultFactorValue = 50;
+constexpr int MaxFactorValue = 100;
+
+// True when none of the `count` stored factor values exceeds MaxFactorValue.
+bool factorValuesInRange(const quint8 *values, qint64 count);
+
+struct EnvironmentFactors
+{
+    int oceanDepth = 50;      // 0-100
+    int airDryness = 50;      // 0-100
+    int emInterference = 50;  // 0-100
+    int temperature = 50;     // 0-100
+    int humidity = 50;        // 0-100
+};
+
+class EnvironmentRaster;
+class MemoryLedger;
+
+// Environment grid of up to MaxGridSize cells per side, split into square
+// tiles that each hold one row-major plane per factor. Tiles that were never
+// written are not allocated and read as the default value (50), so a large
+// mostly-uniform theatre costs memory only where it was edited. Tiles are
+// shared between copies until written, which keeps copying a scenario cheap.
+// A memory-mapped raster can back the field; its tiles are read in place and
+// only copied out when a cell in them is edited. Raster values above
+// MaxFactorValue are clamped by every accessor below except tileView().
+class EnvironmentField
+{
+public:
+    static constexpr int TileShift = 6;
+    static constexpr int TileSize = 1 << TileShift;
+    static constexpr int TileCells = TileSize * TileSize;
+
+    // Where one tile's cells live: factor f, tile-local cell (x, y) is at
+    // data[f * bandStep + y * stride + x]. A null `data` is a default tile.
+    struct TileView
+    {
+        const quint8 *data = nullptr;
+        qint64 bandStep = 0;
+        int stride = 0;
+    };
+
+    EnvironmentField() = default;
+    EnvironmentField(int width, int height);
+
+    // Resizes the grid (clamped to 1..MaxGridSize); every cell is reset to
+    // the default values.
+    void resize(int width, int height);
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    QSize size() const { return {m_width, m_height}; }
+    qint64 cellCount() const { return qint64(m_width) * m_height; }
+    int tilesX() const { return m_tilesX; }
+    int tilesY() const { return m_tilesY; }
+    // Tiles copied into memory by edits; mapped and default tiles are free.
+    int allocatedTileCount() const;
+    // Adds the allocated tiles and tile tables to `ledger`; mapped tiles are
+    // not heap memory and are left out.
+    void accountMemory(MemoryLedger &ledger) const;
+    // Raw cells, unclamped when the tile is mapped.
+    TileView tileView(int tileX, int tileY) const { return m_views.at(tileY * m_tilesX + tileX); }
+
+    // Replaces the contents with a mapped raster, resizing to its dimensions.
+    void attachRaster(const QSharedPointer<const EnvironmentRaster> &raster);
+    bool isMapped() const { return !m_raster.isNull(); }
+    // Changes whenever the whole grid is replaced (resize, raster attach), so
+    // derived caches can tell a new field from per-cell edits of the old one.
+    quint64 contentId() const { return m_contentId; }
+
+    bool contains(const QPoint &cell) const
+    {
+        return cell.x() >= 0 && cell.y() >= 0 && cell.x() < m_width && cell.y() < m_height;
+    }
+
+    // Out-of-range cells report the default factors.
+    EnvironmentFactors at(const QPoint &cell) const;
+    void set(const QPoint &cell, const EnvironmentFactors &factors);
+
+    // `cell` must lie inside the grid.
+    quint8 value(EnvironmentFactor factor, const QPoint &cell) const
+    {
+        const TileView &view = m_views.at(tileIndex(cell));
+        if (!view.data)
+            return DefaultFactorValue;
+        const quint8 v = view.data[int(factor) * view.bandStep + (cell.y() & (TileSize - 1)) * view.stride + (cell.x() & (TileSize - 1))];
+        return qMin(v, quint8(MaxFactorValue));
+    }
+    void setValue(EnvironmentFactor factor, const QPoint &cell, int value);
+    // Sum of all factors at an in-grid cell (0-500), as used for shading the map.
+    int factorSum(const QPoint &cell) const;
+
+    // Copies `count` cells of row `y` starting at column `x` into `out`;
+    // the span must lie inside the grid.
+    void copyRow(EnvironmentFactor factor, int y, int x, int count, quint8 *out) const;
+
+    // Whole-tile transfer in the band-major layout of TileView (bandStep
+    // TileCells, stride TileSize); cells past the grid edge read as defaults.
+    // copyTile returns false when every cell of the tile is default;
+    // setTile expects values already within 0-MaxFactorValue.
+    bool copyTile(int tileX, int tileY, quint8 *out) const;
+    void setTile(int tileX, int tileY, const quint8 *bandMajor);
+
+    void fill(const EnvironmentFactors &factors);
+    void fill(const QRect &rect, const EnvironmentFactors &factors);
+    void fill(EnvironmentFactor factor, const QRect &rect, int value);
+
+private:
+    struct Tile : QSharedData
+    {
+        quint8 values[EnvironmentFactorCount][TileCells];
+    };
+
+    int tileIndex(const QPoint &cell) const
+    {
+        return (cell.y() >> TileShift) * m_tilesX + (cell.x() >> TileShift);
+    }
+    static int cellInTile(const QPoint &cell)
+    {
+        return ((cell.y() & (TileSize - 1)) << TileShift) | (cell.x() & (TileSize - 1));
+    }
+    void resetTiles(int width, int height);
+    Tile *writableTile(int index);
+    static quint8 clampValue(int value);
+
+    int m_width = 0;
+    int m_height = 0;
+    int m_tilesX = 0;
+    int m_tilesY = 0;
+    QVector<QSharedDataPointer<Tile>> m_tiles;
+    QVector<TileView> m_views;
+    QSharedPointer<const EnvironmentRaster> m_raster;
+    quint64 m_contentId = 0;
+};
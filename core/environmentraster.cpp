@@ -0,0 +1,232 @@
+﻿#include "environmentraster.h"
+
+#include <QSaveFile>
+#include <QtEndian>
+
+#include <cstring>
+#include <vector>
+
+namespace
+{
+const char kMagic[8] = {'A', 'F', 'E', 'N', 'V', 'R', 'S', 'T'};
+
+void setError(QString *error, const QString &message)
+{
+    if (error)
+        *error = message;
+}
+
+bool writeAll(QSaveFile &file, const void *data, qint64 size)
+{
+    return file.write(static_cast<const char *>(data), size) == size;
+}
+}
+
+EnvironmentRaster::~EnvironmentRaster()
+{
+    if (m_data)
+        m_file.unmap(const_cast<uchar *>(m_data));
+}
+
+QSharedPointer<const EnvironmentRaster> EnvironmentRaster::open(const QString &path, QString *error)
+{
+    QSharedPointer<EnvironmentRaster> raster(new EnvironmentRaster);
+    raster->m_file.setFileName(path);
+    if (!raster->m_file.open(QIODevice::ReadOnly))
+    {
+        setError(error, QStringLiteral("无法打开环境栅格: %1").arg(raster->m_file.errorString()));
+        return {};
+    }
+
+    raster->m_size = raster->m_file.size();
+    if (raster->m_size < HeaderSize)
+    {
+        setError(error, QStringLiteral("环境栅格文件过短"));
+        return {};
+    }
+    raster->m_data = raster->m_file.map(0, raster->m_size);
+    if (!raster->m_data)
+    {
+        setError(error, QStringLiteral("无法映射环境栅格: %1").arg(raster->m_file.errorString()));
+        return {};
+    }
+
+    const uchar *h = raster->m_data;
+    if (std::memcmp(h, kMagic, sizeof(kMagic)) != 0)
+    {
+        setError(error, QStringLiteral("不是环境栅格文件"));
+        return {};
+    }
+    const quint16 version = qFromLittleEndian<quint16>(h + 8);
+    const quint16 bands = qFromLittleEndian<quint16>(h + 10);
+    const quint16 layout = qFromLittleEndian<quint16>(h + 12);
+    const quint16 tileSize = qFromLittleEndian<quint16>(h + 14);
+    const quint32 width = qFromLittleEndian<quint32>(h + 16);
+    const quint32 height = qFromLittleEndian<quint32>(h + 20);
+    const quint64 dataOffset = qFromLittleEndian<quint64>(h + 24);
+
+    if (version != Version)
+    {
+        setError(error, QStringLiteral("不支持的环境栅格版本: %1").arg(version));
+        return {};
+    }
+    if (bands != EnvironmentFactorCount || layout > quint16(Layout::Tiled)
+        || (layout == quint16(Layout::Tiled) && tileSize != EnvironmentField::TileSize))
+    {
+        setError(error, QStringLiteral("不支持的环境栅格布局"));
+        return {};
+    }
+    if (width < 1 || height < 1 || width > quint32(MaxGridSize) || height > quint32(MaxGridSize))
+    {
+        setError(error, QStringLiteral("环境栅格尺寸超出范围: %1x%2").arg(width).arg(height));
+        return {};
+    }
+
+    raster->m_width = int(width);
+    raster->m_height = int(height);
+    raster->m_layout = Layout(layout);
+    raster->m_dataOffset = qint64(dataOffset);
+
+    // Only the header and tile table are checked here; the cell data is left
+    // untouched so nothing beyond them pages in.
+    const quint64 size = quint64(raster->m_size);
+    const quint64 tilesX = (width + EnvironmentField::TileSize - 1) / EnvironmentField::TileSize;
+    const quint64 tilesY = (height + EnvironmentField::TileSize - 1) / EnvironmentField::TileSize;
+    if (raster->m_layout == Layout::Banded)
+    {
+        const quint64 bandBytes = quint64(width) * height;
+        if (dataOffset < HeaderSize || dataOffset > size || size - dataOffset < bandBytes * EnvironmentFactorCount)
+        {
+            setError(error, QStringLiteral("环境栅格数据不完整"));
+            return {};
+        }
+    }
+    else
+    {
+        const quint64 tableBytes = tilesX * tilesY * sizeof(quint64);
+        const quint64 tileBytes = quint64(EnvironmentField::TileCells) * EnvironmentFactorCount;
+        if (dataOffset < HeaderSize || dataOffset > size || size - dataOffset < tableBytes)
+        {
+            setError(error, QStringLiteral("环境栅格瓦片表不完整"));
+            return {};
+        }
+        for (quint64 t = 0; t < tilesX * tilesY; ++t)
+        {
+            const quint64 offset = qFromLittleEndian<quint64>(h + dataOffset + t * sizeof(quint64));
+            if (offset != 0 && (offset < HeaderSize || offset > size || size - offset < tileBytes))
+            {
+                setError(error, QStringLiteral("环境栅格瓦片越界"));
+                return {};
+            }
+        }
+    }
+
+    return raster;
+}
+
+bool EnvironmentRaster::load(const QString &path, EnvironmentField &field, QString *error)
+{
+    const QSharedPointer<const EnvironmentRaster> raster = open(path, error);
+    if (!raster)
+        return false;
+    field.attachRaster(raster);
+    return true;
+}
+
+EnvironmentField::TileView EnvironmentRaster::tileView(int tileX, int tileY) const
+{
+    EnvironmentField::TileView view;
+    if (m_layout == Layout::Banded)
+    {
+        view.data = m_data + m_dataOffset
+                    + qint64(tileY) * EnvironmentField::TileSize * m_width
+                    + qint64(tileX) * EnvironmentField::TileSize;
+        view.bandStep = qint64(m_width) * m_height;
+        view.stride = m_width;
+        return view;
+    }
+
+    const int tilesX = (m_width + EnvironmentField::TileSize - 1) / EnvironmentField::TileSize;
+    const quint64 offset = qFromLittleEndian<quint64>(m_data + m_dataOffset + (qint64(tileY) * tilesX + tileX) * qint64(sizeof(quint64)));
+    if (offset != 0)
+    {
+        view.data = m_data + offset;
+        view.bandStep = EnvironmentField::TileCells;
+        view.stride = EnvironmentField::TileSize;
+    }
+    return view;
+}
+
+bool EnvironmentRaster::save(const QString &path, const EnvironmentField &field, Layout layout, QString *error)
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        setError(error, QStringLiteral("无法写入环境栅格: %1").arg(file.errorString()));
+        return false;
+    }
+
+    const int width = field.width();
+    const int height = field.height();
+    const int tileCount = field.tilesX() * field.tilesY();
+    const qint64 dataOffset = HeaderSize;
+
+    uchar header[HeaderSize] = {};
+    std::memcpy(header, kMagic, sizeof(kMagic));
+    qToLittleEndian<quint16>(Version, header + 8);
+    qToLittleEndian<quint16>(EnvironmentFactorCount, header + 10);
+    qToLittleEndian<quint16>(quint16(layout), header + 12);
+    qToLittleEndian<quint16>(layout == Layout::Tiled ? EnvironmentField::TileSize : 0, header + 14);
+    qToLittleEndian<quint32>(quint32(width), header + 16);
+    qToLittleEndian<quint32>(quint32(height), header + 20);
+    qToLittleEndian<quint64>(quint64(dataOffset), header + 24);
+    bool ok = writeAll(file, header, HeaderSize);
+
+    std::vector<quint8> row(size_t(width), 0);
+    if (layout == Layout::Banded)
+    {
+        for (int f = 0; ok && f < EnvironmentFactorCount; ++f)
+        {
+            for (int y = 0; ok && y < height; ++y)
+            {
+                field.copyRow(EnvironmentFactor(f), y, 0, width, row.data());
+                ok = writeAll(file, row.data(), width);
+            }
+        }
+    }
+    else
+    {
+        // Tiles that are default everywhere are left out of the file. The
+        // table is written first, so tiles are gathered twice rather than held.
+        std::vector<quint8> tile(size_t(EnvironmentField::TileCells) * EnvironmentFactorCount);
+        auto gatherTile = [&](int t) {
+            return field.copyTile(t % field.tilesX(), t / field.tilesX(), tile.data());
+        };
+
+        std::vector<bool> present(size_t(tileCount), false);
+        std::vector<uchar> table(size_t(tileCount) * sizeof(quint64), 0);
+        qint64 offset = dataOffset + qint64(table.size());
+        for (int t = 0; t < tileCount; ++t)
+        {
+            if (!gatherTile(t))
+                continue;
+            present[size_t(t)] = true;
+            qToLittleEndian<quint64>(quint64(offset), table.data() + size_t(t) * sizeof(quint64));
+            offset += qint64(tile.size());
+        }
+
+        ok = ok && writeAll(file, table.data(), qint64(table.size()));
+        for (int t = 0; ok && t < tileCount; ++t)
+        {
+            if (present[size_t(t)] && gatherTile(t))
+                ok = writeAll(file, tile.data(), qint64(tile.size()));
+        }
+    }
+
+    if (!ok || !file.commit())
+    {
+        setError(error, QStringLiteral("写入环境栅格失败: %1").arg(file.errorString()));
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <QFile>
+#include <QSharedPointer>
+#include <QString>
+
+#include "environmentfield.h"
+
+// Versioned binary environment raster, read in place through QFile::map so a
+// large theatre opens without parsing and pages in on demand.
+//
+// All integers are little-endian. Header (64 bytes):
+//   0  char[8]  magic "AFENVRST"
+//   8  quint16  version (1)
+//   10 quint16  band count (5, in EnvironmentFactor order)
+//   12 quint16  layout (0 = banded, 1 = tiled)
+//   14 quint16  tile size (EnvironmentField::TileSize when tiled, else 0)
+//   16 quint32  width in cells
+//   20 quint32  height in cells
+//   24 quint64  data offset
+//   32 ...      reserved, zero
+// Banded: band f is a row-major width*height byte plane at
+//   dataOffset + f * width * height.
+// Tiled: dataOffset points at a tilesX*tilesY table of quint64 tile offsets,
+//   row-major; 0 marks an absent tile that reads as the defaults. Each tile is
+//   band-major, one TileSize*TileSize plane per factor, padded at the edges.
+// Cell values are 0-100. They are not scanned on load, so that opening stays
+// lazy; EnvironmentField clamps larger values to 100 as it reads them.
+class EnvironmentRaster
+{
+public:
+    enum class Layout : quint16
+    {
+        Banded = 0,
+        Tiled = 1
+    };
+
+    static constexpr int HeaderSize = 64;
+    static constexpr quint16 Version = 1;
+
+    // Maps `path` read-only; returns null and sets `error` on failure.
+    static QSharedPointer<const EnvironmentRaster> open(const QString &path, QString *error = nullptr);
+    // Maps `path` and attaches it to `field`.
+    static bool load(const QString &path, EnvironmentField &field, QString *error = nullptr);
+    // Tiled files store only tiles that differ from the defaults somewhere.
+    static bool save(const QString &path, const EnvironmentField &field, Layout layout, QString *error = nullptr);
+
+    ~EnvironmentRaster();
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    Layout layout() const { return m_layout; }
+    EnvironmentField::TileView tileView(int tileX, int tileY) const;
+
+private:
+    EnvironmentRaster() = default;
+    Q_DISABLE_COPY(EnvironmentRaster)
+
+    QFile m_file;
+    const uchar *m_data = nullptr;
+    qint64 m_size = 0;
+    int m_width = 0;
+    int m_height = 0;
+    Layout m_layout = Layout::Banded;
+    qint64 m_dataOffset = 0;
+};
@@ -0,0 +1,356 @@
+﻿#include "factorkernels.h"
+
+#include <atomic>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define FACTOR_KERNELS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define KERNEL_TARGET(isa)
+#else
+// Per-function targets keep the rest of the library at the baseline ISA.
+#define KERNEL_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+namespace FactorKernels
+{
+namespace
+{
+// Predicates are normalised to an inclusive [lo, hi] range; lo > hi matches nothing.
+struct Range
+{
+    int lo;
+    int hi;
+};
+
+Range rangeFor(const Predicate &p)
+{
+    switch (p.compare)
+    {
+    case Compare::Less:
+        return {0, int(p.value) - 1};
+    case Compare::LessEqual:
+        return {0, p.value};
+    case Compare::Greater:
+        return {int(p.value) + 1, 255};
+    case Compare::GreaterEqual:
+        return {p.value, 255};
+    }
+    return {1, 0};
+}
+
+// ---- scalar ---------------------------------------------------------------
+
+void factorSumScalar(const quint8 *const *p, quint16 *out, qint64 begin, qint64 count)
+{
+    for (qint64 i = begin; i < count; ++i)
+    {
+        out[i] = quint16(p[0][i] + p[1][i] + p[2][i] + p[3][i] + p[4][i]);
+    }
+}
+
+void weightedSumScalar(const quint8 *const *p, const int *w, qint32 *out, qint64 begin, qint64 count)
+{
+    for (qint64 i = begin; i < count; ++i)
+    {
+        out[i] = w[0] * p[0][i] + w[1] * p[1][i] + w[2] * p[2][i] + w[3] * p[3][i] + w[4] * p[4][i];
+    }
+}
+
+void rangeMaskScalar(const quint8 *plane, quint8 lo, quint8 hi, quint8 *mask, qint64 begin, qint64 count)
+{
+    for (qint64 i = begin; i < count; ++i)
+    {
+        mask[i] &= quint8(plane[i] >= lo && plane[i] <= hi);
+    }
+}
+
+#ifdef FACTOR_KERNELS_X86
+// ---- SSE2 -----------------------------------------------------------------
+
+KERNEL_TARGET("sse2")
+qint64 factorSumSse2(const quint8 *const *p, quint16 *out, qint64 count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    qint64 i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i lo = zero;
+        __m128i hi = zero;
+        for (int f = 0; f < EnvironmentFactorCount; ++f)
+        {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p[f] + i));
+            lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(v, zero));
+            hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(v, zero));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), lo);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i + 8), hi);
+    }
+    return i;
+}
+
+KERNEL_TARGET("sse2")
+qint64 weightedSumSse2(const quint8 *const *p, const int *w, qint32 *out, qint64 count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    qint64 i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i acc[4] = {zero, zero, zero, zero};
+        for (int f = 0; f < EnvironmentFactorCount; ++f)
+        {
+            // value * weight <= 255 * 255 fits an unsigned 16-bit lane.
+            const __m128i weight = _mm_set1_epi16(short(w[f]));
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p[f] + i));
+            const __m128i lo = _mm_mullo_epi16(_mm_unpacklo_epi8(v, zero), weight);
+            const __m128i hi = _mm_mullo_epi16(_mm_unpackhi_epi8(v, zero), weight);
+            acc[0] = _mm_add_epi32(acc[0], _mm_unpacklo_epi16(lo, zero));
+            acc[1] = _mm_add_epi32(acc[1], _mm_unpackhi_epi16(lo, zero));
+            acc[2] = _mm_add_epi32(acc[2], _mm_unpacklo_epi16(hi, zero));
+            acc[3] = _mm_add_epi32(acc[3], _mm_unpackhi_epi16(hi, zero));
+        }
+        for (int k = 0; k < 4; ++k)
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i + 4 * k), acc[k]);
+        }
+    }
+    return i;
+}
+
+KERNEL_TARGET("sse2")
+qint64 rangeMaskSse2(const quint8 *plane, quint8 lo, quint8 hi, quint8 *mask, qint64 count)
+{
+    const __m128i vlo = _mm_set1_epi8(char(lo));
+    const __m128i vhi = _mm_set1_epi8(char(hi));
+    const __m128i one = _mm_set1_epi8(1);
+    qint64 i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(plane + i));
+        // Unsigned v >= lo and v <= hi via max/min equality.
+        const __m128i inRange = _mm_and_si128(_mm_cmpeq_epi8(_mm_max_epu8(v, vlo), v),
+                                              _mm_cmpeq_epi8(_mm_min_epu8(v, vhi), v));
+        const __m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i *>(mask + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(mask + i), _mm_and_si128(m, _mm_and_si128(inRange, one)));
+    }
+    return i;
+}
+
+// ---- AVX2 -----------------------------------------------------------------
+
+KERNEL_TARGET("avx2")
+qint64 factorSumAvx2(const quint8 *const *p, quint16 *out, qint64 count)
+{
+    qint64 i = 0;
+    for (; i + 32 <= count; i += 32)
+    {
+        __m256i lo = _mm256_setzero_si256();
+        __m256i hi = _mm256_setzero_si256();
+        for (int f = 0; f < EnvironmentFactorCount; ++f)
+        {
+            lo = _mm256_add_epi16(lo, _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p[f] + i))));
+            hi = _mm256_add_epi16(hi, _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p[f] + i + 16))));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), lo);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i + 16), hi);
+    }
+    return i;
+}
+
+KERNEL_TARGET("avx2")
+qint64 weightedSumAvx2(const quint8 *const *p, const int *w, qint32 *out, qint64 count)
+{
+    qint64 i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m256i acc0 = _mm256_setzero_si256();
+        __m256i acc1 = _mm256_setzero_si256();
+        for (int f = 0; f < EnvironmentFactorCount; ++f)
+        {
+            const __m256i v = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p[f] + i)));
+            const __m256i product = _mm256_mullo_epi16(v, _mm256_set1_epi16(short(w[f])));
+            acc0 = _mm256_add_epi32(acc0, _mm256_cvtepu16_epi32(_mm256_castsi256_si128(product)));
+            acc1 = _mm256_add_epi32(acc1, _mm256_cvtepu16_epi32(_mm256_extracti128_si256(product, 1)));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), acc0);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i + 8), acc1);
+    }
+    return i;
+}
+
+KERNEL_TARGET("avx2")
+qint64 rangeMaskAvx2(const quint8 *plane, quint8 lo, quint8 hi, quint8 *mask, qint64 count)
+{
+    const __m256i vlo = _mm256_set1_epi8(char(lo));
+    const __m256i vhi = _mm256_set1_epi8(char(hi));
+    const __m256i one = _mm256_set1_epi8(1);
+    qint64 i = 0;
+    for (; i + 32 <= count; i += 32)
+    {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(plane + i));
+        const __m256i inRange = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_max_epu8(v, vlo), v),
+                                                 _mm256_cmpeq_epi8(_mm256_min_epu8(v, vhi), v));
+        const __m256i m = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(mask + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(mask + i), _mm256_and_si256(m, _mm256_and_si256(inRange, one)));
+    }
+    return i;
+}
+
+Isa probeIsa()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4] = {};
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return Isa::Sse2;
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    __cpuidex(info, 7, 0);
+    const bool avx2 = (info[1] & (1 << 5)) != 0;
+    // The OS must also save the YMM registers on context switches.
+    if (osxsave && avx && avx2 && (_xgetbv(0) & 0x6) == 0x6)
+        return Isa::Avx2;
+    return Isa::Sse2;
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return Isa::Avx2;
+    if (__builtin_cpu_supports("sse2"))
+        return Isa::Sse2;
+    return Isa::Scalar;
+#endif
+}
+#else
+Isa probeIsa()
+{
+    return Isa::Scalar;
+}
+#endif
+
+std::atomic<int> &activeIsaStorage()
+{
+    static std::atomic<int> isa{int(detectedIsa())};
+    return isa;
+}
+}
+
+Isa detectedIsa()
+{
+    static const Isa isa = probeIsa();
+    return isa;
+}
+
+Isa activeIsa()
+{
+    return Isa(activeIsaStorage().load(std::memory_order_relaxed));
+}
+
+void setIsa(Isa isa)
+{
+    activeIsaStorage().store(int(qMin(int(isa), int(detectedIsa()))), std::memory_order_relaxed);
+}
+
+const char *isaName(Isa isa)
+{
+    switch (isa)
+    {
+    case Isa::Scalar:
+        return "scalar";
+    case Isa::Sse2:
+        return "sse2";
+    case Isa::Avx2:
+        return "avx2";
+    }
+    return "unknown";
+}
+
+void factorSum(const quint8 *const planes[EnvironmentFactorCount], quint16 *out, qint64 count)
+{
+    qint64 done = 0;
+#ifdef FACTOR_KERNELS_X86
+    switch (activeIsa())
+    {
+    case Isa::Avx2:
+        done = factorSumAvx2(planes, out, count);
+        break;
+    case Isa::Sse2:
+        done = factorSumSse2(planes, out, count);
+        break;
+    case Isa::Scalar:
+        break;
+    }
+#endif
+    factorSumScalar(planes, out, done, count);
+}
+
+void weightedSum(const quint8 *const planes[EnvironmentFactorCount],
+                 const std::array<int, EnvironmentFactorCount> &weights,
+                 qint32 *out,
+                 qint64 count)
+{
+    qint64 done = 0;
+#ifdef FACTOR_KERNELS_X86
+    bool narrow = true;
+    for (int w : weights)
+    {
+        narrow = narrow && w >= 0 && w <= 255;
+    }
+    if (narrow)
+    {
+        switch (activeIsa())
+        {
+        case Isa::Avx2:
+            done = weightedSumAvx2(planes, weights.data(), out, count);
+            break;
+        case Isa::Sse2:
+            done = weightedSumSse2(planes, weights.data(), out, count);
+            break;
+        case Isa::Scalar:
+            break;
+        }
+    }
+#endif
+    weightedSumScalar(planes, weights.data(), out, done, count);
+}
+
+void feasibilityMask(const quint8 *const planes[EnvironmentFactorCount],
+                     const Predicate *predicates,
+                     int predicateCount,
+                     quint8 *mask,
+                     qint64 count)
+{
+    std::memset(mask, 1, size_t(count));
+    for (int k = 0; k < predicateCount; ++k)
+    {
+        const Range range = rangeFor(predicates[k]);
+        if (range.lo > range.hi)
+        {
+            std::memset(mask, 0, size_t(count));
+            return;
+        }
+
+        const quint8 *plane = planes[int(predicates[k].factor)];
+        const quint8 lo = quint8(range.lo);
+        const quint8 hi = quint8(range.hi);
+        qint64 done = 0;
+#ifdef FACTOR_KERNELS_X86
+        switch (activeIsa())
+        {
+        case Isa::Avx2:
+            done = rangeMaskAvx2(plane, lo, hi, mask, count);
+            break;
+        case Isa::Sse2:
+            done = rangeMaskSse2(plane, lo, hi, mask, count);
+            break;
+        case Isa::Scalar:
+            break;
+        }
+#endif
+        rangeMaskScalar(plane, lo, hi, mask, done, count);
+    }
+}
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <QtGlobal>
+
+#include <array>
+
+#include "environmentfield.h"
+
+// Whole-plane kernels over contiguous quint8 factor planes (for example the
+// band-major tiles from EnvironmentField::copyTile). Each kernel has scalar,
+// SSE2 and AVX2 versions; the widest one the CPU supports is picked at
+// runtime, and all versions produce identical results.
+namespace FactorKernels
+{
+enum class Isa
+{
+    Scalar,
+    Sse2,
+    Avx2
+};
+
+enum class Compare
+{
+    Less,
+    LessEqual,
+    Greater,
+    GreaterEqual
+};
+
+// One clause of a feasibility mask, e.g. {Humidity, Less, 70}.
+struct Predicate
+{
+    EnvironmentFactor factor;
+    Compare compare;
+    quint8 value;
+};
+
+// Best instruction set supported by this CPU and operating system.
+Isa detectedIsa();
+Isa activeIsa();
+// Forces a narrower path (benchmarks, testing); clamped to detectedIsa().
+void setIsa(Isa isa);
+const char *isaName(Isa isa);
+
+// out[i] = sum of the five factors at cell i (0-500).
+void factorSum(const quint8 *const planes[EnvironmentFactorCount], quint16 *out, qint64 count);
+
+// out[i] = sum of weights[f] * planes[f][i]. Weights of 0-255 take the
+// vector path; other weights fall back to scalar code.
+void weightedSum(const quint8 *const planes[EnvironmentFactorCount],
+                 const std::array<int, EnvironmentFactorCount> &weights,
+                 qint32 *out,
+                 qint64 count);
+
+// mask[i] = 1 where every predicate holds at cell i, else 0.
+void feasibilityMask(const quint8 *const planes[EnvironmentFactorCount],
+                     const Predicate *predicates,
+                     int predicateCount,
+                     quint8 *mask,
+                     qint64 count);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <QHash>
+#include <QVector>
+#include <QtGlobal>
+
+// Sums the sizes of heap blocks, counting a block that several implicitly
+// shared copies point at only once. SimulationTimeline uses it to list the
+// blocks each snapshot keeps alive.
+class MemoryLedger
+{
+public:
+    void add(const void *block, qint64 bytes)
+    {
+        if (!block || bytes <= 0 || m_blocks.contains(block))
+            return;
+        m_blocks.insert(block, bytes);
+        m_bytes += bytes;
+    }
+    // The vector's buffer; elements' own heap data is not followed.
+    template <typename T>
+    void add(const QVector<T> &vector)
+    {
+        add(vector.constData(), qint64(vector.capacity()) * qint64(sizeof(T)));
+    }
+
+    qint64 bytes() const { return m_bytes; }
+    // Every block added, with its size.
+    const QHash<const void *, qint64> &blocks() const { return m_blocks; }
+    void clear()
+    {
+        m_blocks.clear();
+        m_bytes = 0;
+    }
+
+private:
+    QHash<const void *, qint64> m_blocks;
+    qint64 m_bytes = 0;
+};
@@ -0,0 +1,288 @@
+﻿#pragma once
+
+#include <QString>
+#include <QVector>
+#include <QPoint>
+#include <QMap>
+#include <QSharedData>
+#include <QSharedDataPointer>
+#include <QStringList>
+#include <QtGlobal>
+#include <QStringLiteral>
+
+#include <array>
+
+#include "aircraftstore.h"
+#include "catalog.h"
+#include "environmentfield.h"
+#include "memoryledger.h"
+#include "ruleprogram.h"
+#include "tasktable.h"
+
+enum class TaskEvent
+{
+    Fire,
+    Hit,
+    Detect,
+    Jam
+};
+constexpr int TaskEventCount = 4;
+
+// Handles into SimulationState::rules / ::models (see Catalog).
+using RuleId = CatalogId;
+using ModelId = CatalogId;
+
+enum class TaskStatus : quint8
+{
+    Pending,
+    Success,
+    Failed,
+    AwaitingRuling // due in Manual mode, queued for the operator's ruling
+};
+
+// Bit layout used wherever task requirements or event outcomes are packed.
+enum TaskRequirementFlag : quint8
+{
+    RequiresFire = 0x1,
+    RequiresHit = 0x2,
+    RequiresDetection = 0x4,
+    RequiresJam = 0x8
+};
+
+enum class AdjudicationMode
+{
+    Automatic,
+    Manual,
+    Stochastic // automatic score used as a success probability per event
+};
+
+// One task as a value; the simulation stores tasks in SimulationState::tasks.
+struct Task
+{
+    QString name;
+    int executionTime = 0;               // seconds in simulation timeline
+    bool requiresFire = false;
+    bool requiresHit = false;
+    bool requiresDetection = false;
+    bool requiresJam = false;
+    QPoint targetCell;
+    TaskStatus status = TaskStatus::Pending;
+    RuleId ruleId = NoId; // NoId: the current rule; a removed rule: the first
+
+    quint8 requirementMask() const
+    {
+        return (requiresFire ? RequiresFire : 0)
+               | (requiresHit ? RequiresHit : 0)
+               | (requiresDetection ? RequiresDetection : 0)
+               | (requiresJam ? RequiresJam : 0);
+    }
+
+    void setRequirementMask(quint8 mask)
+    {
+        requiresFire = mask & RequiresFire;
+        requiresHit = mask & RequiresHit;
+        requiresDetection = mask & RequiresDetection;
+        requiresJam = mask & RequiresJam;
+    }
+
+    QString statusText() const
+    {
+        switch (status)
+        {
+        case TaskStatus::Pending:
+            return  QStringLiteral("等待 %1s").arg(executionTime);
+        case TaskStatus::Success:
+            return  QStringLiteral("执行成功");
+        case TaskStatus::Failed:
+            return  QStringLiteral("执行失败");
+        case TaskStatus::AwaitingRuling:
+            return  QStringLiteral("等待人工裁决");
+        }
+        return {};
+    }
+};
+
+// One aircraft at the edit and serialization boundary; the simulation keeps
+// aircraft in an AircraftStore.
+struct Aircraft
+{
+    QString name;
+    QVector<QPoint> route; // each point is cell coordinate inside 50x50 map
+    int currentRouteIndex = 0;
+    double secondsPerStep = 1.0;
+    double stepAccumulator = 0.0;
+
+    QPoint position() const
+    {
+        if (route.isEmpty())
+        {
+            return {0, 0};
+        }
+        int idx = qBound(0, currentRouteIndex, route.size() - 1);
+        return route.at(idx);
+    }
+};
+
+struct AdjudicationRule
+{
+    RuleId id = NoId; // assigned by Catalog::append
+    QString name;
+    QMap<QString, int> behaviorWeights; // e.g. "fire" -> score
+    int successThreshold = 60;
+    // Optional score expression (see RuleProgram); when empty the score is
+    // the sum of the weights of the events that succeeded.
+    QString expression;
+
+    // Compiled from behaviorWeights and expression by AdjudicationEngine::compileRule.
+    std::array<qint32, TaskEventCount> eventWeights{}; // indexed by TaskEvent
+    RuleProgram program;
+};
+
+struct AdjudicationModel
+{
+    ModelId id = NoId; // assigned by Catalog::append
+    QString name;
+    QStringList factorKeys; // e.g. {"oceanDepth", "airDryness"}
+    double environmentWeight = 0.7; // rest is manual/other factors
+
+    // Compiled from factorKeys by AdjudicationEngine::compileModel.
+    std::array<int, EnvironmentFactorCount> factorCounts{}; // occurrences of each EnvironmentFactor
+    int factorTotal = 0;
+};
+
+struct ManualAdjudicationState
+{
+    bool fireAllowed = true;
+    bool fireHit = false;
+    bool detectionSuccess = true;
+    bool jamSuccess = true;
+
+    // Fire, hit, detect and jam as bits 0-3, the form the journal, the
+    // result channel and the seat protocol store a ruling in.
+    quint8 bits() const
+    {
+        return (fireAllowed ? 0x1 : 0) | (fireHit ? 0x2 : 0) | (detectionSuccess ? 0x4 : 0) | (jamSuccess ? 0x8 : 0);
+    }
+
+    static ManualAdjudicationState fromBits(quint8 bits)
+    {
+        ManualAdjudicationState state;
+        state.fireAllowed = bits & 0x1;
+        state.fireHit = bits & 0x2;
+        state.detectionSuccess = bits & 0x4;
+        state.jamSuccess = bits & 0x8;
+        return state;
+    }
+};
+
+struct TaskLogEntry
+{
+    QString taskName;
+    QString aircraftName;
+    QString message;
+    QString timestamp;
+};
+
+// Bounded log of adjudication messages. Appends are O(1); once full, the
+// oldest entry is dropped. Every entry gets a serial number that keeps
+// counting across evictions so views can tell what changed since they last
+// looked.
+//
+// Entries live in fixed-size chunks that copies share until written, so a
+// copy of the log (a timeline snapshot) costs only the chunk being filled.
+class TaskLogBuffer
+{
+public:
+    static constexpr int DefaultCapacity = 100000;
+    static constexpr int ChunkSize = 1024;
+
+    explicit TaskLogBuffer(int capacity = DefaultCapacity)
+        : m_capacity(qMax(1, capacity))
+    {
+    }
+
+    void append(const TaskLogEntry &entry)
+    {
+        if (m_chunks.isEmpty() || m_chunks.constLast()->entries.size() == ChunkSize)
+        {
+            m_chunks.append(QSharedDataPointer<Chunk>(new Chunk));
+            m_chunks.last()->entries.reserve(ChunkSize);
+        }
+        Chunk *chunk = m_chunks.last().data();
+        chunk->entries.append(entry);
+        chunk->textBytes += qint64(entry.taskName.size() + entry.aircraftName.size() + entry.message.size()
+                                   + entry.timestamp.size()) * qint64(sizeof(QChar));
+        ++m_totalAppended;
+
+        if (m_size < m_capacity)
+        {
+            ++m_size;
+            return;
+        }
+        if (++m_head == ChunkSize)
+        {
+            m_chunks.removeFirst();
+            m_head = 0;
+        }
+    }
+
+    void clear()
+    {
+        m_chunks.clear();
+        m_head = 0;
+        m_size = 0;
+    }
+
+    int size() const { return m_size; }
+    bool isEmpty() const { return m_size == 0; }
+    int capacity() const { return m_capacity; }
+
+    // 0 is the oldest retained entry.
+    const TaskLogEntry &at(int index) const
+    {
+        const int position = m_head + index;
+        return m_chunks.at(position / ChunkSize)->entries.at(position % ChunkSize);
+    }
+
+    // Serial of at(0); serials of later entries follow consecutively.
+    qint64 firstSerial() const { return m_totalAppended - m_size; }
+    qint64 endSerial() const { return m_totalAppended; }
+
+    void accountMemory(MemoryLedger &ledger) const
+    {
+        ledger.add(m_chunks);
+        for (const QSharedDataPointer<Chunk> &chunk : m_chunks)
+        {
+            ledger.add(chunk.constData(), qint64(chunk->entries.capacity()) * qint64(sizeof(TaskLogEntry)) + chunk->textBytes);
+        }
+    }
+
+private:
+    struct Chunk : QSharedData
+    {
+        QVector<TaskLogEntry> entries; // full except in the last chunk
+        qint64 textBytes = 0;
+    };
+
+    QVector<QSharedDataPointer<Chunk>> m_chunks;
+    int m_capacity;
+    int m_head = 0; // entries of the first chunk already evicted
+    int m_size = 0;
+    qint64 m_totalAppended = 0;
+};
+
+struct SimulationState
+{
+    AircraftStore aircrafts;
+    TaskTable tasks;
+    Catalog<AdjudicationRule> rules;
+    Catalog<AdjudicationModel> models;
+    AdjudicationMode mode = AdjudicationMode::Automatic;
+    quint64 randomSeed = 1; // Stochastic mode
+    RuleId currentRuleId = NoId;
+    ModelId currentModelId = NoId;
+    double simulationTime = 0.0; // seconds
+    EnvironmentField environment{DefaultGridSize, DefaultGridSize};
+    bool paused = false;
+    TaskLogBuffer logs;
+};
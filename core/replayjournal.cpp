@@ -0,0 +1,793 @@
+﻿#include "replayjournal.h"
+#include "adjudicationengine.h"
+#include "scenariofile.h"
+
+#include <QStringList>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+const char kJournalMagic[8] = {'A', 'F', 'J', 'R', 'N', 'L', '0', '1'};
+constexpr quint32 kByteOrderMark = 0x01020304;
+constexpr int kHeaderBytes = 8 + 4 + 4 + 4 + 8 + 8 + 4;
+constexpr size_t kFlushRecords = 4096;
+
+void setError(QString *error, const QString &message)
+{
+    if (error)
+        *error = message;
+}
+
+template <typename T>
+void appendLittleEndian(QByteArray &out, T value)
+{
+    char bytes[sizeof(T)];
+    qToLittleEndian<T>(value, bytes);
+    out.append(bytes, int(sizeof(T)));
+}
+
+void packFactors(const EnvironmentFactors &factors, quint8 *out)
+{
+    out[int(EnvironmentFactor::OceanDepth)] = quint8(factors.oceanDepth);
+    out[int(EnvironmentFactor::AirDryness)] = quint8(factors.airDryness);
+    out[int(EnvironmentFactor::EmInterference)] = quint8(factors.emInterference);
+    out[int(EnvironmentFactor::Temperature)] = quint8(factors.temperature);
+    out[int(EnvironmentFactor::Humidity)] = quint8(factors.humidity);
+}
+
+EnvironmentFactors unpackFactors(const quint8 *values)
+{
+    EnvironmentFactors factors;
+    factors.oceanDepth = values[int(EnvironmentFactor::OceanDepth)];
+    factors.airDryness = values[int(EnvironmentFactor::AirDryness)];
+    factors.emInterference = values[int(EnvironmentFactor::EmInterference)];
+    factors.temperature = values[int(EnvironmentFactor::Temperature)];
+    factors.humidity = values[int(EnvironmentFactor::Humidity)];
+    return factors;
+}
+
+bool validStatus(quint8 status)
+{
+    return status <= quint8(TaskStatus::AwaitingRuling);
+}
+
+bool validMode(quint8 mode)
+{
+    return mode <= quint8(AdjudicationMode::Stochastic);
+}
+
+bool sameTasks(const TaskTable &a, int firstA, const TaskTable &b, int firstB, int count)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        const int ra = firstA + i;
+        const int rb = firstB + i;
+        if (a.executionTime(ra) != b.executionTime(rb) || a.requirements(ra) != b.requirements(rb)
+            || a.targetCell(ra) != b.targetCell(rb) || a.rule(ra) != b.rule(rb) || a.name(ra) != b.name(rb))
+            return false;
+    }
+    return true;
+}
+
+bool sameRoute(const AircraftStore &a, const AircraftStore &b, int index)
+{
+    const int length = a.routeLength(index);
+    return length == b.routeLength(index)
+           && std::equal(a.route(index), a.route(index) + length, b.route(index));
+}
+}
+
+JournalRecord JournalRecord::make(Type type, double time)
+{
+    JournalRecord record;
+    std::memset(&record, 0, sizeof(record));
+    record.time = time;
+    record.type = type;
+    return record;
+}
+
+JournalRecorder::~JournalRecorder()
+{
+    close();
+}
+
+bool JournalRecorder::open(const QString &path,
+                           const QByteArray &scenario,
+                           const SimulationState &state,
+                           quint64 replication,
+                           QString *errorMessage)
+{
+    close();
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        setError(errorMessage, QStringLiteral("无法写入回放日志: %1").arg(m_file.errorString()));
+        return false;
+    }
+
+    QByteArray header;
+    header.append(kJournalMagic, int(sizeof(kJournalMagic)));
+    appendLittleEndian<quint32>(header, ReplayJournal::Version);
+    appendLittleEndian<quint32>(header, quint32(sizeof(JournalRecord)));
+    header.append(reinterpret_cast<const char *>(&kByteOrderMark), int(sizeof(kByteOrderMark)));
+    appendLittleEndian<quint64>(header, state.randomSeed);
+    appendLittleEndian<quint64>(header, replication);
+    appendLittleEndian<quint32>(header, quint32(scenario.size()));
+    header.append(scenario);
+    // Records start 64-byte aligned so a mapped journal can be read in place.
+    header.append(int((sizeof(JournalRecord) - header.size() % sizeof(JournalRecord)) % sizeof(JournalRecord)), '\0');
+    if (m_file.write(header) != header.size())
+    {
+        setError(errorMessage, QStringLiteral("写入回放日志失败: %1").arg(m_file.errorString()));
+        m_file.close();
+        return false;
+    }
+
+    m_buffer.reserve(kFlushRecords);
+    m_texts.clear();
+    m_error.clear();
+    m_shadow = SimulationState();
+    m_shadow.aircrafts = state.aircrafts;
+    m_shadow.tasks = state.tasks;
+    m_shadow.rules = state.rules;
+    m_shadow.models = state.models;
+    m_shadow.mode = state.mode;
+    m_shadow.currentRuleId = state.currentRuleId;
+    m_shadow.currentModelId = state.currentModelId;
+    m_shadow.environment = state.environment;
+    return true;
+}
+
+void JournalRecorder::close()
+{
+    if (!m_file.isOpen())
+        return;
+    flush();
+    m_file.close();
+    m_shadow = SimulationState();
+}
+
+bool JournalRecorder::flush()
+{
+    if (m_buffer.empty())
+        return !hasError();
+    const qint64 bytes = qint64(m_buffer.size() * sizeof(JournalRecord));
+    const bool ok = m_file.write(reinterpret_cast<const char *>(m_buffer.data()), bytes) == bytes;
+    m_buffer.clear();
+    if (!ok && !hasError())
+        m_error = QStringLiteral("写入回放日志失败: %1").arg(m_file.errorString());
+    return ok;
+}
+
+void JournalRecorder::append(const JournalRecord &record)
+{
+    // Records after a lost write would replay against the wrong state.
+    if (hasError())
+        return;
+    m_buffer.push_back(record);
+    if (m_buffer.size() >= kFlushRecords)
+        flush();
+}
+
+void JournalRecorder::recordTick(double time)
+{
+    append(JournalRecord::make(JournalRecord::Type::Tick, time));
+}
+
+void JournalRecorder::recordReset()
+{
+    append(JournalRecord::make(JournalRecord::Type::Reset, 0.0));
+}
+
+void JournalRecorder::recordAdjudication(const JournalRecord::Adjudication &adjudication, double time)
+{
+    JournalRecord record = JournalRecord::make(JournalRecord::Type::Adjudication, time);
+    record.adjudication = adjudication;
+    append(record);
+}
+
+void JournalRecorder::recordCell(const QPoint &cell, const EnvironmentFactors &factors, double time)
+{
+    JournalRecord record = JournalRecord::make(JournalRecord::Type::CellEdit, time);
+    record.cell.x = cell.x();
+    record.cell.y = cell.y();
+    packFactors(factors, record.cell.factors);
+    append(record);
+}
+
+void JournalRecorder::recordQueued(AircraftHandle aircraft, int task, double time)
+{
+    JournalRecord record = JournalRecord::make(JournalRecord::Type::RulingQueued, time);
+    record.queued.aircraftSlot = aircraft.slot;
+    record.queued.aircraftGeneration = aircraft.generation;
+    record.queued.task = task;
+    append(record);
+}
+
+void JournalRecorder::recordHold(AircraftHandle aircraft, bool held, double time)
+{
+    JournalRecord record = JournalRecord::make(JournalRecord::Type::Hold, time);
+    record.hold.aircraftSlot = aircraft.slot;
+    record.hold.aircraftGeneration = aircraft.generation;
+    record.hold.held = held ? 1 : 0;
+    append(record);
+}
+
+quint32 JournalRecorder::textId(const QString &text, double time)
+{
+    const auto found = m_texts.constFind(text);
+    if (found != m_texts.constEnd())
+        return found.value();
+
+    const quint32 id = quint32(m_texts.size()) + 1;
+    m_texts.insert(text, id);
+    const QByteArray utf8 = text.toUtf8();
+    int offset = 0;
+    do
+    {
+        JournalRecord record = JournalRecord::make(JournalRecord::Type::Text, time);
+        const int chunk = qMin(int(sizeof(record.text.bytes)), utf8.size() - offset);
+        record.text.id = id;
+        record.text.length = quint32(utf8.size());
+        record.text.offset = quint32(offset);
+        std::memcpy(record.text.bytes, utf8.constData() + offset, size_t(chunk));
+        append(record);
+        offset += chunk;
+    } while (offset < utf8.size());
+    return id;
+}
+
+void JournalRecorder::recordEdits(const SimulationState &state)
+{
+    if (!isOpen())
+        return;
+    const double time = state.simulationTime;
+
+    if (state.environment.contentId() != m_shadow.environment.contentId())
+    {
+        recordEnvironment(state.environment, time);
+    }
+
+    // Aircraft are neither added nor removed while recording, so indices
+    // line up with the copy.
+    const AircraftStore &aircrafts = state.aircrafts;
+    const int aircraftCount = qMin(aircrafts.size(), m_shadow.aircrafts.size());
+    for (int a = 0; a < aircraftCount; ++a)
+    {
+        const AircraftHandle handle = aircrafts.handle(a);
+        if (!sameRoute(aircrafts, m_shadow.aircrafts, a))
+        {
+            JournalRecord route = JournalRecord::make(JournalRecord::Type::Route, time);
+            route.route.aircraftSlot = handle.slot;
+            route.route.aircraftGeneration = handle.generation;
+            route.route.waypoints = aircrafts.routeLength(a);
+            append(route);
+            const QPoint *points = aircrafts.route(a);
+            for (int p = 0; p < aircrafts.routeLength(a); p += JournalRecord::WaypointsPerRecord)
+            {
+                JournalRecord chunk = JournalRecord::make(JournalRecord::Type::Waypoints, time);
+                chunk.waypoints.count = qMin(JournalRecord::WaypointsPerRecord, aircrafts.routeLength(a) - p);
+                for (int i = 0; i < chunk.waypoints.count; ++i)
+                {
+                    chunk.waypoints.xy[2 * i] = points[p + i].x();
+                    chunk.waypoints.xy[2 * i + 1] = points[p + i].y();
+                }
+                append(chunk);
+            }
+        }
+        if (aircrafts.secondsPerStep(a) != m_shadow.aircrafts.secondsPerStep(a))
+        {
+            JournalRecord speed = JournalRecord::make(JournalRecord::Type::Speed, time);
+            speed.speed.aircraftSlot = handle.slot;
+            speed.speed.aircraftGeneration = handle.generation;
+            speed.speed.secondsPerStep = aircrafts.secondsPerStep(a);
+            append(speed);
+        }
+
+        const int count = aircrafts.taskCount(a);
+        if (count == m_shadow.aircrafts.taskCount(a)
+            && sameTasks(state.tasks, aircrafts.firstTask(a), m_shadow.tasks, m_shadow.aircrafts.firstTask(a), count))
+            continue;
+
+        // Any change rewrites the aircraft's whole task list; edits are rare
+        // and this keeps task indices in later records unambiguous.
+        JournalRecord cleared = JournalRecord::make(JournalRecord::Type::TasksCleared, time);
+        cleared.taskRow.aircraftSlot = handle.slot;
+        cleared.taskRow.aircraftGeneration = handle.generation;
+        append(cleared);
+        for (int row = aircrafts.firstTask(a); row < aircrafts.firstTask(a) + count; ++row)
+        {
+            const quint32 name = textId(state.tasks.name(row), time);
+            JournalRecord task = JournalRecord::make(JournalRecord::Type::TaskAppended, time);
+            task.taskRow.aircraftSlot = handle.slot;
+            task.taskRow.aircraftGeneration = handle.generation;
+            task.taskRow.name = name;
+            task.taskRow.executionTime = state.tasks.executionTime(row);
+            task.taskRow.targetX = state.tasks.targetPoint(row).x();
+            task.taskRow.targetY = state.tasks.targetPoint(row).y();
+            task.taskRow.rule = state.tasks.rule(row);
+            task.taskRow.requirements = state.tasks.requirements(row);
+            task.taskRow.status = quint8(state.tasks.status(row));
+            append(task);
+        }
+    }
+
+    for (const AdjudicationRule &old : m_shadow.rules)
+    {
+        if (!state.rules.find(old.id))
+        {
+            JournalRecord removed = JournalRecord::make(JournalRecord::Type::RuleRemoved, time);
+            removed.rule.rule = old.id;
+            append(removed);
+        }
+    }
+    for (const AdjudicationRule &rule : state.rules)
+    {
+        const AdjudicationRule *old = m_shadow.rules.find(rule.id);
+        if (old && old->name == rule.name && old->successThreshold == rule.successThreshold
+            && old->behaviorWeights == rule.behaviorWeights && old->expression == rule.expression)
+            continue;
+        // Texts first, so the weights follow the edit with nothing between.
+        const quint32 name = textId(rule.name, time);
+        const quint32 expression = textId(rule.expression, time);
+        std::vector<quint32> keys;
+        keys.reserve(size_t(rule.behaviorWeights.size()));
+        for (auto it = rule.behaviorWeights.cbegin(); it != rule.behaviorWeights.cend(); ++it)
+        {
+            keys.push_back(textId(it.key(), time));
+        }
+        JournalRecord edit = JournalRecord::make(JournalRecord::Type::RuleEdit, time);
+        edit.rule.rule = rule.id;
+        edit.rule.name = name;
+        edit.rule.expression = expression;
+        edit.rule.threshold = rule.successThreshold;
+        edit.rule.weights = rule.behaviorWeights.size();
+        append(edit);
+        size_t k = 0;
+        for (const int value : rule.behaviorWeights)
+        {
+            JournalRecord weight = JournalRecord::make(JournalRecord::Type::RuleWeight, time);
+            weight.ruleWeight.rule = rule.id;
+            weight.ruleWeight.key = keys[k++];
+            weight.ruleWeight.weight = value;
+            append(weight);
+        }
+    }
+
+    for (const AdjudicationModel &old : m_shadow.models)
+    {
+        if (!state.models.find(old.id))
+        {
+            JournalRecord removed = JournalRecord::make(JournalRecord::Type::ModelRemoved, time);
+            removed.model.model = old.id;
+            append(removed);
+        }
+    }
+    for (const AdjudicationModel &model : state.models)
+    {
+        const AdjudicationModel *old = m_shadow.models.find(model.id);
+        if (old && old->name == model.name && old->factorKeys == model.factorKeys
+            && old->environmentWeight == model.environmentWeight)
+            continue;
+        const quint32 name = textId(model.name, time);
+        std::vector<quint32> keys;
+        keys.reserve(size_t(model.factorKeys.size()));
+        for (const QString &key : model.factorKeys)
+        {
+            keys.push_back(textId(key, time));
+        }
+        JournalRecord edit = JournalRecord::make(JournalRecord::Type::ModelEdit, time);
+        edit.model.model = model.id;
+        edit.model.name = name;
+        edit.model.environmentWeight = model.environmentWeight;
+        edit.model.factors = model.factorKeys.size();
+        append(edit);
+        for (const quint32 key : keys)
+        {
+            JournalRecord factor = JournalRecord::make(JournalRecord::Type::ModelFactor, time);
+            factor.modelFactor.model = model.id;
+            factor.modelFactor.key = key;
+            append(factor);
+        }
+    }
+
+    if (state.mode != m_shadow.mode || state.currentRuleId != m_shadow.currentRuleId
+        || state.currentModelId != m_shadow.currentModelId)
+    {
+        JournalRecord selection = JournalRecord::make(JournalRecord::Type::Selection, time);
+        selection.selection.mode = quint8(state.mode);
+        selection.selection.currentRule = state.currentRuleId;
+        selection.selection.currentModel = state.currentModelId;
+        append(selection);
+    }
+
+    m_shadow.aircrafts = state.aircrafts;
+    m_shadow.tasks = state.tasks;
+    m_shadow.rules = state.rules;
+    m_shadow.models = state.models;
+    m_shadow.mode = state.mode;
+    m_shadow.currentRuleId = state.currentRuleId;
+    m_shadow.currentModelId = state.currentModelId;
+    m_shadow.environment = state.environment;
+}
+
+void JournalRecorder::recordEnvironment(const EnvironmentField &environment, double time)
+{
+    JournalRecord resize = JournalRecord::make(JournalRecord::Type::EnvironmentResize, time);
+    resize.size.width = environment.width();
+    resize.size.height = environment.height();
+    append(resize);
+
+    // Then every cell that differs from the defaults, tile by tile.
+    std::vector<quint8> tile(size_t(EnvironmentField::TileCells) * EnvironmentFactorCount);
+    for (int ty = 0; ty < environment.tilesY(); ++ty)
+    {
+        for (int tx = 0; tx < environment.tilesX(); ++tx)
+        {
+            if (!environment.copyTile(tx, ty, tile.data()))
+                continue;
+            for (int i = 0; i < EnvironmentField::TileCells; ++i)
+            {
+                const QPoint cell(tx * EnvironmentField::TileSize + i % EnvironmentField::TileSize,
+                                  ty * EnvironmentField::TileSize + i / EnvironmentField::TileSize);
+                if (!environment.contains(cell))
+                    continue;
+                bool isDefault = true;
+                for (int f = 0; f < EnvironmentFactorCount && isDefault; ++f)
+                {
+                    isDefault = tile[size_t(f * EnvironmentField::TileCells + i)] == DefaultFactorValue;
+                }
+                if (!isDefault)
+                    recordCell(cell, environment.at(cell), time);
+            }
+        }
+    }
+}
+
+bool ReplayJournal::replay(const QString &path, SimulationState &state, const Options &options, QString *errorMessage)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        setError(errorMessage, QStringLiteral("无法打开回放日志: %1").arg(file.errorString()));
+        return false;
+    }
+    const qint64 size = file.size();
+    if (uchar *mapped = size > 0 ? file.map(0, size) : nullptr)
+    {
+        const bool ok = replay(reinterpret_cast<const char *>(mapped), size, state, options, errorMessage);
+        file.unmap(mapped);
+        return ok;
+    }
+    const QByteArray data = file.readAll();
+    return replay(data.constData(), data.size(), state, options, errorMessage);
+}
+
+bool ReplayJournal::replay(const char *data, qint64 size, SimulationState &state, const Options &options, QString *errorMessage)
+{
+    if (size < kHeaderBytes || std::memcmp(data, kJournalMagic, sizeof(kJournalMagic)) != 0)
+    {
+        setError(errorMessage, QStringLiteral("不是回放日志文件"));
+        return false;
+    }
+    const quint32 version = qFromLittleEndian<quint32>(data + 8);
+    const quint32 recordSize = qFromLittleEndian<quint32>(data + 12);
+    quint32 mark;
+    std::memcpy(&mark, data + 16, sizeof(mark));
+    const quint32 scenarioBytes = qFromLittleEndian<quint32>(data + 36);
+    if (version != Version || recordSize != sizeof(JournalRecord))
+    {
+        setError(errorMessage, QStringLiteral("不支持的回放日志版本: %1").arg(version));
+        return false;
+    }
+    if (mark != kByteOrderMark)
+    {
+        setError(errorMessage, QStringLiteral("回放日志的字节序与本机不同"));
+        return false;
+    }
+    if (qint64(scenarioBytes) > size - kHeaderBytes)
+    {
+        setError(errorMessage, QStringLiteral("回放日志已损坏"));
+        return false;
+    }
+
+    SimulationState replayed;
+    if (!ScenarioFile::fromBinary(data + kHeaderBytes, scenarioBytes, replayed, errorMessage))
+        return false;
+    replayed.randomSeed = qFromLittleEndian<quint64>(data + 20);
+
+    const qint64 recordsStart = (kHeaderBytes + qint64(scenarioBytes) + recordSize - 1) / recordSize * recordSize;
+    const qint64 recordCount = qMax<qint64>(0, size - recordsStart) / recordSize;
+
+    AircraftStore &aircrafts = replayed.aircrafts;
+    TaskTable &tasks = replayed.tasks;
+    std::vector<QString> texts(1);
+    QByteArray pendingText;
+    QVector<QPoint> pendingRoute;
+    int routeAircraft = -1;
+    int routeWaypoints = 0;
+    AdjudicationRule pendingRule;
+    int ruleWeights = -1; // RuleWeight records still due for pendingRule
+    AdjudicationModel pendingModel;
+    int modelFactors = -1; // ModelFactor records still due for pendingModel
+    QStringList lines;
+
+    auto fail = [&](qint64 index) {
+        setError(errorMessage, QStringLiteral("回放日志第 %1 条记录无效").arg(index + 1));
+        return false;
+    };
+    auto aircraftIndex = [&](quint32 slot, quint32 generation) {
+        AircraftHandle handle;
+        handle.slot = slot;
+        handle.generation = generation;
+        return aircrafts.indexOf(handle);
+    };
+    auto text = [&](quint32 id) { return id < texts.size() ? texts[id] : QString(); };
+    // Catalog ids are handed out in order, so a new rule or model must get
+    // the recorded one.
+    auto commitRule = [&] {
+        ruleWeights = -1;
+        if (!AdjudicationEngine::compileRule(pendingRule))
+            return false;
+        if (AdjudicationRule *existing = replayed.rules.find(pendingRule.id))
+        {
+            *existing = pendingRule;
+            return true;
+        }
+        return replayed.rules.append(pendingRule) == pendingRule.id;
+    };
+    auto commitModel = [&] {
+        modelFactors = -1;
+        if (!AdjudicationEngine::compileModel(pendingModel))
+            return false;
+        if (AdjudicationModel *existing = replayed.models.find(pendingModel.id))
+        {
+            *existing = pendingModel;
+            return true;
+        }
+        return replayed.models.append(pendingModel) == pendingModel.id;
+    };
+    auto log = [&](int row, const QString &message) {
+        TaskLogEntry entry;
+        entry.aircraftName = aircrafts.name(tasks.aircraft(row));
+        entry.taskName = tasks.name(row);
+        entry.message = message;
+        entry.timestamp = QStringLiteral("T+%1s").arg(replayed.simulationTime);
+        replayed.logs.append(entry);
+    };
+
+    for (qint64 i = 0; i < recordCount; ++i)
+    {
+        JournalRecord record;
+        std::memcpy(&record, data + recordsStart + i * recordSize, sizeof(record));
+        if (record.time > options.untilTime)
+            break;
+
+        switch (record.type)
+        {
+        case JournalRecord::Type::Tick:
+            if (options.moveAircraft && record.time > replayed.simulationTime)
+                aircrafts.advance(record.time - replayed.simulationTime);
+            replayed.simulationTime = record.time;
+            break;
+        case JournalRecord::Type::Reset:
+            replayed.simulationTime = 0.0;
+            aircrafts.resetMotion();
+            tasks.resetStatuses();
+            replayed.logs.clear();
+            break;
+        case JournalRecord::Type::Adjudication:
+        {
+            const JournalRecord::Adjudication &a = record.adjudication;
+            const int index = aircraftIndex(a.aircraftSlot, a.aircraftGeneration);
+            if (index < 0 || a.task < 0 || a.task >= aircrafts.taskCount(index) || !validStatus(a.status)
+                || !validMode(a.mode))
+                return fail(i);
+            const int row = aircrafts.firstTask(index) + a.task;
+            tasks.setStatus(row, TaskStatus(a.status));
+            if (!options.buildLogs)
+                break;
+            if (a.flags & JournalRecord::NoRule)
+            {
+                log(row, QStringLiteral("未找到可用的裁决规则"));
+            }
+            else if (a.flags & JournalRecord::NoModel)
+            {
+                log(row, QStringLiteral("未找到可用的裁决模型"));
+            }
+            else if (a.flags & JournalRecord::Cancelled)
+            {
+                log(row, QStringLiteral("人工裁决被取消，任务失败"));
+            }
+            else
+            {
+                lines.clear();
+                AdjudicationEngine::describeOutcome(a.requirements, a.outcomes, a.score, a.threshold, &lines);
+                for (const QString &line : lines)
+                {
+                    log(row, line);
+                }
+                log(row, TaskStatus(a.status) == TaskStatus::Success ? QStringLiteral("任务裁决成功") : QStringLiteral("任务裁决失败"));
+            }
+            break;
+        }
+        case JournalRecord::Type::Text:
+        {
+            const JournalRecord::Text &t = record.text;
+            if (t.offset != quint32(pendingText.size()) || t.id != texts.size())
+                return fail(i);
+            pendingText.append(t.bytes, int(qMin<quint32>(sizeof(t.bytes), t.length - t.offset)));
+            if (quint32(pendingText.size()) >= t.length)
+            {
+                texts.push_back(QString::fromUtf8(pendingText));
+                pendingText.clear();
+            }
+            break;
+        }
+        case JournalRecord::Type::CellEdit:
+            replayed.environment.set(QPoint(record.cell.x, record.cell.y), unpackFactors(record.cell.factors));
+            break;
+        case JournalRecord::Type::EnvironmentResize:
+            replayed.environment.resize(record.size.width, record.size.height);
+            break;
+        case JournalRecord::Type::Route:
+            routeAircraft = aircraftIndex(record.route.aircraftSlot, record.route.aircraftGeneration);
+            routeWaypoints = record.route.waypoints;
+            if (routeAircraft < 0 || routeWaypoints < 0)
+                return fail(i);
+            pendingRoute.clear();
+            if (routeWaypoints == 0)
+                aircrafts.setRoute(routeAircraft, pendingRoute);
+            break;
+        case JournalRecord::Type::Waypoints:
+            if (routeAircraft < 0 || record.waypoints.count > JournalRecord::WaypointsPerRecord)
+                return fail(i);
+            for (int p = 0; p < record.waypoints.count; ++p)
+            {
+                pendingRoute.append(QPoint(record.waypoints.xy[2 * p], record.waypoints.xy[2 * p + 1]));
+            }
+            if (pendingRoute.size() >= routeWaypoints)
+            {
+                aircrafts.setRoute(routeAircraft, pendingRoute);
+                routeAircraft = -1;
+            }
+            break;
+        case JournalRecord::Type::Speed:
+        {
+            const int index = aircraftIndex(record.speed.aircraftSlot, record.speed.aircraftGeneration);
+            if (index < 0)
+                return fail(i);
+            aircrafts.setSecondsPerStep(index, record.speed.secondsPerStep);
+            break;
+        }
+        case JournalRecord::Type::TasksCleared:
+        {
+            const int index = aircraftIndex(record.taskRow.aircraftSlot, record.taskRow.aircraftGeneration);
+            if (index < 0)
+                return fail(i);
+            while (aircrafts.taskCount(index) > 0)
+            {
+                tasks.remove(aircrafts, index, aircrafts.taskCount(index) - 1);
+            }
+            break;
+        }
+        case JournalRecord::Type::TaskAppended:
+        {
+            const JournalRecord::TaskRow &r = record.taskRow;
+            const int index = aircraftIndex(r.aircraftSlot, r.aircraftGeneration);
+            if (index < 0)
+                return fail(i);
+            Task task;
+            task.name = text(r.name);
+            task.executionTime = r.executionTime;
+            task.setRequirementMask(r.requirements);
+            task.targetCell = QPoint(r.targetX, r.targetY);
+            if (!TaskTable::canPackCell(task.targetCell) || !validStatus(r.status))
+                return fail(i);
+            task.ruleId = r.rule;
+            task.status = TaskStatus(r.status);
+            tasks.insert(aircrafts, index, aircrafts.taskCount(index), task);
+            break;
+        }
+        case JournalRecord::Type::RuleEdit:
+        {
+            const JournalRecord::Rule &r = record.rule;
+            if (ruleWeights >= 0 || r.weights < 0)
+                return fail(i);
+            pendingRule = AdjudicationRule();
+            pendingRule.id = r.rule;
+            pendingRule.name = text(r.name);
+            pendingRule.expression = text(r.expression);
+            pendingRule.successThreshold = r.threshold;
+            ruleWeights = r.weights;
+            if (ruleWeights == 0 && !commitRule())
+                return fail(i);
+            break;
+        }
+        case JournalRecord::Type::RuleWeight:
+        {
+            const JournalRecord::RuleWeight &w = record.ruleWeight;
+            if (ruleWeights <= 0 || w.rule != pendingRule.id)
+                return fail(i);
+            pendingRule.behaviorWeights.insert(text(w.key), w.weight);
+            if (--ruleWeights == 0 && !commitRule())
+                return fail(i);
+            break;
+        }
+        case JournalRecord::Type::RuleRemoved:
+        {
+            const int index = replayed.rules.indexOf(record.rule.rule);
+            if (index >= 0)
+                replayed.rules.removeAt(index);
+            break;
+        }
+        case JournalRecord::Type::ModelEdit:
+        {
+            const JournalRecord::Model &m = record.model;
+            if (modelFactors >= 0 || m.factors < 0)
+                return fail(i);
+            pendingModel = AdjudicationModel();
+            pendingModel.id = m.model;
+            pendingModel.name = text(m.name);
+            pendingModel.environmentWeight = m.environmentWeight;
+            modelFactors = m.factors;
+            if (modelFactors == 0 && !commitModel())
+                return fail(i);
+            break;
+        }
+        case JournalRecord::Type::ModelFactor:
+        {
+            const JournalRecord::ModelFactor &f = record.modelFactor;
+            if (modelFactors <= 0 || f.model != pendingModel.id)
+                return fail(i);
+            pendingModel.factorKeys.append(text(f.key));
+            if (--modelFactors == 0 && !commitModel())
+                return fail(i);
+            break;
+        }
+        case JournalRecord::Type::ModelRemoved:
+        {
+            const int index = replayed.models.indexOf(record.model.model);
+            if (index >= 0)
+                replayed.models.removeAt(index);
+            break;
+        }
+        case JournalRecord::Type::Selection:
+            if (!validMode(record.selection.mode))
+                return fail(i);
+            replayed.mode = AdjudicationMode(record.selection.mode);
+            replayed.currentRuleId = record.selection.currentRule;
+            replayed.currentModelId = record.selection.currentModel;
+            break;
+        case JournalRecord::Type::RulingQueued:
+        {
+            const JournalRecord::Queued &q = record.queued;
+            const int index = aircraftIndex(q.aircraftSlot, q.aircraftGeneration);
+            if (index < 0 || q.task < 0 || q.task >= aircrafts.taskCount(index))
+                return fail(i);
+            const int row = aircrafts.firstTask(index) + q.task;
+            tasks.setStatus(row, TaskStatus::AwaitingRuling);
+            if (options.buildLogs)
+                log(row, QStringLiteral("等待人工裁决"));
+            break;
+        }
+        case JournalRecord::Type::Hold:
+        {
+            const int index = aircraftIndex(record.hold.aircraftSlot, record.hold.aircraftGeneration);
+            if (index < 0)
+                return fail(i);
+            aircrafts.setHeld(index, record.hold.held != 0);
+            break;
+        }
+        default:
+            return fail(i);
+        }
+    }
+
+    replayed.paused = state.paused;
+    state = std::move(replayed);
+    return true;
+}
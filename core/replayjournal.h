@@ -0,0 +1,271 @@
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <QtGlobal>
+
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "models.h"
+
+// One 64-byte journal entry: the simulation time it happened at, its type
+// and a type-specific payload. Aircraft are named by their AircraftHandle
+// (slot, generation), tasks by their index within the aircraft's tasks,
+// rules and models by id, strings by the id of earlier Text records.
+struct JournalRecord
+{
+    enum class Type : quint8
+    {
+        Tick,              // time advanced to `time`; aircraft moved
+        Reset,             // back to time 0: tasks Pending, aircraft at route start, log cleared
+        Adjudication,      // one task ruled: inputs, outcome and status
+        Text,              // a chunk of a string that later records refer to by id
+        CellEdit,          // one environment cell set
+        EnvironmentResize, // every cell back to the defaults at a new size
+        Route,             // an aircraft's new route; Waypoints records follow
+        Waypoints,
+        Speed,
+        TasksCleared,      // an aircraft's task list is rewritten; TaskAppended records follow
+        TaskAppended,
+        RuleEdit,          // rule added or changed; RuleWeight records follow
+        RuleWeight,
+        RuleRemoved,
+        Selection,         // adjudication mode, current rule and model
+        RulingQueued,      // a task now awaits a manual ruling
+        Hold,              // an aircraft held or released for pending rulings
+        ModelEdit,         // model added or changed; ModelFactor records follow
+        ModelFactor,
+        ModelRemoved
+    };
+
+    // Adjudication::flags
+    enum Flag : quint8
+    {
+        NoRule = 0x1,
+        NoModel = 0x2,
+        Cancelled = 0x4 // manual ruling cancelled
+    };
+
+    struct Adjudication
+    {
+        double score;
+        quint32 aircraftSlot;
+        quint32 aircraftGeneration;
+        qint32 task;
+        quint32 rule;
+        quint32 model;
+        qint32 threshold;
+        quint8 requirements; // TaskRequirementFlag bits
+        quint8 outcomes;     // TaskRequirementFlag bits of the events that succeeded
+        quint8 status;       // TaskStatus
+        quint8 mode;         // AdjudicationMode
+        quint8 manual;       // ManualAdjudicationState::bits()
+        quint8 flags;
+        quint8 factors[EnvironmentFactorCount]; // at the target cell
+    };
+    struct Text
+    {
+        quint32 id;
+        quint32 length; // UTF-8 bytes of the whole string
+        quint32 offset; // of this chunk
+        char bytes[36];
+    };
+    struct Cell
+    {
+        qint32 x;
+        qint32 y;
+        quint8 factors[EnvironmentFactorCount];
+    };
+    struct Size
+    {
+        qint32 width;
+        qint32 height;
+    };
+    struct Route
+    {
+        quint32 aircraftSlot;
+        quint32 aircraftGeneration;
+        qint32 waypoints;
+    };
+    struct Waypoints
+    {
+        qint32 count;
+        qint32 xy[10];
+    };
+    struct Speed
+    {
+        quint32 aircraftSlot;
+        quint32 aircraftGeneration;
+        double secondsPerStep;
+    };
+    struct TaskRow
+    {
+        quint32 aircraftSlot;
+        quint32 aircraftGeneration;
+        quint32 name;
+        qint32 executionTime;
+        qint32 targetX;
+        qint32 targetY;
+        quint32 rule;
+        quint8 requirements;
+        quint8 status;
+    };
+    struct Rule
+    {
+        quint32 rule;
+        quint32 name;
+        quint32 expression;
+        qint32 threshold;
+        qint32 weights; // RuleWeight records that follow
+    };
+    struct RuleWeight
+    {
+        quint32 rule;
+        quint32 key; // behaviorWeights key
+        qint32 weight;
+    };
+    struct Model
+    {
+        double environmentWeight;
+        quint32 model;
+        quint32 name;
+        qint32 factors; // ModelFactor records that follow
+    };
+    struct ModelFactor
+    {
+        quint32 model;
+        quint32 key; // one factorKeys entry, in order
+    };
+    struct Selection
+    {
+        quint32 currentRule;
+        quint32 currentModel;
+        quint8 mode;
+    };
+    struct Queued
+    {
+        quint32 aircraftSlot;
+        quint32 aircraftGeneration;
+        qint32 task;
+    };
+    struct Hold
+    {
+        quint32 aircraftSlot;
+        quint32 aircraftGeneration;
+        quint8 held;
+    };
+
+    static constexpr int WaypointsPerRecord = 5;
+
+    double time;
+    Type type;
+    quint8 reserved[7];
+    union
+    {
+        Adjudication adjudication;
+        Text text;
+        Cell cell;
+        Size size;
+        Route route;
+        Waypoints waypoints;
+        Speed speed;
+        TaskRow taskRow; // TasksCleared uses only the aircraft
+        Rule rule; // RuleRemoved uses only the rule
+        RuleWeight ruleWeight;
+        Model model; // ModelRemoved uses only the model
+        ModelFactor modelFactor;
+        Selection selection;
+        Queued queued;
+        Hold hold;
+    };
+
+    // A zero-filled record.
+    static JournalRecord make(Type type, double time);
+};
+
+Q_STATIC_ASSERT(sizeof(JournalRecord) == 64);
+Q_STATIC_ASSERT(std::is_trivially_copyable<JournalRecord>::value);
+
+// Append-only run journal. The file (magic "AFJRNL01") holds a header, the
+// scenario the run started from in ScenarioFile's binary form, then
+// JournalRecords back to back from a 64-byte aligned offset:
+//   char[8] magic, quint32 version, quint32 record size,
+//   quint32 byte-order mark 0x01020304 (host order), quint64 seed,
+//   quint64 replication, quint32 scenario bytes, scenario, padding
+// Header integers are little-endian; records are written in host byte
+// order and the mark rejects journals from a host of the other order.
+//
+// SimulationCore records adjudications, ticks and resets as they happen;
+// edits made outside the core are found by recordEdits(), which compares
+// the state with a copy taken at the last call.
+class JournalRecorder
+{
+public:
+    JournalRecorder() = default;
+    ~JournalRecorder();
+
+    JournalRecorder(const JournalRecorder &) = delete;
+    JournalRecorder &operator=(const JournalRecorder &) = delete;
+
+    // `state` must be the state loaded from `scenario`, at time 0.
+    bool open(const QString &path, const QByteArray &scenario, const SimulationState &state, quint64 replication,
+              QString *errorMessage = nullptr);
+    void close();
+    bool isOpen() const { return m_file.isOpen(); }
+    // Writes buffered records to the file.
+    bool flush();
+    // Set by the first failed write; later records are dropped. Cleared by open().
+    bool hasError() const { return !m_error.isEmpty(); }
+    const QString &errorString() const { return m_error; }
+
+    void recordTick(double time);
+    void recordReset();
+    void recordAdjudication(const JournalRecord::Adjudication &adjudication, double time);
+    void recordCell(const QPoint &cell, const EnvironmentFactors &factors, double time);
+    void recordQueued(AircraftHandle aircraft, int task, double time);
+    void recordHold(AircraftHandle aircraft, bool held, double time);
+    // Records every route, speed, task list, rule, model and selection
+    // change, and a replaced environment, since the previous call.
+    void recordEdits(const SimulationState &state);
+
+private:
+    void append(const JournalRecord &record);
+    // Id of `text`, writing Text records the first time it is seen.
+    quint32 textId(const QString &text, double time);
+    void recordEnvironment(const EnvironmentField &environment, double time);
+
+    QFile m_file;
+    std::vector<JournalRecord> m_buffer;
+    QHash<QString, quint32> m_texts;
+    QString m_error;
+    // State as of the last recordEdits(); implicitly shared, so cheap.
+    SimulationState m_shadow;
+};
+
+// Rebuilds a journaled run from its records alone: statuses, log, routes,
+// tasks, rules, models and environment edits are applied as recorded and
+// nothing is adjudicated again.
+class ReplayJournal
+{
+public:
+    struct Options
+    {
+        // Stop before the first record later than this.
+        double untilTime = std::numeric_limits<double>::infinity();
+        // Regenerate the log text; statuses alone replay much faster.
+        bool buildLogs = true;
+        // Move aircraft on Tick records so positions match the run.
+        bool moveAircraft = true;
+    };
+
+    static constexpr quint32 Version = 2;
+
+    // On failure `state` is left unchanged.
+    static bool replay(const QString &path, SimulationState &state, const Options &options, QString *errorMessage = nullptr);
+    static bool replay(const char *data, qint64 size, SimulationState &state, const Options &options,
+                       QString *errorMessage = nullptr);
+};
@@ -0,0 +1,124 @@
+﻿#include "replicationrunner.h"
+
+#include <QThread>
+#include <QtMath>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace
+{
+OutcomeEstimate estimate(const QString &aircraftName, const QString &taskName, int successes, int trials)
+{
+    OutcomeEstimate e;
+    e.aircraftName = aircraftName;
+    e.taskName = taskName;
+    e.successes = successes;
+    e.trials = trials;
+    if (trials <= 0)
+    {
+        return e;
+    }
+
+    const double z = 1.959963984540054;
+    const double n = trials;
+    const double p = successes / n;
+    const double denom = 1.0 + z * z / n;
+    const double center = (p + z * z / (2.0 * n)) / denom;
+    const double half = z * qSqrt(p * (1.0 - p) / n + z * z / (4.0 * n * n)) / denom;
+    e.rate = p;
+    e.lower = qMax(0.0, center - half);
+    e.upper = qMin(1.0, center + half);
+    return e;
+}
+}
+
+ReplicationReport ReplicationRunner::run(const SimulationState &scenario,
+                                         const ReplicationSettings &settings)
+{
+    ReplicationReport report;
+    report.replications = qMax(0, settings.replications);
+    report.seed = settings.seed;
+
+    // Tallies are indexed by task row, which replications share with the scenario.
+    const int taskCount = scenario.tasks.size();
+    const int aircraftCount = scenario.aircrafts.size();
+
+    int threadCount = settings.threadCount > 0 ? settings.threadCount : QThread::idealThreadCount();
+    threadCount = qBound(1, threadCount, qMax(1, report.replications));
+
+    // Integer tallies summed per thread: addition order cannot change the result.
+    std::vector<std::vector<int>> taskSuccesses(threadCount, std::vector<int>(taskCount, 0));
+    std::vector<std::vector<int>> aircraftSuccesses(threadCount, std::vector<int>(aircraftCount, 0));
+    std::atomic<int> next(0);
+
+    auto worker = [&](int threadIndex) {
+        // Replications already keep every thread busy; each core ticks inline.
+        SimulationCore core;
+        core.setLoggingEnabled(false);
+        std::vector<int> &taskTally = taskSuccesses[threadIndex];
+        std::vector<int> &aircraftTally = aircraftSuccesses[threadIndex];
+
+        for (int replication = next++; replication < report.replications; replication = next++)
+        {
+            core.state() = scenario;
+            core.state().mode = AdjudicationMode::Stochastic;
+            core.state().randomSeed = settings.seed;
+            core.setReplication(quint64(replication));
+            core.reset();
+            core.runToCompletion(settings.maxSimulationTime);
+
+            const AircraftStore &aircrafts = core.state().aircrafts;
+            const TaskTable &tasks = core.state().tasks;
+            for (int a = 0; a < aircrafts.size(); ++a)
+            {
+                bool allSucceeded = true;
+                const int end = aircrafts.firstTask(a) + aircrafts.taskCount(a);
+                for (int row = aircrafts.firstTask(a); row < end; ++row)
+                {
+                    const bool ok = tasks.status(row) == TaskStatus::Success;
+                    taskTally[size_t(row)] += ok ? 1 : 0;
+                    allSucceeded = allSucceeded && ok;
+                }
+                aircraftTally[size_t(a)] += allSucceeded ? 1 : 0;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(size_t(threadCount - 1));
+    for (int i = 1; i < threadCount; ++i)
+    {
+        threads.emplace_back(worker, i);
+    }
+    worker(0);
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+
+    for (int a = 0; a < aircraftCount; ++a)
+    {
+        const AircraftStore &aircrafts = scenario.aircrafts;
+        int aircraftTotal = 0;
+        for (int i = 0; i < threadCount; ++i)
+        {
+            aircraftTotal += aircraftSuccesses[size_t(i)][size_t(a)];
+        }
+        report.aircraft.append(estimate(aircrafts.name(a), QString(), aircraftTotal, report.replications));
+
+        const int end = aircrafts.firstTask(a) + aircrafts.taskCount(a);
+        for (int row = aircrafts.firstTask(a); row < end; ++row)
+        {
+            int taskTotal = 0;
+            for (int i = 0; i < threadCount; ++i)
+            {
+                taskTotal += taskSuccesses[size_t(i)][size_t(row)];
+            }
+            report.tasks.append(estimate(aircrafts.name(a), scenario.tasks.name(row), taskTotal, report.replications));
+        }
+    }
+
+    return report;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "simulationcore.h"
+
+struct ReplicationSettings
+{
+    int replications = 100;
+    int threadCount = 0; // 0 uses QThread::idealThreadCount()
+    quint64 seed = 1;
+    int maxSimulationTime = 3600;
+};
+
+struct OutcomeEstimate
+{
+    QString aircraftName;
+    QString taskName; // empty for per-aircraft estimates
+    int successes = 0;
+    int trials = 0;
+    double rate = 0.0;
+    double lower = 0.0; // 95% Wilson score interval
+    double upper = 0.0;
+};
+
+struct ReplicationReport
+{
+    int replications = 0;
+    quint64 seed = 0;
+    QVector<OutcomeEstimate> tasks;
+    QVector<OutcomeEstimate> aircraft; // every task of the aircraft succeeded
+};
+
+// Runs independent Stochastic-mode copies of a scenario on all cores.
+// Replication i always draws from random stream i, so a report depends only
+// on the seed and the replication count, never on the thread count.
+class ReplicationRunner
+{
+public:
+    // The scenario's environment field is shared read-only between threads.
+    static ReplicationReport run(const SimulationState &scenario,
+                                 const ReplicationSettings &settings);
+};
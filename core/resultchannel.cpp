@@ -0,0 +1,248 @@
+﻿#include "resultchannel.h"
+
+#include <atomic>
+#include <cstring>
+
+// Segment layout, shared with other processes: plain fields are written
+// once by open(), everything that changes afterwards is atomic.
+struct ResultChannelHeader
+{
+    char magic[8];
+    quint32 version;
+    quint32 slotBytes;
+    quint32 capacity;
+    std::atomic<quint32> open;       // 0 once the publisher has closed
+    std::atomic<quint64> published;  // records written so far
+    quint8 reserved[32];
+};
+
+struct ResultSlot
+{
+    static constexpr int Words = int(sizeof(ResultRecord) / sizeof(quint64));
+
+    std::atomic<quint64> sequence; // 2n + 1 while record n is written, 2n + 2 once it is
+    std::atomic<quint64> words[Words];
+};
+
+Q_STATIC_ASSERT(sizeof(ResultChannelHeader) == 64);
+Q_STATIC_ASSERT(sizeof(ResultSlot) == 128);
+Q_STATIC_ASSERT(sizeof(ResultRecord) % sizeof(quint64) == 0);
+Q_STATIC_ASSERT(std::atomic<quint64>::is_always_lock_free);
+
+namespace
+{
+const char kChannelMagic[8] = {'A', 'F', 'R', 'S', 'L', 'T', '0', '1'};
+constexpr int kMaxCapacity = 1 << 20; // 128 MB of slots
+
+void setError(QString *error, const QString &message)
+{
+    if (error)
+        *error = message;
+}
+
+// Bytes UTF-8 needs for the code point starting at text[i].
+int utf8Length(const QChar *text, int i, int size, uint *codePoint)
+{
+    const ushort unit = text[i].unicode();
+    if (QChar::isHighSurrogate(unit) && i + 1 < size && QChar::isLowSurrogate(text[i + 1].unicode()))
+    {
+        *codePoint = QChar::surrogateToUcs4(unit, text[i + 1].unicode());
+        return 4;
+    }
+    *codePoint = QChar::isSurrogate(unit) ? 0xfffd : unit;
+    return *codePoint < 0x80 ? 1 : *codePoint < 0x800 ? 2 : 3;
+}
+}
+
+void ResultRecord::setName(char *field, int fieldSize, const QString &text)
+{
+    const QChar *chars = text.constData();
+    const int size = text.size();
+    int out = 0;
+    for (int i = 0; i < size;)
+    {
+        uint c = 0;
+        const int bytes = utf8Length(chars, i, size, &c);
+        if (out + bytes > fieldSize)
+            break;
+        if (bytes == 1)
+        {
+            field[out++] = char(c);
+        }
+        else
+        {
+            static const uchar lead[] = {0, 0, 0xc0, 0xe0, 0xf0};
+            for (int b = bytes - 1; b > 0; --b)
+            {
+                field[out + b] = char(0x80 | (c & 0x3f));
+                c >>= 6;
+            }
+            field[out] = char(lead[bytes] | c);
+            out += bytes;
+        }
+        i += bytes == 4 ? 2 : 1;
+    }
+    std::memset(field + out, 0, size_t(fieldSize - out));
+}
+
+ResultPublisher::~ResultPublisher()
+{
+    close();
+}
+
+bool ResultPublisher::open(const QString &name, int capacity, QString *errorMessage)
+{
+    close();
+    if (capacity < 1 || capacity > kMaxCapacity)
+    {
+        setError(errorMessage, QStringLiteral("结果通道容量须在 1 到 %1 之间").arg(kMaxCapacity));
+        return false;
+    }
+    quint32 slotCount = 1;
+    while (slotCount < quint32(capacity))
+    {
+        slotCount <<= 1;
+    }
+
+    m_memory.setKey(name);
+    // Attaching and detaching a stale segment from a crashed run removes it
+    // if nobody else holds it.
+    if (m_memory.attach())
+        m_memory.detach();
+    if (!m_memory.create(int(sizeof(ResultChannelHeader) + slotCount * sizeof(ResultSlot))))
+    {
+        setError(errorMessage, QStringLiteral("无法创建结果通道 %1：%2").arg(name, m_memory.errorString()));
+        return false;
+    }
+
+    // A fresh segment is zero-filled on every platform Qt supports, but do
+    // not rely on it: zero sequences mean "nothing written".
+    char *base = static_cast<char *>(m_memory.data());
+    std::memset(base, 0, size_t(m_memory.size()));
+    m_header = reinterpret_cast<ResultChannelHeader *>(base);
+    m_slots = reinterpret_cast<ResultSlot *>(base + sizeof(ResultChannelHeader));
+    std::memcpy(m_header->magic, kChannelMagic, sizeof(kChannelMagic));
+    m_header->version = Version;
+    m_header->slotBytes = quint32(sizeof(ResultSlot));
+    m_header->capacity = slotCount;
+    m_header->published.store(0, std::memory_order_relaxed);
+    m_header->open.store(1, std::memory_order_release);
+    m_mask = slotCount - 1;
+    m_next = 0;
+    return true;
+}
+
+void ResultPublisher::close()
+{
+    if (!m_header)
+        return;
+    m_header->open.store(0, std::memory_order_release);
+    m_header = nullptr;
+    m_slots = nullptr;
+    m_memory.detach();
+}
+
+void ResultPublisher::publish(const ResultRecord &record)
+{
+    quint64 words[ResultSlot::Words];
+    std::memcpy(words, &record, sizeof(record));
+
+    const quint64 n = m_next++;
+    ResultSlot &slot = m_slots[n & m_mask];
+    slot.sequence.store(2 * n + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (int w = 0; w < ResultSlot::Words; ++w)
+    {
+        slot.words[w].store(words[w], std::memory_order_relaxed);
+    }
+    slot.sequence.store(2 * n + 2, std::memory_order_release);
+    m_header->published.store(n + 1, std::memory_order_release);
+}
+
+ResultSubscriber::~ResultSubscriber()
+{
+    detach();
+}
+
+bool ResultSubscriber::attach(const QString &name, QString *errorMessage)
+{
+    detach();
+    m_memory.setKey(name);
+    if (!m_memory.attach(QSharedMemory::ReadOnly))
+    {
+        setError(errorMessage, QStringLiteral("无法连接结果通道 %1：%2").arg(name, m_memory.errorString()));
+        return false;
+    }
+
+    const char *base = static_cast<const char *>(m_memory.constData());
+    const auto *header = reinterpret_cast<const ResultChannelHeader *>(base);
+    const qint64 size = m_memory.size();
+    if (size < qint64(sizeof(ResultChannelHeader)) || std::memcmp(header->magic, kChannelMagic, sizeof(kChannelMagic)) != 0
+        || header->version != ResultPublisher::Version || header->slotBytes != sizeof(ResultSlot)
+        || header->capacity == 0 || (header->capacity & (header->capacity - 1)) != 0
+        || size < qint64(sizeof(ResultChannelHeader) + quint64(header->capacity) * sizeof(ResultSlot)))
+    {
+        setError(errorMessage, QStringLiteral("%1 不是可识别的结果通道").arg(name));
+        m_memory.detach();
+        return false;
+    }
+
+    m_header = header;
+    m_slots = reinterpret_cast<const ResultSlot *>(base + sizeof(ResultChannelHeader));
+    m_capacity = header->capacity;
+    m_next = header->published.load(std::memory_order_acquire);
+    m_dropped = 0;
+    return true;
+}
+
+void ResultSubscriber::detach()
+{
+    if (!m_header)
+        return;
+    m_header = nullptr;
+    m_slots = nullptr;
+    m_memory.detach();
+}
+
+bool ResultSubscriber::isPublisherOpen() const
+{
+    return m_header && m_header->open.load(std::memory_order_acquire) != 0;
+}
+
+int ResultSubscriber::read(ResultRecord *records, int max)
+{
+    if (!m_header)
+        return 0;
+    const quint64 published = m_header->published.load(std::memory_order_acquire);
+    if (published - m_next > m_capacity)
+    {
+        m_dropped += published - m_capacity - m_next;
+        m_next = published - m_capacity;
+    }
+
+    int count = 0;
+    quint64 words[ResultSlot::Words];
+    for (; count < max && m_next < published; ++m_next)
+    {
+        const ResultSlot &slot = m_slots[m_next & (m_capacity - 1)];
+        const quint64 expected = 2 * m_next + 2;
+        // Anything else means the publisher has lapped us onto a newer record.
+        if (slot.sequence.load(std::memory_order_acquire) != expected)
+        {
+            ++m_dropped;
+            continue;
+        }
+        for (int w = 0; w < ResultSlot::Words; ++w)
+        {
+            words[w] = slot.words[w].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != expected)
+        {
+            ++m_dropped;
+            continue;
+        }
+        std::memcpy(&records[count++], words, sizeof(ResultRecord));
+    }
+    return count;
+}
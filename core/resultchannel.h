@@ -0,0 +1,116 @@
+#pragma once
+
+#include <QSharedMemory>
+#include <QString>
+#include <QtGlobal>
+
+#include <type_traits>
+
+// One adjudication result as external displays see it. Aircraft are named
+// by their AircraftHandle (slot, generation) and, for display, by name;
+// names are UTF-8, NUL-padded and cut at a character boundary when longer
+// than the field.
+struct ResultRecord
+{
+    double time;  // simulation time of the ruling
+    double score;
+    quint32 aircraftSlot;
+    quint32 aircraftGeneration;
+    qint32 task;  // index within the aircraft's tasks
+    qint32 threshold;
+    quint8 requirements; // TaskRequirementFlag bits
+    quint8 outcomes;     // TaskRequirementFlag bits of the events that succeeded
+    quint8 status;       // TaskStatus
+    quint8 mode;         // AdjudicationMode
+    quint8 flags;        // JournalRecord::Flag
+    quint8 manual;       // ManualAdjudicationState::bits(), Manual mode
+    quint8 reserved[2];
+    char aircraftName[40];
+    char taskName[40];
+
+    QString aircraftNameString() const { return QString::fromUtf8(aircraftName, int(qstrnlen(aircraftName, sizeof(aircraftName)))); }
+    QString taskNameString() const { return QString::fromUtf8(taskName, int(qstrnlen(taskName, sizeof(taskName)))); }
+    // Copies `text` into a name field without allocating.
+    static void setName(char *field, int fieldSize, const QString &text);
+};
+
+Q_STATIC_ASSERT(sizeof(ResultRecord) == 120);
+Q_STATIC_ASSERT(std::is_trivially_copyable<ResultRecord>::value);
+
+struct ResultChannelHeader;
+struct ResultSlot;
+
+// Writes ResultRecords into a ring in shared memory that any number of
+// ResultSubscribers, in this or other processes, read without locks. The
+// segment (magic "AFRSLT01") holds a 64-byte header, then `capacity`
+// 128-byte slots, each a sequence number and the record as 64-bit words.
+// Record n goes to slot n % capacity: its sequence is set odd while the
+// words are written and to 2n + 2 once they are; the header's published
+// count then moves to n + 1. The publisher never waits: a reader more
+// than `capacity` records behind loses the oldest ones.
+class ResultPublisher
+{
+public:
+    static constexpr quint32 Version = 1;
+    static constexpr int DefaultCapacity = 65536;
+    // Shared memory key displays attach to unless told otherwise.
+    static constexpr const char *DefaultName = "ruling-results";
+
+    ResultPublisher() = default;
+    ~ResultPublisher();
+
+    ResultPublisher(const ResultPublisher &) = delete;
+    ResultPublisher &operator=(const ResultPublisher &) = delete;
+
+    // Creates the segment `name` with room for `capacity` records, rounded
+    // up to a power of two. A segment left behind by a crashed publisher
+    // with no readers attached is replaced.
+    bool open(const QString &name, int capacity = DefaultCapacity, QString *errorMessage = nullptr);
+    // Marks the channel closed for readers and detaches.
+    void close();
+    bool isOpen() const { return m_header != nullptr; }
+
+    void publish(const ResultRecord &record);
+    quint64 publishedCount() const { return m_next; }
+
+private:
+    QSharedMemory m_memory;
+    ResultChannelHeader *m_header = nullptr;
+    ResultSlot *m_slots = nullptr;
+    quint64 m_mask = 0;
+    quint64 m_next = 0;
+};
+
+// Tails a ResultPublisher's ring, starting from the records published after
+// attach(). Each subscriber keeps its own position; readers never write to
+// the segment, so they do not slow the publisher or each other.
+class ResultSubscriber
+{
+public:
+    ResultSubscriber() = default;
+    ~ResultSubscriber();
+
+    ResultSubscriber(const ResultSubscriber &) = delete;
+    ResultSubscriber &operator=(const ResultSubscriber &) = delete;
+
+    bool attach(const QString &name, QString *errorMessage = nullptr);
+    void detach();
+    bool isAttached() const { return m_header != nullptr; }
+    // False once the publisher has closed the channel; records published
+    // before that can still be read.
+    bool isPublisherOpen() const;
+
+    // Copies up to `max` unread records, oldest first, into `records` and
+    // returns how many. 0 means nothing new.
+    int read(ResultRecord *records, int max);
+    // Records overwritten before this subscriber got to them.
+    quint64 droppedCount() const { return m_dropped; }
+
+private:
+    QSharedMemory m_memory;
+    const ResultChannelHeader *m_header = nullptr;
+    const ResultSlot *m_slots = nullptr;
+    quint64 m_capacity = 0;
+    quint64 m_next = 0;
+    quint64 m_dropped = 0;
+};
@@ -0,0 +1,642 @@
+﻿#include "ruleprogram.h"
+
+#include <QHash>
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+// Indexed by RuleInput.
+const char *const kInputNames[RuleProgram::InputCount] = {
+    "fire",
+    "hit",
+    "detect",
+    "jam",
+    "requiresFire",
+    "requiresHit",
+    "requiresDetection",
+    "requiresJam",
+    "oceanDepth",
+    "airDryness",
+    "emInterference",
+    "temperature",
+    "humidity",
+    "base",
+};
+
+int inputIndex(const QStringRef &name)
+{
+    for (int i = 0; i < RuleProgram::InputCount; ++i)
+    {
+        if (name == QLatin1String(kInputNames[i]))
+            return i;
+    }
+    return -1;
+}
+}
+
+// Shared by the interpreter and by constant folding, so a folded
+// sub-expression gives exactly the value it would have at run time.
+inline double RuleProgram::apply(Op op, double a, double b, double c)
+{
+    switch (op)
+    {
+    case Op::Add:
+        return a + b;
+    case Op::Sub:
+        return a - b;
+    case Op::Mul:
+        return a * b;
+    case Op::Div:
+        return b == 0.0 ? 0.0 : a / b;
+    case Op::Neg:
+        return -a;
+    case Op::Not:
+        return a == 0.0 ? 1.0 : 0.0;
+    case Op::Less:
+        return a < b ? 1.0 : 0.0;
+    case Op::LessEqual:
+        return a <= b ? 1.0 : 0.0;
+    case Op::Greater:
+        return a > b ? 1.0 : 0.0;
+    case Op::GreaterEqual:
+        return a >= b ? 1.0 : 0.0;
+    case Op::Equal:
+        return a == b ? 1.0 : 0.0;
+    case Op::NotEqual:
+        return a != b ? 1.0 : 0.0;
+    case Op::And:
+        return a != 0.0 && b != 0.0 ? 1.0 : 0.0;
+    case Op::Or:
+        return a != 0.0 || b != 0.0 ? 1.0 : 0.0;
+    case Op::Min:
+        return std::min(a, b);
+    case Op::Max:
+        return std::max(a, b);
+    case Op::Abs:
+        return a < 0.0 ? -a : a;
+    case Op::Clamp:
+        return std::min(std::max(a, b), c);
+    case Op::Select:
+        return a != 0.0 ? b : c;
+    }
+    return 0.0;
+}
+
+double RuleProgram::evaluate(const double *inputs) const
+{
+    if (m_code.empty())
+    {
+        // A bare input or constant.
+        return m_result < InputCount ? inputs[m_result] : m_constants[size_t(m_result - InputCount)];
+    }
+
+    double r[MaxRegisters];
+    std::memcpy(r, inputs, sizeof(double) * InputCount);
+    if (!m_constants.empty())
+    {
+        std::memcpy(r + InputCount, m_constants.data(), sizeof(double) * m_constants.size());
+    }
+    for (const Instruction &ins : m_code)
+    {
+        r[ins.dst] = apply(ins.op, r[ins.a], r[ins.b], r[ins.c]);
+    }
+    return r[m_result];
+}
+
+QStringList RuleProgram::inputNames()
+{
+    QStringList names;
+    for (const char *name : kInputNames)
+    {
+        names << QLatin1String(name);
+    }
+    return names;
+}
+
+// Recursive-descent parser that emits code as it goes. Operands are
+// numbered in three spaces while parsing (inputs, constants, temporaries)
+// and mapped onto the final register layout once the constant pool is known.
+class RuleCompiler
+{
+public:
+    RuleCompiler(const QString &source, const QMap<QString, int> &weights)
+        : m_source(source)
+        , m_weights(weights)
+    {
+    }
+
+    bool compile(RuleProgram *program, QString *errorMessage)
+    {
+        next();
+        const Value result = parseExpression();
+        if (!m_failed && m_token.kind != Token::End)
+        {
+            fail(QStringLiteral("多余的内容 '%1'").arg(m_token.text.toString()));
+        }
+        const int resultOperand = m_failed ? 0 : operand(result);
+        const int registers = RuleProgram::InputCount + int(m_constants.size()) + m_maxTemps;
+        if (!m_failed && registers > RuleProgram::MaxRegisters)
+        {
+            m_errorColumn = 1;
+            fail(QStringLiteral("表达式过于复杂"));
+        }
+        if (m_failed)
+        {
+            if (errorMessage)
+            {
+                *errorMessage = QStringLiteral("第 %1 列: %2").arg(m_errorColumn).arg(m_error);
+            }
+            return false;
+        }
+
+        RuleProgram compiled;
+        compiled.m_constants = m_constants;
+        compiled.m_registerCount = registers;
+        compiled.m_result = resolve(resultOperand);
+        compiled.m_hasResult = true;
+        compiled.m_code.reserve(m_code.size());
+        for (const PendingInstruction &p : m_code)
+        {
+            compiled.m_code.push_back({p.op, quint8(resolve(p.dst)), quint8(resolve(p.a)), quint8(resolve(p.b)),
+                                       quint8(resolve(p.c))});
+        }
+        *program = std::move(compiled);
+        return true;
+    }
+
+private:
+    using Op = RuleProgram::Op;
+
+    enum : int
+    {
+        ConstantBase = 1 << 16,
+        TempBase = 2 << 16
+    };
+
+    struct Token
+    {
+        enum Kind
+        {
+            End,
+            Number,
+            Identifier,
+            Symbol
+        };
+        Kind kind = End;
+        QStringRef text;
+        double number = 0.0;
+        int position = 0;
+    };
+
+    // A parsed sub-expression: either a compile-time constant or an operand.
+    struct Value
+    {
+        bool constant = true;
+        double k = 0.0;
+        int operand = 0;
+
+        static Value of(double v) { return {true, v, 0}; }
+        static Value at(int operand) { return {false, 0.0, operand}; }
+    };
+
+    // Counts one level of parser recursion for as long as it lives.
+    struct Nesting
+    {
+        explicit Nesting(RuleCompiler &compiler)
+            : m_compiler(compiler)
+        {
+            ++m_compiler.m_depth;
+        }
+        ~Nesting() { --m_compiler.m_depth; }
+
+        RuleCompiler &m_compiler;
+    };
+
+    struct PendingInstruction
+    {
+        Op op;
+        int dst;
+        int a;
+        int b;
+        int c;
+    };
+
+    void fail(const QString &message)
+    {
+        if (m_failed)
+            return;
+        m_failed = true;
+        m_error = message;
+        if (m_errorColumn == 0)
+        {
+            m_errorColumn = m_token.position + 1;
+        }
+    }
+
+    void next()
+    {
+        int pos = m_pos;
+        while (pos < m_source.size() && m_source.at(pos).isSpace())
+            ++pos;
+
+        m_token = Token();
+        m_token.position = pos;
+        if (pos >= m_source.size())
+        {
+            m_pos = pos;
+            return;
+        }
+
+        const QChar ch = m_source.at(pos);
+        int end = pos + 1;
+        if (ch.isDigit() || (ch == QLatin1Char('.') && end < m_source.size() && m_source.at(end).isDigit()))
+        {
+            while (end < m_source.size() && (m_source.at(end).isDigit() || m_source.at(end) == QLatin1Char('.')))
+                ++end;
+            m_token.kind = Token::Number;
+            m_token.text = m_source.midRef(pos, end - pos);
+            bool ok = false;
+            m_token.number = m_token.text.toDouble(&ok);
+            if (!ok)
+            {
+                fail(QStringLiteral("无效的数字 '%1'").arg(m_token.text.toString()));
+            }
+        }
+        else if (ch.isLetter() || ch == QLatin1Char('_'))
+        {
+            while (end < m_source.size() && (m_source.at(end).isLetterOrNumber() || m_source.at(end) == QLatin1Char('_')))
+                ++end;
+            m_token.kind = Token::Identifier;
+            m_token.text = m_source.midRef(pos, end - pos);
+        }
+        else
+        {
+            static const char *const twoChar[] = {"<=", ">=", "==", "!=", "&&", "||"};
+            m_token.kind = Token::Symbol;
+            for (const char *symbol : twoChar)
+            {
+                if (m_source.midRef(pos, 2) == QLatin1String(symbol))
+                {
+                    end = pos + 2;
+                    break;
+                }
+            }
+            m_token.text = m_source.midRef(pos, end - pos);
+            if (end == pos + 1 && !QStringLiteral("+-*/<>!?:(),").contains(ch))
+            {
+                fail(QStringLiteral("无法识别的字符 '%1'").arg(ch));
+            }
+        }
+        m_pos = end;
+    }
+
+    bool isSymbol(const char *symbol) const
+    {
+        return m_token.kind == Token::Symbol && m_token.text == QLatin1String(symbol);
+    }
+    bool isWord(const char *word) const
+    {
+        return m_token.kind == Token::Identifier && m_token.text == QLatin1String(word);
+    }
+    void expect(const char *symbol)
+    {
+        if (!isSymbol(symbol))
+        {
+            fail(QStringLiteral("需要 '%1'").arg(QLatin1String(symbol)));
+            return;
+        }
+        next();
+    }
+
+    // Parentheses, calls, ?: and unary operators recurse, each holding one
+    // Nesting; past MaxDepth levels the expression is rejected before it can
+    // exhaust the stack.
+    bool checkDepth()
+    {
+        if (m_depth <= MaxDepth)
+            return true;
+        fail(QStringLiteral("表达式嵌套过深"));
+        return false;
+    }
+
+    int allocTemp()
+    {
+        const int temp = m_nextTemp++;
+        m_maxTemps = std::max(m_maxTemps, m_nextTemp);
+        return TempBase + temp;
+    }
+
+    int operand(const Value &value)
+    {
+        if (!value.constant)
+            return value.operand;
+
+        quint64 bits;
+        std::memcpy(&bits, &value.k, sizeof(bits));
+        auto it = m_constantIndex.constFind(bits);
+        if (it != m_constantIndex.constEnd())
+            return ConstantBase + it.value();
+        const int index = int(m_constants.size());
+        m_constants.push_back(value.k);
+        m_constantIndex.insert(bits, index);
+        return ConstantBase + index;
+    }
+
+    static int arity(Op op)
+    {
+        switch (op)
+        {
+        case Op::Neg:
+        case Op::Not:
+        case Op::Abs:
+            return 1;
+        case Op::Clamp:
+        case Op::Select:
+            return 3;
+        default:
+            return 2;
+        }
+    }
+
+    int resolve(int operand) const
+    {
+        if (operand >= TempBase)
+            return RuleProgram::InputCount + int(m_constants.size()) + (operand - TempBase);
+        if (operand >= ConstantBase)
+            return RuleProgram::InputCount + (operand - ConstantBase);
+        return operand;
+    }
+
+    // `mark` is the temporary count before the operands were parsed; their
+    // temporaries are free again once this instruction has read them.
+    Value emit(Op op, int mark, const Value &a, const Value &b = Value::of(0), const Value &c = Value::of(0))
+    {
+        if (m_failed)
+            return Value::of(0);
+        if (a.constant && b.constant && c.constant)
+        {
+            m_nextTemp = mark;
+            return Value::of(RuleProgram::apply(op, a.k, b.k, c.k));
+        }
+        // Unused operand slots point at register 0; the interpreter ignores them.
+        const int oa = operand(a);
+        const int ob = arity(op) > 1 ? operand(b) : 0;
+        const int oc = arity(op) > 2 ? operand(c) : 0;
+        m_nextTemp = mark;
+        const int dst = allocTemp();
+        m_code.push_back({op, dst, oa, ob, oc});
+        return Value::at(dst);
+    }
+
+    Value parseExpression()
+    {
+        const int mark = m_nextTemp;
+        const Value condition = parseOr();
+        if (!isSymbol("?"))
+            return condition;
+        next();
+        const Nesting nesting(*this);
+        if (!checkDepth())
+            return Value::of(0);
+        const Value whenTrue = parseExpression();
+        expect(":");
+        const Value whenFalse = parseExpression();
+        return emit(Op::Select, mark, condition, whenTrue, whenFalse);
+    }
+
+    Value parseOr()
+    {
+        const int mark = m_nextTemp;
+        Value left = parseAnd();
+        while (isSymbol("||") || isWord("or"))
+        {
+            next();
+            left = emit(Op::Or, mark, left, parseAnd());
+        }
+        return left;
+    }
+
+    Value parseAnd()
+    {
+        const int mark = m_nextTemp;
+        Value left = parseComparison();
+        while (isSymbol("&&") || isWord("and"))
+        {
+            next();
+            left = emit(Op::And, mark, left, parseComparison());
+        }
+        return left;
+    }
+
+    Value parseComparison()
+    {
+        const int mark = m_nextTemp;
+        const Value left = parseAdditive();
+        static const struct
+        {
+            const char *symbol;
+            Op op;
+        } comparisons[] = {
+            {"<", Op::Less},
+            {"<=", Op::LessEqual},
+            {">", Op::Greater},
+            {">=", Op::GreaterEqual},
+            {"==", Op::Equal},
+            {"!=", Op::NotEqual},
+        };
+        for (const auto &comparison : comparisons)
+        {
+            if (isSymbol(comparison.symbol))
+            {
+                next();
+                return emit(comparison.op, mark, left, parseAdditive());
+            }
+        }
+        return left;
+    }
+
+    Value parseAdditive()
+    {
+        const int mark = m_nextTemp;
+        Value left = parseMultiplicative();
+        while (isSymbol("+") || isSymbol("-"))
+        {
+            const Op op = isSymbol("+") ? Op::Add : Op::Sub;
+            next();
+            left = emit(op, mark, left, parseMultiplicative());
+        }
+        return left;
+    }
+
+    Value parseMultiplicative()
+    {
+        const int mark = m_nextTemp;
+        Value left = parseUnary();
+        while (isSymbol("*") || isSymbol("/"))
+        {
+            const Op op = isSymbol("*") ? Op::Mul : Op::Div;
+            next();
+            left = emit(op, mark, left, parseUnary());
+        }
+        return left;
+    }
+
+    Value parseUnary()
+    {
+        const int mark = m_nextTemp;
+        const bool negate = isSymbol("-");
+        const bool invert = isSymbol("!") || isWord("not");
+        if (!negate && !invert && !isSymbol("+"))
+            return parsePrimary();
+        next();
+        const Nesting nesting(*this);
+        if (!checkDepth())
+            return Value::of(0);
+        const Value operand = parseUnary();
+        if (negate)
+            return emit(Op::Neg, mark, operand);
+        if (invert)
+            return emit(Op::Not, mark, operand);
+        return operand; // unary plus
+    }
+
+    Value parsePrimary()
+    {
+        if (m_failed)
+            return Value::of(0);
+
+        if (m_token.kind == Token::Number)
+        {
+            const double value = m_token.number;
+            next();
+            return Value::of(value);
+        }
+        if (isSymbol("("))
+        {
+            next();
+            const Nesting nesting(*this);
+            if (!checkDepth())
+                return Value::of(0);
+            const Value inner = parseExpression();
+            expect(")");
+            return inner;
+        }
+        if (m_token.kind != Token::Identifier)
+        {
+            fail(m_token.kind == Token::End ? QStringLiteral("表达式不完整") : QStringLiteral("意外的 '%1'").arg(m_token.text.toString()));
+            return Value::of(0);
+        }
+
+        const QStringRef name = m_token.text;
+        const int position = m_token.position;
+        next();
+        if (isSymbol("("))
+            return parseCall(name, position);
+
+        if (name == QLatin1String("true"))
+            return Value::of(1);
+        if (name == QLatin1String("false"))
+            return Value::of(0);
+        const int input = inputIndex(name);
+        if (input >= 0)
+            return Value::at(input);
+        if (name.startsWith(QLatin1String("w_")))
+        {
+            const QString key = name.mid(2).toString();
+            auto it = m_weights.constFind(key);
+            if (it != m_weights.constEnd())
+                return Value::of(it.value());
+            m_errorColumn = position + 1;
+            fail(QStringLiteral("规则没有行为权重 '%1'").arg(key));
+            return Value::of(0);
+        }
+        m_errorColumn = position + 1;
+        fail(QStringLiteral("未知的名称 '%1'").arg(name.toString()));
+        return Value::of(0);
+    }
+
+    Value parseCall(const QStringRef &name, int position)
+    {
+        static const struct
+        {
+            const char *name;
+            Op op;
+            int arity;
+        } functions[] = {
+            {"min", Op::Min, 2},
+            {"max", Op::Max, 2},
+            {"abs", Op::Abs, 1},
+            {"clamp", Op::Clamp, 3},
+            {"if", Op::Select, 3},
+        };
+
+        const Nesting nesting(*this);
+        if (!checkDepth())
+            return Value::of(0);
+        const int mark = m_nextTemp;
+        next(); // '('
+        Value args[3];
+        int count = 0;
+        if (!isSymbol(")"))
+        {
+            for (;;)
+            {
+                const Value arg = parseExpression();
+                if (count < 3)
+                    args[count] = arg;
+                ++count;
+                if (!isSymbol(","))
+                    break;
+                next();
+            }
+        }
+        expect(")");
+        if (m_failed)
+            return Value::of(0);
+
+        for (const auto &function : functions)
+        {
+            if (name != QLatin1String(function.name))
+                continue;
+            if (count != function.arity)
+            {
+                m_errorColumn = position + 1;
+                fail(QStringLiteral("%1 需要 %2 个参数").arg(name.toString()).arg(function.arity));
+                return Value::of(0);
+            }
+            return emit(function.op, mark, args[0], args[1], args[2]);
+        }
+        m_errorColumn = position + 1;
+        fail(QStringLiteral("未知的函数 '%1'").arg(name.toString()));
+        return Value::of(0);
+    }
+
+    static constexpr int MaxDepth = 64;
+
+    const QString &m_source;
+    const QMap<QString, int> &m_weights;
+    int m_pos = 0;
+    int m_depth = 0;
+    Token m_token;
+
+    std::vector<PendingInstruction> m_code;
+    std::vector<double> m_constants;
+    QHash<quint64, int> m_constantIndex;
+    int m_nextTemp = 0;
+    int m_maxTemps = 0;
+
+    bool m_failed = false;
+    QString m_error;
+    int m_errorColumn = 0;
+};
+
+bool RuleProgram::compile(const QString &source,
+                          const QMap<QString, int> &weights,
+                          RuleProgram *program,
+                          QString *errorMessage)
+{
+    RuleCompiler compiler(source, weights);
+    return compiler.compile(program, errorMessage);
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QtGlobal>
+
+#include <vector>
+
+// Values a rule expression can read. Event outcomes and requirements are 0
+// or 1 (hit is only judged after a successful fire); factors are the 0-100
+// values at the task's target cell; `base` is the model's success base
+// (AdjudicationEngine::successBase, 0 in Manual mode).
+enum class RuleInput : quint8
+{
+    Fire,
+    Hit,
+    Detect,
+    Jam,
+    RequiresFire,
+    RequiresHit,
+    RequiresDetection,
+    RequiresJam,
+    OceanDepth,
+    AirDryness,
+    EmInterference,
+    Temperature,
+    Humidity,
+    Base,
+    Count
+};
+
+// A rule expression compiled to straight-line register bytecode. The source
+// language is a single arithmetic expression:
+//
+//   fire * w_fire + hit * w_hit * (detect && emInterference < 30 ? 2 : 1)
+//
+// with + - * /, comparisons, && || ! (also and/or/not), ?:, true/false and
+// the functions min, max, abs, clamp and if(c, a, b). `w_<key>` reads the
+// rule's behaviour weight <key> and is folded in at compile time. Division
+// by zero yields 0. Parentheses, calls, ?: and unary operators nest at most
+// 64 deep.
+//
+// Both sides of ?: and of the logical operators are evaluated, so there are
+// no jumps and evaluate() touches no strings and allocates nothing.
+class RuleProgram
+{
+public:
+    static constexpr int InputCount = int(RuleInput::Count);
+    static constexpr int MaxRegisters = 256;
+
+    // Replaces *program with the compiled `source`. On error *program is
+    // left untouched and the message names the column of the problem.
+    static bool compile(const QString &source,
+                        const QMap<QString, int> &weights,
+                        RuleProgram *program,
+                        QString *errorMessage = nullptr);
+    // Identifiers that name inputs, indexed by RuleInput.
+    static QStringList inputNames();
+
+    bool isEmpty() const { return !m_hasResult; }
+    int instructionCount() const { return int(m_code.size()); }
+    int registerCount() const { return m_registerCount; }
+
+    // `inputs` holds InputCount values in RuleInput order.
+    double evaluate(const double *inputs) const;
+
+private:
+    friend class RuleCompiler;
+
+    enum class Op : quint8
+    {
+        Add,
+        Sub,
+        Mul,
+        Div,
+        Neg,
+        Not,
+        Less,
+        LessEqual,
+        Greater,
+        GreaterEqual,
+        Equal,
+        NotEqual,
+        And,
+        Or,
+        Min,
+        Max,
+        Abs,
+        Clamp,  // dst = clamp(a, b, c)
+        Select  // dst = a != 0 ? b : c
+    };
+
+    struct Instruction
+    {
+        Op op;
+        quint8 dst;
+        quint8 a;
+        quint8 b;
+        quint8 c;
+    };
+
+    static double apply(Op op, double a, double b, double c);
+
+    // Registers: [inputs][constants][temporaries].
+    std::vector<Instruction> m_code;
+    std::vector<double> m_constants;
+    int m_registerCount = InputCount;
+    int m_result = 0;
+    bool m_hasResult = false;
+};
@@ -0,0 +1,790 @@
+﻿#include "scenariofile.h"
+#include "adjudicationengine.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QtEndian>
+
+#include <cstring>
+#include <vector>
+
+namespace
+{
+const char kBinaryMagic[8] = {'A', 'F', 'S', 'C', 'E', 'N', 'B', '1'};
+
+void setError(QString *error, const QString &message)
+{
+    if (error)
+        *error = message;
+}
+
+QString modeName(AdjudicationMode mode)
+{
+    switch (mode)
+    {
+    case AdjudicationMode::Automatic:
+        return QStringLiteral("automatic");
+    case AdjudicationMode::Manual:
+        return QStringLiteral("manual");
+    case AdjudicationMode::Stochastic:
+        return QStringLiteral("stochastic");
+    }
+    return QStringLiteral("automatic");
+}
+
+bool modeFromName(const QString &name, AdjudicationMode *mode)
+{
+    if (name == QLatin1String("automatic"))
+        *mode = AdjudicationMode::Automatic;
+    else if (name == QLatin1String("manual"))
+        *mode = AdjudicationMode::Manual;
+    else if (name == QLatin1String("stochastic"))
+        *mode = AdjudicationMode::Stochastic;
+    else
+        return false;
+    return true;
+}
+
+// Rules and models are compiled on load so each one is ready to adjudicate.
+bool compileRulesAndModels(SimulationState &state, QString *error)
+{
+    for (AdjudicationRule &rule : state.rules)
+    {
+        QString message;
+        if (!AdjudicationEngine::compileRule(rule, &message))
+        {
+            setError(error, QStringLiteral("规则 %1: %2").arg(rule.name, message));
+            return false;
+        }
+    }
+    for (AdjudicationModel &model : state.models)
+    {
+        QString message;
+        if (!AdjudicationEngine::compileModel(model, &message))
+        {
+            setError(error, QStringLiteral("模型 %1: %2").arg(model.name, message));
+            return false;
+        }
+    }
+    return true;
+}
+
+// Files refer to rules and models by name; loading maps the names onto the
+// ids the catalogs assign. The first of several equally named items wins.
+template <typename T>
+QHash<QString, CatalogId> idsByName(const Catalog<T> &catalog)
+{
+    QHash<QString, CatalogId> ids;
+    for (const T &item : catalog)
+    {
+        if (!ids.contains(item.name))
+            ids.insert(item.name, item.id);
+    }
+    return ids;
+}
+
+void commitLoaded(SimulationState &loaded, SimulationState &state)
+{
+    state.aircrafts = std::move(loaded.aircrafts);
+    state.tasks = std::move(loaded.tasks);
+    state.rules = std::move(loaded.rules);
+    state.models = std::move(loaded.models);
+    state.mode = loaded.mode;
+    state.randomSeed = loaded.randomSeed;
+    state.currentRuleId = loaded.currentRuleId;
+    state.currentModelId = loaded.currentModelId;
+    state.environment = std::move(loaded.environment);
+    state.simulationTime = 0.0;
+}
+
+QJsonArray pointToJson(const QPoint &p)
+{
+    return QJsonArray{p.x(), p.y()};
+}
+
+bool pointFromJson(const QJsonValue &value, QPoint *point)
+{
+    const QJsonArray a = value.toArray();
+    if (a.size() != 2 || !a.at(0).isDouble() || !a.at(1).isDouble())
+        return false;
+    *point = QPoint(a.at(0).toInt(), a.at(1).toInt());
+    return true;
+}
+
+// Waypoints and targets may lie off the current map, which can shrink after
+// they were placed, but never outside the largest grid a scenario can have.
+// That range also fits TaskTable's packed targets.
+Q_STATIC_ASSERT(MaxGridSize <= 32768);
+
+bool cellInRange(const QPoint &cell)
+{
+    return cell.x() >= 0 && cell.y() >= 0 && cell.x() < MaxGridSize && cell.y() < MaxGridSize;
+}
+
+class BinaryWriter
+{
+public:
+    QByteArray data;
+
+    template <typename T>
+    void put(T value)
+    {
+        char bytes[sizeof(T)];
+        qToLittleEndian<T>(value, bytes);
+        data.append(bytes, int(sizeof(T)));
+    }
+    void putDouble(double value)
+    {
+        quint64 bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        put<quint64>(bits);
+    }
+    void putBytes(const char *bytes, int size) { data.append(bytes, size); }
+};
+
+class BinaryReader
+{
+public:
+    BinaryReader(const char *data, qint64 size)
+        : m_pos(data)
+        , m_end(data + size)
+    {
+    }
+
+    bool ok() const { return m_ok; }
+
+    template <typename T>
+    T get()
+    {
+        if (!require(qint64(sizeof(T))))
+            return T();
+        const T value = qFromLittleEndian<T>(m_pos);
+        m_pos += sizeof(T);
+        return value;
+    }
+    double getDouble()
+    {
+        const quint64 bits = get<quint64>();
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    const char *getBytes(qint64 size)
+    {
+        if (!require(size))
+            return nullptr;
+        const char *bytes = m_pos;
+        m_pos += size;
+        return bytes;
+    }
+    // Array lengths are checked against the bytes left, so a corrupt count
+    // cannot trigger a huge allocation.
+    quint32 getCount(qint64 minElementSize)
+    {
+        const quint32 count = get<quint32>();
+        if (m_ok && qint64(count) * minElementSize > m_end - m_pos)
+            m_ok = false;
+        return m_ok ? count : 0;
+    }
+
+private:
+    bool require(qint64 size)
+    {
+        if (!m_ok || size < 0 || m_end - m_pos < size)
+        {
+            m_ok = false;
+            return false;
+        }
+        return true;
+    }
+
+    const char *m_pos;
+    const char *m_end;
+    bool m_ok = true;
+};
+}
+
+ScenarioFile::Format ScenarioFile::formatForPath(const QString &path)
+{
+    return QFileInfo(path).suffix().compare(QLatin1String("json"), Qt::CaseInsensitive) == 0 ? Format::Json : Format::Binary;
+}
+
+bool ScenarioFile::load(const QString &path, SimulationState &state, QString *error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        setError(error, QStringLiteral("无法打开想定文件: %1").arg(file.errorString()));
+        return false;
+    }
+
+    const qint64 size = file.size();
+    if (uchar *mapped = size > 0 ? file.map(0, size) : nullptr)
+    {
+        const char *data = reinterpret_cast<const char *>(mapped);
+        bool ok;
+        if (size >= qint64(sizeof(kBinaryMagic)) && std::memcmp(data, kBinaryMagic, sizeof(kBinaryMagic)) == 0)
+            ok = fromBinary(data, size, state, error);
+        else
+            ok = fromJson(QByteArray::fromRawData(data, int(size)), state, error);
+        file.unmap(mapped);
+        return ok;
+    }
+
+    const QByteArray data = file.readAll();
+    if (data.startsWith(QByteArray::fromRawData(kBinaryMagic, sizeof(kBinaryMagic))))
+        return fromBinary(data.constData(), data.size(), state, error);
+    return fromJson(data, state, error);
+}
+
+bool ScenarioFile::save(const QString &path, const SimulationState &state, Format format, QString *error)
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        setError(error, QStringLiteral("无法写入想定文件: %1").arg(file.errorString()));
+        return false;
+    }
+    const QByteArray data = format == Format::Json ? toJson(state) : toBinary(state);
+    if (file.write(data) != data.size() || !file.commit())
+    {
+        setError(error, QStringLiteral("写入想定文件失败: %1").arg(file.errorString()));
+        return false;
+    }
+    return true;
+}
+
+QByteArray ScenarioFile::toJson(const SimulationState &state)
+{
+    QJsonObject root;
+    root.insert(QStringLiteral("format"), QStringLiteral("afsim-ruling-scenario"));
+    root.insert(QStringLiteral("version"), 1);
+    root.insert(QStringLiteral("mode"), modeName(state.mode));
+    // As a string: JSON numbers cannot hold every 64-bit seed.
+    root.insert(QStringLiteral("randomSeed"), QString::number(state.randomSeed));
+    root.insert(QStringLiteral("currentRule"), state.rules.nameOf(state.currentRuleId));
+    root.insert(QStringLiteral("currentModel"), state.models.nameOf(state.currentModelId));
+
+    QJsonArray rules;
+    for (const AdjudicationRule &rule : state.rules)
+    {
+        QJsonObject weights;
+        for (auto it = rule.behaviorWeights.cbegin(); it != rule.behaviorWeights.cend(); ++it)
+        {
+            weights.insert(it.key(), it.value());
+        }
+        QJsonObject r;
+        r.insert(QStringLiteral("name"), rule.name);
+        r.insert(QStringLiteral("successThreshold"), rule.successThreshold);
+        r.insert(QStringLiteral("behaviorWeights"), weights);
+        if (!rule.expression.isEmpty())
+        {
+            r.insert(QStringLiteral("expression"), rule.expression);
+        }
+        rules.append(r);
+    }
+    root.insert(QStringLiteral("rules"), rules);
+
+    QJsonArray models;
+    for (const AdjudicationModel &model : state.models)
+    {
+        QJsonObject m;
+        m.insert(QStringLiteral("name"), model.name);
+        m.insert(QStringLiteral("factorKeys"), QJsonArray::fromStringList(model.factorKeys));
+        m.insert(QStringLiteral("environmentWeight"), model.environmentWeight);
+        models.append(m);
+    }
+    root.insert(QStringLiteral("models"), models);
+
+    QJsonArray aircrafts;
+    for (int index = 0; index < state.aircrafts.size(); ++index)
+    {
+        QJsonArray route;
+        const QPoint *waypoints = state.aircrafts.route(index);
+        for (int p = 0; p < state.aircrafts.routeLength(index); ++p)
+        {
+            route.append(pointToJson(waypoints[p]));
+        }
+        QJsonArray tasks;
+        const int firstTask = state.aircrafts.firstTask(index);
+        for (int row = firstTask; row < firstTask + state.aircrafts.taskCount(index); ++row)
+        {
+            const Task task = state.tasks.task(row);
+            QJsonObject t;
+            t.insert(QStringLiteral("name"), task.name);
+            t.insert(QStringLiteral("executionTime"), task.executionTime);
+            t.insert(QStringLiteral("requiresFire"), task.requiresFire);
+            t.insert(QStringLiteral("requiresHit"), task.requiresHit);
+            t.insert(QStringLiteral("requiresDetection"), task.requiresDetection);
+            t.insert(QStringLiteral("requiresJam"), task.requiresJam);
+            t.insert(QStringLiteral("targetCell"), pointToJson(task.targetCell));
+            t.insert(QStringLiteral("rule"), state.rules.nameOf(task.ruleId));
+            tasks.append(t);
+        }
+        QJsonObject a;
+        a.insert(QStringLiteral("name"), state.aircrafts.name(index));
+        a.insert(QStringLiteral("secondsPerStep"), state.aircrafts.secondsPerStep(index));
+        a.insert(QStringLiteral("route"), route);
+        a.insert(QStringLiteral("tasks"), tasks);
+        aircrafts.append(a);
+    }
+    root.insert(QStringLiteral("aircraft"), aircrafts);
+
+    // Only cells that differ from the defaults are listed.
+    const EnvironmentField &field = state.environment;
+    QJsonArray cells;
+    std::vector<quint8> tile(size_t(EnvironmentField::TileCells) * EnvironmentFactorCount);
+    for (int ty = 0; ty < field.tilesY(); ++ty)
+    {
+        for (int tx = 0; tx < field.tilesX(); ++tx)
+        {
+            if (!field.copyTile(tx, ty, tile.data()))
+                continue;
+            for (int i = 0; i < EnvironmentField::TileCells; ++i)
+            {
+                const QPoint cell(tx * EnvironmentField::TileSize + i % EnvironmentField::TileSize,
+                                  ty * EnvironmentField::TileSize + i / EnvironmentField::TileSize);
+                if (!field.contains(cell))
+                    continue;
+                bool isDefault = true;
+                for (int f = 0; f < EnvironmentFactorCount && isDefault; ++f)
+                {
+                    isDefault = tile[size_t(f * EnvironmentField::TileCells + i)] == DefaultFactorValue;
+                }
+                if (isDefault)
+                    continue;
+
+                const EnvironmentFactors factors = field.at(cell);
+                QJsonObject c;
+                c.insert(QStringLiteral("x"), cell.x());
+                c.insert(QStringLiteral("y"), cell.y());
+                c.insert(QStringLiteral("oceanDepth"), factors.oceanDepth);
+                c.insert(QStringLiteral("airDryness"), factors.airDryness);
+                c.insert(QStringLiteral("emInterference"), factors.emInterference);
+                c.insert(QStringLiteral("temperature"), factors.temperature);
+                c.insert(QStringLiteral("humidity"), factors.humidity);
+                cells.append(c);
+            }
+        }
+    }
+    QJsonObject environment;
+    environment.insert(QStringLiteral("width"), field.width());
+    environment.insert(QStringLiteral("height"), field.height());
+    environment.insert(QStringLiteral("cells"), cells);
+    root.insert(QStringLiteral("environment"), environment);
+
+    return QJsonDocument(root).toJson(QJsonDocument::Indented);
+}
+
+bool ScenarioFile::fromJson(const QByteArray &data, SimulationState &state, QString *error)
+{
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(data, &parseError);
+    if (doc.isNull() || !doc.isObject())
+    {
+        setError(error, QStringLiteral("想定文件解析失败: %1").arg(parseError.errorString()));
+        return false;
+    }
+    const QJsonObject root = doc.object();
+    if (root.value(QStringLiteral("format")).toString() != QLatin1String("afsim-ruling-scenario")
+        || root.value(QStringLiteral("version")).toInt() != 1)
+    {
+        setError(error, QStringLiteral("不支持的想定文件格式或版本"));
+        return false;
+    }
+
+    SimulationState loaded;
+    if (!modeFromName(root.value(QStringLiteral("mode")).toString(QStringLiteral("automatic")), &loaded.mode))
+    {
+        setError(error, QStringLiteral("未知的裁决模式: %1").arg(root.value(QStringLiteral("mode")).toString()));
+        return false;
+    }
+    bool seedOk = false;
+    loaded.randomSeed = root.value(QStringLiteral("randomSeed")).toString(QStringLiteral("1")).toULongLong(&seedOk);
+    if (!seedOk)
+    {
+        setError(error, QStringLiteral("随机种子无效"));
+        return false;
+    }
+    for (const QJsonValue &value : root.value(QStringLiteral("rules")).toArray())
+    {
+        const QJsonObject r = value.toObject();
+        AdjudicationRule rule;
+        rule.name = r.value(QStringLiteral("name")).toString();
+        rule.successThreshold = r.value(QStringLiteral("successThreshold")).toInt(rule.successThreshold);
+        const QJsonObject weights = r.value(QStringLiteral("behaviorWeights")).toObject();
+        for (auto it = weights.begin(); it != weights.end(); ++it)
+        {
+            rule.behaviorWeights.insert(it.key(), it.value().toInt());
+        }
+        rule.expression = r.value(QStringLiteral("expression")).toString();
+        loaded.rules.append(rule);
+    }
+
+    for (const QJsonValue &value : root.value(QStringLiteral("models")).toArray())
+    {
+        const QJsonObject m = value.toObject();
+        AdjudicationModel model;
+        model.name = m.value(QStringLiteral("name")).toString();
+        for (const QJsonValue &key : m.value(QStringLiteral("factorKeys")).toArray())
+        {
+            model.factorKeys.append(key.toString());
+        }
+        model.environmentWeight = m.value(QStringLiteral("environmentWeight")).toDouble(model.environmentWeight);
+        loaded.models.append(model);
+    }
+
+    const QHash<QString, CatalogId> ruleIds = idsByName(loaded.rules);
+    loaded.currentRuleId = ruleIds.value(root.value(QStringLiteral("currentRule")).toString(), NoId);
+    loaded.currentModelId = idsByName(loaded.models).value(root.value(QStringLiteral("currentModel")).toString(), NoId);
+
+    for (const QJsonValue &value : root.value(QStringLiteral("aircraft")).toArray())
+    {
+        const QJsonObject a = value.toObject();
+        Aircraft ac;
+        ac.name = a.value(QStringLiteral("name")).toString();
+        ac.secondsPerStep = a.value(QStringLiteral("secondsPerStep")).toDouble(ac.secondsPerStep);
+        for (const QJsonValue &point : a.value(QStringLiteral("route")).toArray())
+        {
+            QPoint p;
+            if (!pointFromJson(point, &p))
+            {
+                setError(error, QStringLiteral("飞机 %1 的航迹点格式错误").arg(ac.name));
+                return false;
+            }
+            if (!cellInRange(p))
+            {
+                setError(error, QStringLiteral("飞机 %1 的航迹点超出范围: (%2, %3)").arg(ac.name).arg(p.x()).arg(p.y()));
+                return false;
+            }
+            ac.route.append(p);
+        }
+        for (const QJsonValue &taskValue : a.value(QStringLiteral("tasks")).toArray())
+        {
+            const QJsonObject t = taskValue.toObject();
+            Task task;
+            task.name = t.value(QStringLiteral("name")).toString();
+            task.executionTime = t.value(QStringLiteral("executionTime")).toInt();
+            task.requiresFire = t.value(QStringLiteral("requiresFire")).toBool();
+            task.requiresHit = t.value(QStringLiteral("requiresHit")).toBool();
+            task.requiresDetection = t.value(QStringLiteral("requiresDetection")).toBool();
+            task.requiresJam = t.value(QStringLiteral("requiresJam")).toBool();
+            task.ruleId = ruleIds.value(t.value(QStringLiteral("rule")).toString(), NoId);
+            if (!pointFromJson(t.value(QStringLiteral("targetCell")), &task.targetCell))
+            {
+                setError(error, QStringLiteral("任务 %1 的目标格式错误").arg(task.name));
+                return false;
+            }
+            if (!cellInRange(task.targetCell))
+            {
+                setError(error, QStringLiteral("任务 %1 的目标超出范围: (%2, %3)")
+                                    .arg(task.name)
+                                    .arg(task.targetCell.x())
+                                    .arg(task.targetCell.y()));
+                return false;
+            }
+            loaded.tasks.append(loaded.aircrafts.size(), task);
+        }
+        loaded.aircrafts.add(ac);
+    }
+    loaded.tasks.assignRanges(loaded.aircrafts);
+
+    const QJsonObject environment = root.value(QStringLiteral("environment")).toObject();
+    const int width = environment.value(QStringLiteral("width")).toInt(DefaultGridSize);
+    const int height = environment.value(QStringLiteral("height")).toInt(DefaultGridSize);
+    if (width < 1 || height < 1 || width > MaxGridSize || height > MaxGridSize)
+    {
+        setError(error, QStringLiteral("地图尺寸超出范围: %1x%2").arg(width).arg(height));
+        return false;
+    }
+    loaded.environment.resize(width, height);
+    for (const QJsonValue &value : environment.value(QStringLiteral("cells")).toArray())
+    {
+        const QJsonObject c = value.toObject();
+        EnvironmentFactors factors;
+        factors.oceanDepth = c.value(QStringLiteral("oceanDepth")).toInt(factors.oceanDepth);
+        factors.airDryness = c.value(QStringLiteral("airDryness")).toInt(factors.airDryness);
+        factors.emInterference = c.value(QStringLiteral("emInterference")).toInt(factors.emInterference);
+        factors.temperature = c.value(QStringLiteral("temperature")).toInt(factors.temperature);
+        factors.humidity = c.value(QStringLiteral("humidity")).toInt(factors.humidity);
+        loaded.environment.set(QPoint(c.value(QStringLiteral("x")).toInt(-1), c.value(QStringLiteral("y")).toInt(-1)), factors);
+    }
+
+    if (!compileRulesAndModels(loaded, error))
+        return false;
+    commitLoaded(loaded, state);
+    return true;
+}
+
+QByteArray ScenarioFile::toBinary(const SimulationState &state)
+{
+    QHash<QString, quint32> ids;
+    QVector<QString> strings;
+    auto intern = [&](const QString &s) {
+        auto it = ids.constFind(s);
+        if (it != ids.constEnd())
+            return it.value();
+        const quint32 id = quint32(strings.size());
+        ids.insert(s, id);
+        strings.append(s);
+        return id;
+    };
+
+    // Body first so the string table is complete before it is written.
+    BinaryWriter body;
+    body.put<quint8>(quint8(state.mode));
+    body.put<quint64>(state.randomSeed);
+    body.put<quint32>(intern(state.rules.nameOf(state.currentRuleId)));
+    body.put<quint32>(intern(state.models.nameOf(state.currentModelId)));
+
+    body.put<quint32>(quint32(state.rules.size()));
+    for (const AdjudicationRule &rule : state.rules)
+    {
+        body.put<quint32>(intern(rule.name));
+        body.put<qint32>(rule.successThreshold);
+        body.put<quint32>(quint32(rule.behaviorWeights.size()));
+        for (auto it = rule.behaviorWeights.cbegin(); it != rule.behaviorWeights.cend(); ++it)
+        {
+            body.put<quint32>(intern(it.key()));
+            body.put<qint32>(it.value());
+        }
+        body.put<quint32>(intern(rule.expression));
+    }
+
+    body.put<quint32>(quint32(state.models.size()));
+    for (const AdjudicationModel &model : state.models)
+    {
+        body.put<quint32>(intern(model.name));
+        body.putDouble(model.environmentWeight);
+        body.put<quint32>(quint32(model.factorKeys.size()));
+        for (const QString &key : model.factorKeys)
+        {
+            body.put<quint32>(intern(key));
+        }
+    }
+
+    const AircraftStore &aircrafts = state.aircrafts;
+    body.put<quint32>(quint32(aircrafts.size()));
+    for (int index = 0; index < aircrafts.size(); ++index)
+    {
+        body.put<quint32>(intern(aircrafts.name(index)));
+        body.putDouble(aircrafts.secondsPerStep(index));
+        body.put<quint32>(quint32(aircrafts.routeLength(index)));
+        const QPoint *waypoints = aircrafts.route(index);
+        for (int p = 0; p < aircrafts.routeLength(index); ++p)
+        {
+            body.put<qint32>(waypoints[p].x());
+            body.put<qint32>(waypoints[p].y());
+        }
+        const TaskTable &tasks = state.tasks;
+        const int firstTask = aircrafts.firstTask(index);
+        body.put<quint32>(quint32(aircrafts.taskCount(index)));
+        for (int row = firstTask; row < firstTask + aircrafts.taskCount(index); ++row)
+        {
+            const QPoint target = tasks.targetPoint(row);
+            body.put<quint32>(intern(tasks.name(row)));
+            body.put<qint32>(tasks.executionTime(row));
+            body.put<quint8>(tasks.requirements(row));
+            body.put<qint32>(target.x());
+            body.put<qint32>(target.y());
+            body.put<quint32>(intern(state.rules.nameOf(tasks.rule(row))));
+        }
+    }
+
+    const EnvironmentField &field = state.environment;
+    body.put<quint32>(quint32(field.width()));
+    body.put<quint32>(quint32(field.height()));
+    const int countPos = body.data.size();
+    body.put<quint32>(0);
+    quint32 tileCount = 0;
+    std::vector<quint8> tile(size_t(EnvironmentField::TileCells) * EnvironmentFactorCount);
+    for (int t = 0; t < field.tilesX() * field.tilesY(); ++t)
+    {
+        if (!field.copyTile(t % field.tilesX(), t / field.tilesX(), tile.data()))
+            continue;
+        body.put<quint32>(quint32(t));
+        body.putBytes(reinterpret_cast<const char *>(tile.data()), int(tile.size()));
+        ++tileCount;
+    }
+    qToLittleEndian<quint32>(tileCount, body.data.data() + countPos);
+
+    BinaryWriter out;
+    out.putBytes(kBinaryMagic, sizeof(kBinaryMagic));
+    out.put<quint32>(BinaryVersion);
+    out.put<quint32>(quint32(strings.size()));
+    for (const QString &s : strings)
+    {
+        const QByteArray utf8 = s.toUtf8();
+        out.put<quint32>(quint32(utf8.size()));
+        out.putBytes(utf8.constData(), utf8.size());
+    }
+    out.data.append(body.data);
+    return out.data;
+}
+
+bool ScenarioFile::fromBinary(const char *data, qint64 size, SimulationState &state, QString *error)
+{
+    BinaryReader in(data, size);
+    const char *magic = in.getBytes(sizeof(kBinaryMagic));
+    if (!magic || std::memcmp(magic, kBinaryMagic, sizeof(kBinaryMagic)) != 0)
+    {
+        setError(error, QStringLiteral("不是想定二进制文件"));
+        return false;
+    }
+    const quint32 version = in.get<quint32>();
+    // Version 1 files predate rule expressions.
+    if (version < 1 || version > BinaryVersion)
+    {
+        setError(error, QStringLiteral("不支持的想定文件版本: %1").arg(version));
+        return false;
+    }
+
+    QVector<QString> strings(int(in.getCount(4)));
+    for (QString &s : strings)
+    {
+        const quint32 bytes = in.get<quint32>();
+        const char *utf8 = in.getBytes(bytes);
+        if (utf8)
+            s = QString::fromUtf8(utf8, int(bytes));
+    }
+    bool stringsOk = true;
+    auto string = [&](quint32 id) {
+        if (id >= quint32(strings.size()))
+        {
+            stringsOk = false;
+            return QString();
+        }
+        return strings.at(int(id));
+    };
+
+    SimulationState loaded;
+    const quint8 mode = in.get<quint8>();
+    if (in.ok() && mode > quint8(AdjudicationMode::Stochastic))
+    {
+        setError(error, QStringLiteral("未知的裁决模式: %1").arg(mode));
+        return false;
+    }
+    loaded.mode = AdjudicationMode(mode);
+    loaded.randomSeed = in.get<quint64>();
+    const QString currentRule = string(in.get<quint32>());
+    const QString currentModel = string(in.get<quint32>());
+
+    const quint32 ruleCount = in.getCount(version >= 2 ? 16 : 12);
+    for (quint32 r = 0; r < ruleCount; ++r)
+    {
+        AdjudicationRule rule;
+        rule.name = string(in.get<quint32>());
+        rule.successThreshold = in.get<qint32>();
+        const quint32 weights = in.getCount(8);
+        for (quint32 i = 0; i < weights; ++i)
+        {
+            const QString key = string(in.get<quint32>());
+            rule.behaviorWeights.insert(key, in.get<qint32>());
+        }
+        if (version >= 2)
+        {
+            rule.expression = string(in.get<quint32>());
+        }
+        loaded.rules.append(rule);
+    }
+
+    const quint32 modelCount = in.getCount(16);
+    for (quint32 m = 0; m < modelCount; ++m)
+    {
+        AdjudicationModel model;
+        model.name = string(in.get<quint32>());
+        model.environmentWeight = in.getDouble();
+        const quint32 keys = in.getCount(4);
+        model.factorKeys.reserve(int(keys));
+        for (quint32 i = 0; i < keys; ++i)
+        {
+            model.factorKeys.append(string(in.get<quint32>()));
+        }
+        loaded.models.append(model);
+    }
+
+    const QHash<QString, CatalogId> ruleIds = idsByName(loaded.rules);
+    loaded.currentRuleId = ruleIds.value(currentRule, NoId);
+    loaded.currentModelId = idsByName(loaded.models).value(currentModel, NoId);
+
+    const int aircraftCount = int(in.getCount(20));
+    loaded.aircrafts.reserve(aircraftCount);
+    for (int a = 0; a < aircraftCount; ++a)
+    {
+        Aircraft ac;
+        ac.name = string(in.get<quint32>());
+        ac.secondsPerStep = in.getDouble();
+        ac.route.resize(int(in.getCount(8)));
+        for (QPoint &p : ac.route)
+        {
+            const qint32 x = in.get<qint32>();
+            p = QPoint(x, in.get<qint32>());
+            if (in.ok() && !cellInRange(p))
+            {
+                setError(error, QStringLiteral("飞机 %1 的航迹点超出范围: (%2, %3)").arg(ac.name).arg(p.x()).arg(p.y()));
+                return false;
+            }
+        }
+        const quint32 taskCount = in.getCount(21);
+        for (quint32 t = 0; t < taskCount; ++t)
+        {
+            Task task;
+            task.name = string(in.get<quint32>());
+            task.executionTime = in.get<qint32>();
+            task.setRequirementMask(in.get<quint8>());
+            const qint32 x = in.get<qint32>();
+            task.targetCell = QPoint(x, in.get<qint32>());
+            if (in.ok() && !cellInRange(task.targetCell))
+            {
+                setError(error, QStringLiteral("任务 %1 的目标超出范围: (%2, %3)")
+                                    .arg(task.name)
+                                    .arg(task.targetCell.x())
+                                    .arg(task.targetCell.y()));
+                return false;
+            }
+            task.ruleId = ruleIds.value(string(in.get<quint32>()), NoId);
+            loaded.tasks.append(a, task);
+        }
+        loaded.aircrafts.add(ac);
+    }
+    loaded.tasks.assignRanges(loaded.aircrafts);
+
+    const quint32 width = in.get<quint32>();
+    const quint32 height = in.get<quint32>();
+    if (in.ok() && (width < 1 || height < 1 || width > quint32(MaxGridSize) || height > quint32(MaxGridSize)))
+    {
+        setError(error, QStringLiteral("地图尺寸超出范围: %1x%2").arg(width).arg(height));
+        return false;
+    }
+    loaded.environment.resize(int(width), int(height));
+    const qint64 tileBytes = qint64(EnvironmentField::TileCells) * EnvironmentFactorCount;
+    const quint32 tiles = in.getCount(4 + tileBytes);
+    const int tileTotal = loaded.environment.tilesX() * loaded.environment.tilesY();
+    for (quint32 i = 0; i < tiles && in.ok(); ++i)
+    {
+        const quint32 index = in.get<quint32>();
+        const char *bytes = in.getBytes(tileBytes);
+        if (!bytes || index >= quint32(tileTotal) || !factorValuesInRange(reinterpret_cast<const quint8 *>(bytes), tileBytes))
+        {
+            stringsOk = false;
+            break;
+        }
+        loaded.environment.setTile(int(index) % loaded.environment.tilesX(), int(index) / loaded.environment.tilesX(),
+                                   reinterpret_cast<const quint8 *>(bytes));
+    }
+
+    if (!in.ok() || !stringsOk)
+    {
+        setError(error, QStringLiteral("想定文件已损坏或不完整"));
+        return false;
+    }
+    if (!compileRulesAndModels(loaded, error))
+        return false;
+    commitLoaded(loaded, state);
+    return true;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+#include "models.h"
+
+// Complete scenario persistence: aircraft with routes and tasks, rules,
+// models, adjudication mode, random seed and the environment field.
+// Runtime progress (time, task status, logs) is not stored; a loaded scenario
+// starts from the beginning.
+//
+// Two encodings are supported. JSON is the human-editable interchange form.
+// The binary form (magic "AFSCENB1", little-endian) interns every string
+// once in a table and writes all arrays length-prefixed, so large scenarios
+// load with one pass over a mapped file:
+//   char[8] magic, quint32 version
+//   strings:  quint32 count, { quint32 bytes, UTF-8 }
+//   header:   quint8 mode, quint64 seed, quint32 currentRule, quint32 currentModel
+//   rules:    quint32 count, { name, qint32 threshold, quint32 n, { key, qint32 weight },
+//                              expression (version 2+) }
+//   models:   quint32 count, { name, double environmentWeight, quint32 n, { key } }
+//   aircraft: quint32 count, { name, double secondsPerStep,
+//                              quint32 n, { qint32 x, qint32 y },
+//                              quint32 n, { name, qint32 time, quint8 requirements,
+//                                           qint32 x, qint32 y, rule } }
+//   environment: quint32 width, quint32 height,
+//                quint32 n, { quint32 tile index, band-major tile bytes }
+// where name/key/rule/expression are quint32 string-table indices.
+class ScenarioFile
+{
+public:
+    enum class Format
+    {
+        Json,
+        Binary
+    };
+
+    static constexpr quint32 BinaryVersion = 2;
+
+    // ".json" files use the JSON form, anything else the binary form.
+    static Format formatForPath(const QString &path);
+
+    // Detects the encoding from the file contents. On failure `state` is
+    // left unchanged.
+    static bool load(const QString &path, SimulationState &state, QString *error = nullptr);
+    static bool save(const QString &path, const SimulationState &state, Format format, QString *error = nullptr);
+
+    static QByteArray toJson(const SimulationState &state);
+    static bool fromJson(const QByteArray &data, SimulationState &state, QString *error = nullptr);
+    static QByteArray toBinary(const SimulationState &state);
+    static bool fromBinary(const char *data, qint64 size, SimulationState &state, QString *error = nullptr);
+};
@@ -0,0 +1,110 @@
+﻿#include "scorefieldcache.h"
+#include "adjudicationengine.h"
+#include "factorkernels.h"
+
+ScoreField::ScoreField(const EnvironmentField &environment, const AdjudicationModel &model)
+    : m_environment(&environment)
+    , m_contentId(environment.contentId())
+    , m_model(model)
+    , m_outsideScore(AdjudicationEngine::successBase(AdjudicationEngine::weightedFactorSum(EnvironmentFactors(), model), model))
+    , m_tiles(size_t(environment.tilesX()) * size_t(environment.tilesY()))
+{
+}
+
+bool ScoreField::matches(const EnvironmentField &environment, const AdjudicationModel &model) const
+{
+    return m_environment == &environment
+           && m_contentId == environment.contentId()
+           && m_model.factorCounts == model.factorCounts
+           && m_model.factorTotal == model.factorTotal
+           && m_model.environmentWeight == model.environmentWeight;
+}
+
+double ScoreField::at(const QPoint &cell)
+{
+    if (!m_environment->contains(cell))
+        return m_outsideScore;
+
+    const int tileX = cell.x() >> EnvironmentField::TileShift;
+    const int tileY = cell.y() >> EnvironmentField::TileShift;
+    const int index = tileY * m_environment->tilesX() + tileX;
+    if (!m_tiles[size_t(index)])
+        buildTile(index);
+
+    const int local = ((cell.y() & (EnvironmentField::TileSize - 1)) << EnvironmentField::TileShift)
+                      | (cell.x() & (EnvironmentField::TileSize - 1));
+    return m_tiles[size_t(index)][size_t(local)];
+}
+
+void ScoreField::invalidateCell(const QPoint &cell)
+{
+    if (!m_environment->contains(cell))
+        return;
+
+    const int index = (cell.y() >> EnvironmentField::TileShift) * m_environment->tilesX() + (cell.x() >> EnvironmentField::TileShift);
+    double *tile = m_tiles[size_t(index)].get();
+    if (!tile)
+        return;
+
+    const int local = ((cell.y() & (EnvironmentField::TileSize - 1)) << EnvironmentField::TileShift)
+                      | (cell.x() & (EnvironmentField::TileSize - 1));
+    tile[local] = AdjudicationEngine::successBase(AdjudicationEngine::weightedFactorSum(m_environment->at(cell), m_model), m_model);
+}
+
+void ScoreField::buildTile(int index)
+{
+    constexpr int cells = EnvironmentField::TileCells;
+    quint8 factors[EnvironmentFactorCount * cells];
+    m_environment->copyTile(index % m_environment->tilesX(), index / m_environment->tilesX(), factors);
+
+    // Same integer sum and double arithmetic as the per-task path, so cached
+    // scores are bit-identical to AdjudicationEngine::eventSuccess().
+    const quint8 *planes[EnvironmentFactorCount];
+    for (int f = 0; f < EnvironmentFactorCount; ++f)
+    {
+        planes[f] = factors + f * cells;
+    }
+    qint32 sums[cells];
+    FactorKernels::weightedSum(planes, m_model.factorCounts, sums, cells);
+
+    std::unique_ptr<double[]> tile(new double[cells]);
+    for (int i = 0; i < cells; ++i)
+    {
+        tile[i] = AdjudicationEngine::successBase(sums[i], m_model);
+    }
+    m_tiles[size_t(index)] = std::move(tile);
+}
+
+ScoreField &ScoreFieldCache::field(const EnvironmentField &environment, const AdjudicationModel &model)
+{
+    QSharedPointer<ScoreField> &entry = m_fields[model.id];
+    if (!entry || !entry->matches(environment, model))
+    {
+        entry.reset(new ScoreField(environment, model));
+    }
+    return *entry;
+}
+
+void ScoreFieldCache::invalidateCell(const QPoint &cell)
+{
+    for (const QSharedPointer<ScoreField> &field : qAsConst(m_fields))
+    {
+        field->invalidateCell(cell);
+    }
+}
+
+void ScoreFieldCache::retainModels(const Catalog<AdjudicationModel> &models)
+{
+    for (auto it = m_fields.begin(); it != m_fields.end();)
+    {
+        if (models.indexOf(it.key()) < 0)
+            it = m_fields.erase(it);
+        else
+            ++it;
+    }
+}
+
+void ScoreFieldCache::clear()
+{
+    m_fields.clear();
+}
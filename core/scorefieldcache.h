@@ -0,0 +1,52 @@
+#pragma once
+
+#include <QHash>
+#include <QSharedPointer>
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "models.h"
+
+// Success base (AdjudicationEngine::successBase) of one model at every cell
+// of an environment field. Tiles are computed on first use, so a large map
+// only pays for the area that tasks actually target.
+class ScoreField
+{
+public:
+    ScoreField(const EnvironmentField &environment, const AdjudicationModel &model);
+
+    bool matches(const EnvironmentField &environment, const AdjudicationModel &model) const;
+    // Cells outside the grid score with the default factors.
+    double at(const QPoint &cell);
+    // Recomputes one cell if its tile has been built.
+    void invalidateCell(const QPoint &cell);
+
+private:
+    void buildTile(int index);
+
+    const EnvironmentField *m_environment;
+    quint64 m_contentId;
+    AdjudicationModel m_model; // compiled parameters the field was built from
+    double m_outsideScore;
+    std::vector<std::unique_ptr<double[]>> m_tiles;
+};
+
+// Per-model score fields over the simulation's environment, keyed by model
+// id. A field is rebuilt when its model's compiled parameters change or the
+// environment is replaced; single-cell edits must be reported through
+// invalidateCell(). Ids restart with each scenario, so clear() on load.
+class ScoreFieldCache
+{
+public:
+    ScoreField &field(const EnvironmentField &environment, const AdjudicationModel &model);
+
+    void invalidateCell(const QPoint &cell);
+    // Frees the fields of models no longer in `models`.
+    void retainModels(const Catalog<AdjudicationModel> &models);
+    void clear();
+
+private:
+    QHash<ModelId, QSharedPointer<ScoreField>> m_fields;
+};
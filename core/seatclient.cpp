@@ -0,0 +1,137 @@
+﻿#include "seatclient.h"
+
+#include <QHostAddress>
+#include <QLocalSocket>
+#include <QTcpSocket>
+
+SeatClient::SeatClient(const QString &seatName, QObject *parent)
+    : QObject(parent)
+    , m_seatName(seatName)
+{
+}
+
+SeatClient::~SeatClient()
+{
+    if (m_socket)
+        m_socket->disconnect(this);
+}
+
+void SeatClient::connectToLocal(const QString &serverName)
+{
+    auto *socket = new QLocalSocket(this);
+    attach(socket);
+    connect(socket, &QLocalSocket::connected, this, &SeatClient::greet);
+    connect(socket, &QLocalSocket::disconnected, this, &SeatClient::lost);
+    connect(socket, QOverload<QLocalSocket::LocalSocketError>::of(&QLocalSocket::error), this, [this, socket] {
+        emit errorOccurred(socket->errorString());
+        lost();
+    });
+    socket->connectToServer(serverName);
+}
+
+void SeatClient::connectToTcp(quint16 port)
+{
+    auto *socket = new QTcpSocket(this);
+    attach(socket);
+    connect(socket, &QTcpSocket::connected, this, [this, socket] {
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        greet();
+    });
+    connect(socket, &QTcpSocket::disconnected, this, &SeatClient::lost);
+    connect(socket, QOverload<QAbstractSocket::SocketError>::of(&QAbstractSocket::error), this, [this, socket] {
+        emit errorOccurred(socket->errorString());
+        lost();
+    });
+    socket->connectToHost(QHostAddress::LocalHost, port);
+}
+
+void SeatClient::disconnectFromServer()
+{
+    if (!m_socket)
+        return;
+    m_socket->disconnect(this);
+    m_socket->close();
+    m_socket->deleteLater();
+    m_socket = nullptr;
+    m_reader = SeatFrameReader();
+    if (m_seatId != 0)
+    {
+        m_seatId = 0;
+        emit disconnected();
+    }
+}
+
+void SeatClient::submit(quint64 requestId, const ManualAdjudicationState &ruling)
+{
+    SeatMessage message;
+    message.type = SeatMessage::Type::Ruling;
+    message.requestId = requestId;
+    message.ruling = ruling.bits();
+    send(message);
+}
+
+void SeatClient::cancel(quint64 requestId)
+{
+    SeatMessage message;
+    message.type = SeatMessage::Type::Ruling;
+    message.requestId = requestId;
+    message.cancelled = true;
+    send(message);
+}
+
+void SeatClient::attach(QIODevice *socket)
+{
+    disconnectFromServer();
+    m_socket = socket;
+    connect(socket, &QIODevice::readyRead, this, &SeatClient::readServer);
+}
+
+void SeatClient::greet()
+{
+    SeatMessage hello;
+    hello.type = SeatMessage::Type::Hello;
+    hello.version = SeatProtocol::Version;
+    hello.seatName = m_seatName;
+    send(hello);
+}
+
+void SeatClient::readServer()
+{
+    m_reader.append(m_socket->readAll());
+    SeatMessage message;
+    while (m_socket && m_reader.next(&message))
+    {
+        switch (message.type)
+        {
+        case SeatMessage::Type::Welcome:
+            m_seatId = message.seatId;
+            emit connected();
+            break;
+        case SeatMessage::Type::Request:
+            emit requestReceived(message);
+            break;
+        case SeatMessage::Type::Withdraw:
+            emit requestWithdrawn(message.requestId);
+            break;
+        default:
+            break;
+        }
+    }
+    if (m_socket && m_reader.hasError())
+    {
+        emit errorOccurred(QStringLiteral("服务器发送了无法解析的数据"));
+        lost();
+    }
+}
+
+void SeatClient::lost()
+{
+    if (m_socket)
+        disconnectFromServer();
+}
+
+void SeatClient::send(const SeatMessage &message)
+{
+    if (m_socket)
+        m_socket->write(SeatProtocol::encode(message));
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+
+#include "seatprotocol.h"
+
+class QIODevice;
+
+// The seat end of the SeatServer protocol: connects, announces the seat by
+// name and reports each request it is handed. Answer with submit() or
+// cancel(), before the request's timeoutMs runs out.
+class SeatClient : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SeatClient(const QString &seatName, QObject *parent = nullptr);
+    ~SeatClient() override;
+
+    void connectToLocal(const QString &serverName);
+    // The server only listens on 127.0.0.1.
+    void connectToTcp(quint16 port);
+    void disconnectFromServer();
+    // True once the server has welcomed the seat.
+    bool isConnected() const { return m_seatId != 0; }
+    quint32 seatId() const { return m_seatId; }
+    const QString &seatName() const { return m_seatName; }
+
+    void submit(quint64 requestId, const ManualAdjudicationState &ruling);
+    void cancel(quint64 requestId);
+
+signals:
+    void connected();
+    void disconnected();
+    void requestReceived(const SeatMessage &request);
+    void requestWithdrawn(quint64 requestId);
+    void errorOccurred(const QString &message);
+
+private:
+    void attach(QIODevice *socket);
+    void greet();
+    void readServer();
+    void lost();
+    void send(const SeatMessage &message);
+
+    QString m_seatName;
+    QIODevice *m_socket = nullptr;
+    SeatFrameReader m_reader;
+    quint32 m_seatId = 0;
+};
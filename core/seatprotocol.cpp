@@ -0,0 +1,189 @@
+﻿#include "seatprotocol.h"
+
+#include <QtEndian>
+
+namespace
+{
+constexpr int kLengthBytes = 4;
+// Reclaim the consumed front of the read buffer once it grows past this.
+constexpr int kCompactBytes = 64 * 1024;
+
+template <typename T>
+void appendLittleEndian(QByteArray &out, T value)
+{
+    char bytes[sizeof(T)];
+    qToLittleEndian<T>(value, bytes);
+    out.append(bytes, int(sizeof(T)));
+}
+
+void appendString(QByteArray &out, const QString &text)
+{
+    const QByteArray utf8 = text.toUtf8();
+    appendLittleEndian<quint32>(out, quint32(utf8.size()));
+    out.append(utf8);
+}
+
+// Reads fields from one payload; any read past the end sets `ok` false and
+// yields zeros.
+class PayloadReader
+{
+public:
+    PayloadReader(const char *data, int size)
+        : m_data(data)
+        , m_size(size)
+    {
+    }
+
+    bool ok() const { return m_ok; }
+    bool atEnd() const { return m_offset == m_size; }
+
+    template <typename T>
+    T read()
+    {
+        if (!take(int(sizeof(T))))
+            return T(0);
+        return qFromLittleEndian<T>(m_data + m_offset - int(sizeof(T)));
+    }
+
+    QString readString()
+    {
+        const quint32 length = read<quint32>();
+        if (length > quint32(m_size - m_offset) || !take(int(length)))
+        {
+            m_ok = false;
+            return QString();
+        }
+        return QString::fromUtf8(m_data + m_offset - int(length), int(length));
+    }
+
+private:
+    bool take(int bytes)
+    {
+        if (!m_ok || m_size - m_offset < bytes)
+        {
+            m_ok = false;
+            return false;
+        }
+        m_offset += bytes;
+        return true;
+    }
+
+    const char *m_data;
+    int m_size;
+    int m_offset = 0;
+    bool m_ok = true;
+};
+
+bool decode(const char *data, int size, SeatMessage *message)
+{
+    PayloadReader in(data, size);
+    SeatMessage decoded;
+    decoded.type = SeatMessage::Type(in.read<quint8>());
+    switch (decoded.type)
+    {
+    case SeatMessage::Type::Hello:
+        decoded.version = in.read<quint16>();
+        decoded.seatName = in.readString();
+        break;
+    case SeatMessage::Type::Welcome:
+        decoded.seatId = in.read<quint32>();
+        break;
+    case SeatMessage::Type::Request:
+        decoded.requestId = in.read<quint64>();
+        decoded.aircraftName = in.readString();
+        decoded.taskName = in.readString();
+        decoded.executionTime = in.read<qint32>();
+        decoded.target.setX(in.read<qint32>());
+        decoded.target.setY(in.read<qint32>());
+        decoded.requirements = in.read<quint8>();
+        decoded.ruling = in.read<quint8>();
+        decoded.timeoutMs = in.read<quint32>();
+        break;
+    case SeatMessage::Type::Ruling:
+        decoded.requestId = in.read<quint64>();
+        decoded.ruling = in.read<quint8>();
+        decoded.cancelled = in.read<quint8>() != 0;
+        break;
+    case SeatMessage::Type::Withdraw:
+        decoded.requestId = in.read<quint64>();
+        break;
+    default:
+        return false;
+    }
+    if (!in.ok() || !in.atEnd())
+        return false;
+    *message = decoded;
+    return true;
+}
+}
+
+QByteArray SeatProtocol::encode(const SeatMessage &message)
+{
+    QByteArray frame(kLengthBytes, '\0');
+    appendLittleEndian<quint8>(frame, quint8(message.type));
+    switch (message.type)
+    {
+    case SeatMessage::Type::Hello:
+        appendLittleEndian<quint16>(frame, message.version);
+        appendString(frame, message.seatName);
+        break;
+    case SeatMessage::Type::Welcome:
+        appendLittleEndian<quint32>(frame, message.seatId);
+        break;
+    case SeatMessage::Type::Request:
+        appendLittleEndian<quint64>(frame, message.requestId);
+        appendString(frame, message.aircraftName);
+        appendString(frame, message.taskName);
+        appendLittleEndian<qint32>(frame, message.executionTime);
+        appendLittleEndian<qint32>(frame, message.target.x());
+        appendLittleEndian<qint32>(frame, message.target.y());
+        appendLittleEndian<quint8>(frame, message.requirements);
+        appendLittleEndian<quint8>(frame, message.ruling);
+        appendLittleEndian<quint32>(frame, message.timeoutMs);
+        break;
+    case SeatMessage::Type::Ruling:
+        appendLittleEndian<quint64>(frame, message.requestId);
+        appendLittleEndian<quint8>(frame, message.ruling);
+        appendLittleEndian<quint8>(frame, message.cancelled ? 1 : 0);
+        break;
+    case SeatMessage::Type::Withdraw:
+        appendLittleEndian<quint64>(frame, message.requestId);
+        break;
+    }
+    qToLittleEndian<quint32>(quint32(frame.size() - kLengthBytes), frame.data());
+    return frame;
+}
+
+void SeatFrameReader::append(const QByteArray &bytes)
+{
+    if (m_error)
+        return;
+    if (m_offset >= kCompactBytes || m_offset == m_buffer.size())
+    {
+        m_buffer.remove(0, m_offset);
+        m_offset = 0;
+    }
+    m_buffer.append(bytes);
+}
+
+bool SeatFrameReader::next(SeatMessage *message)
+{
+    if (m_error || m_buffer.size() - m_offset < kLengthBytes)
+        return false;
+    const quint32 length = qFromLittleEndian<quint32>(m_buffer.constData() + m_offset);
+    if (length == 0 || length > SeatProtocol::MaxFrameBytes)
+    {
+        m_error = true;
+        return false;
+    }
+    if (quint32(m_buffer.size() - m_offset - kLengthBytes) < length)
+        return false;
+    const char *payload = m_buffer.constData() + m_offset + kLengthBytes;
+    m_offset += kLengthBytes + int(length);
+    if (!decode(payload, int(length), message))
+    {
+        m_error = true;
+        return false;
+    }
+    return true;
+}
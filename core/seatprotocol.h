@@ -0,0 +1,76 @@
+#pragma once
+
+#include <QByteArray>
+#include <QPoint>
+#include <QString>
+#include <QtGlobal>
+
+#include "models.h"
+
+// One message between the simulation and an adjudication seat. Only the
+// fields of its type are meaningful:
+//
+//   Hello     seat -> sim   version, seatName
+//   Welcome   sim -> seat   seatId
+//   Request   sim -> seat   requestId, aircraftName, taskName, executionTime,
+//                           target, requirements, ruling (the default), timeoutMs
+//   Ruling    seat -> sim   requestId, ruling, cancelled
+//   Withdraw  sim -> seat   requestId (timed out, or ruled elsewhere)
+struct SeatMessage
+{
+    enum class Type : quint8
+    {
+        Hello = 1,
+        Welcome,
+        Request,
+        Ruling,
+        Withdraw
+    };
+
+    Type type = Type::Hello;
+    quint16 version = 0;
+    quint32 seatId = 0;
+    quint64 requestId = 0;
+    QString seatName;
+    QString aircraftName;
+    QString taskName;
+    qint32 executionTime = 0;
+    QPoint target;
+    quint8 requirements = 0; // TaskRequirementFlag bits
+    quint8 ruling = 0;       // ManualAdjudicationState::bits()
+    bool cancelled = false;
+    quint32 timeoutMs = 0;
+};
+
+// Wire format of the seat protocol. Every frame is a quint32 payload length
+// followed by the payload: a quint8 SeatMessage::Type, then the type's
+// fields in the order listed above. Integers are little-endian, strings a
+// quint32 byte count and UTF-8, the target two qint32, `cancelled` a quint8.
+class SeatProtocol
+{
+public:
+    static constexpr quint16 Version = 1;
+    // Local socket name the simulation and seats use unless told otherwise.
+    static constexpr const char *DefaultServerName = "ruling-seats";
+    // Larger frames are malformed; no message comes close.
+    static constexpr quint32 MaxFrameBytes = 64 * 1024;
+
+    // The whole frame, length prefix included.
+    static QByteArray encode(const SeatMessage &message);
+};
+
+// Splits a socket's byte stream into messages: append() what arrived, then
+// take messages while next() returns true. A malformed or oversized frame
+// stops the reader for good; the connection should then be dropped.
+class SeatFrameReader
+{
+public:
+    void append(const QByteArray &bytes);
+    bool next(SeatMessage *message);
+    bool hasError() const { return m_error; }
+
+private:
+    QByteArray m_buffer;
+    int m_offset = 0; // start of the first unread frame
+    bool m_error = false;
+};
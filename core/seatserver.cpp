@@ -0,0 +1,370 @@
+﻿#include "seatserver.h"
+#include "simulationcore.h"
+
+#include <QHostAddress>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QSet>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+namespace
+{
+constexpr int kTimeoutCheckMs = 100;
+
+void setError(QString *error, const QString &message)
+{
+    if (error)
+        *error = message;
+}
+
+void releaseSocket(QObject *receiver, QIODevice *socket)
+{
+    socket->disconnect(receiver);
+    socket->close();
+    socket->deleteLater();
+}
+}
+
+SeatServer::SeatServer(SimulationCore *core, QObject *parent)
+    : QObject(parent)
+    , m_core(core)
+    , m_localServer(new QLocalServer(this))
+    , m_tcpServer(new QTcpServer(this))
+{
+    m_clock.start();
+    m_timeoutTimer.setInterval(kTimeoutCheckMs);
+    connect(&m_timeoutTimer, &QTimer::timeout, this, &SeatServer::expireRequests);
+    connect(m_localServer, &QLocalServer::newConnection, this, &SeatServer::acceptLocal);
+    connect(m_tcpServer, &QTcpServer::newConnection, this, &SeatServer::acceptTcp);
+}
+
+SeatServer::~SeatServer()
+{
+    close();
+}
+
+bool SeatServer::listen(const QString &localName, quint16 tcpPort, QString *error)
+{
+    close();
+    QLocalServer::removeServer(localName);
+    if (!m_localServer->listen(localName))
+    {
+        setError(error, QStringLiteral("无法监听本地套接字 %1：%2").arg(localName, m_localServer->errorString()));
+        return false;
+    }
+    if (tcpPort != 0 && !m_tcpServer->listen(QHostAddress::LocalHost, tcpPort))
+    {
+        setError(error, QStringLiteral("无法监听端口 %1：%2").arg(tcpPort).arg(m_tcpServer->errorString()));
+        m_localServer->close();
+        return false;
+    }
+    return true;
+}
+
+void SeatServer::close()
+{
+    m_localServer->close();
+    m_tcpServer->close();
+    const bool hadSeats = seatCount() > 0;
+    for (const auto &entry : m_seats)
+    {
+        releaseSocket(this, entry.second->socket);
+    }
+    m_seats.clear();
+    m_requests.clear();
+    m_requestByTask.clear();
+    m_timeoutTimer.stop();
+    if (hadSeats)
+        emit seatsChanged();
+}
+
+bool SeatServer::isListening() const
+{
+    return m_localServer->isListening() || m_tcpServer->isListening();
+}
+
+int SeatServer::seatCount() const
+{
+    int count = 0;
+    for (const auto &entry : m_seats)
+    {
+        if (entry.second->greeted)
+            ++count;
+    }
+    return count;
+}
+
+void SeatServer::setTimeout(int ms)
+{
+    m_timeoutMs = qMax(1, ms);
+}
+
+void SeatServer::setCancelOnTimeout(bool cancel)
+{
+    m_cancelOnTimeout = cancel;
+}
+
+void SeatServer::sync()
+{
+    if (m_requests.isEmpty() && pickSeat() == 0)
+        return;
+
+    const QVector<TaskRef> pending = m_core->pendingRulings();
+    QSet<quint64> queued;
+    queued.reserve(pending.size());
+    for (const TaskRef &task : pending)
+    {
+        queued.insert(task.key());
+    }
+    QVector<quint64> stale;
+    for (auto it = m_requests.cbegin(); it != m_requests.cend(); ++it)
+    {
+        if (!queued.contains(it->task.key()))
+            stale.append(it.key());
+    }
+    for (quint64 requestId : stale)
+    {
+        withdraw(requestId);
+        ++m_stats.withdrawn;
+    }
+
+    for (const TaskRef &task : pending)
+    {
+        if (m_requestByTask.contains(task.key()))
+            continue;
+        const quint32 seatId = pickSeat();
+        if (seatId == 0)
+            break;
+        sendRequest(seatId, task);
+    }
+    if (!m_requests.isEmpty() && !m_timeoutTimer.isActive())
+        m_timeoutTimer.start();
+}
+
+void SeatServer::acceptLocal()
+{
+    while (QLocalSocket *socket = m_localServer->nextPendingConnection())
+    {
+        const quint32 seatId = addSeat(socket);
+        connect(socket, &QLocalSocket::disconnected, this, [this, seatId] { removeSeat(seatId); });
+    }
+}
+
+void SeatServer::acceptTcp()
+{
+    while (QTcpSocket *socket = m_tcpServer->nextPendingConnection())
+    {
+        // Requests and rulings are single small frames; do not let Nagle hold them back.
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        const quint32 seatId = addSeat(socket);
+        connect(socket, &QTcpSocket::disconnected, this, [this, seatId] { removeSeat(seatId); });
+    }
+}
+
+quint32 SeatServer::addSeat(QIODevice *socket)
+{
+    const quint32 seatId = m_nextSeatId++;
+    std::unique_ptr<Seat> seat(new Seat);
+    seat->socket = socket;
+    m_seats.emplace(seatId, std::move(seat));
+    connect(socket, &QIODevice::readyRead, this, [this, seatId] { readSeat(seatId); });
+    return seatId;
+}
+
+void SeatServer::removeSeat(quint32 seatId)
+{
+    auto it = m_seats.find(seatId);
+    if (it == m_seats.end())
+        return;
+    std::unique_ptr<Seat> seat = std::move(it->second);
+    m_seats.erase(it);
+    releaseSocket(this, seat->socket);
+
+    // Its open requests go back to the pool for the next sync().
+    for (auto request = m_requests.begin(); request != m_requests.end();)
+    {
+        if (request->seat == seatId)
+        {
+            m_requestByTask.remove(request->task.key());
+            request = m_requests.erase(request);
+        }
+        else
+        {
+            ++request;
+        }
+    }
+    if (seat->greeted)
+    {
+        emit seatsChanged();
+        sync();
+    }
+}
+
+void SeatServer::readSeat(quint32 seatId)
+{
+    auto it = m_seats.find(seatId);
+    if (it == m_seats.end())
+        return;
+    Seat &seat = *it->second;
+    seat.reader.append(seat.socket->readAll());
+
+    bool greeted = false;
+    bool applied = false;
+    bool protocolError = false;
+    SeatMessage message;
+    while (!protocolError && seat.reader.next(&message))
+    {
+        switch (message.type)
+        {
+        case SeatMessage::Type::Hello:
+        {
+            if (seat.greeted || message.version != SeatProtocol::Version)
+            {
+                protocolError = true;
+                break;
+            }
+            seat.greeted = true;
+            seat.name = message.seatName;
+            SeatMessage welcome;
+            welcome.type = SeatMessage::Type::Welcome;
+            welcome.seatId = seatId;
+            send(seat, welcome);
+            greeted = true;
+            break;
+        }
+        case SeatMessage::Type::Ruling:
+        {
+            if (!seat.greeted)
+            {
+                protocolError = true;
+                break;
+            }
+            // A ruling that crossed a Withdraw on the wire is dropped.
+            auto request = m_requests.find(message.requestId);
+            if (request == m_requests.end() || request->seat != seatId)
+                break;
+            const TaskRef task = request->task;
+            const qint64 latency = m_clock.nsecsElapsed() - request->sentNs;
+            m_requestByTask.remove(task.key());
+            m_requests.erase(request);
+            --seat.openRequests;
+            ++m_stats.ruled;
+            m_stats.latencyNs += latency;
+            m_stats.maxLatencyNs = qMax(m_stats.maxLatencyNs, latency);
+            if (message.cancelled)
+                applied |= m_core->cancelRuling(task);
+            else
+                applied |= m_core->submitRuling(task, ManualAdjudicationState::fromBits(message.ruling));
+            break;
+        }
+        default:
+            protocolError = true;
+            break;
+        }
+    }
+
+    if (protocolError || seat.reader.hasError())
+    {
+        removeSeat(seatId);
+    }
+    else if (greeted)
+    {
+        emit seatsChanged();
+        sync();
+    }
+    if (applied)
+        emit rulingsApplied();
+}
+
+quint32 SeatServer::pickSeat() const
+{
+    quint32 best = 0;
+    int bestLoad = 0;
+    for (const auto &entry : m_seats)
+    {
+        const Seat &seat = *entry.second;
+        if (seat.greeted && (best == 0 || seat.openRequests < bestLoad))
+        {
+            best = entry.first;
+            bestLoad = seat.openRequests;
+        }
+    }
+    return best;
+}
+
+void SeatServer::sendRequest(quint32 seatId, const TaskRef &task)
+{
+    Seat &seat = *m_seats.at(seatId);
+    const SimulationState &state = m_core->state();
+    const int row = state.aircrafts.firstTask(task.aircraft) + task.task;
+
+    SeatMessage message;
+    message.type = SeatMessage::Type::Request;
+    message.requestId = m_nextRequestId++;
+    message.aircraftName = state.aircrafts.name(task.aircraft);
+    message.taskName = state.tasks.name(row);
+    message.executionTime = state.tasks.executionTime(row);
+    message.target = state.tasks.targetPoint(row);
+    message.requirements = state.tasks.requirements(row);
+    message.ruling = ManualAdjudicationState().bits();
+    message.timeoutMs = quint32(m_timeoutMs);
+    send(seat, message);
+
+    Request request;
+    request.task = task;
+    request.seat = seatId;
+    request.sentNs = m_clock.nsecsElapsed();
+    request.deadlineNs = request.sentNs + qint64(m_timeoutMs) * 1000000;
+    m_requests.insert(message.requestId, request);
+    m_requestByTask.insert(task.key(), message.requestId);
+    ++seat.openRequests;
+    ++m_stats.dispatched;
+}
+
+void SeatServer::withdraw(quint64 requestId)
+{
+    const Request request = m_requests.take(requestId);
+    m_requestByTask.remove(request.task.key());
+    auto it = m_seats.find(request.seat);
+    if (it == m_seats.end())
+        return;
+    Seat &seat = *it->second;
+    --seat.openRequests;
+    SeatMessage message;
+    message.type = SeatMessage::Type::Withdraw;
+    message.requestId = requestId;
+    send(seat, message);
+}
+
+void SeatServer::expireRequests()
+{
+    const qint64 now = m_clock.nsecsElapsed();
+    QVector<quint64> expired;
+    for (auto it = m_requests.cbegin(); it != m_requests.cend(); ++it)
+    {
+        if (it->deadlineNs <= now)
+            expired.append(it.key());
+    }
+
+    bool applied = false;
+    for (quint64 requestId : expired)
+    {
+        const TaskRef task = m_requests.value(requestId).task;
+        withdraw(requestId);
+        ++m_stats.timedOut;
+        if (m_cancelOnTimeout)
+            applied |= m_core->cancelRuling(task);
+        else
+            applied |= m_core->submitRuling(task, ManualAdjudicationState());
+    }
+    if (m_requests.isEmpty())
+        m_timeoutTimer.stop();
+    if (applied)
+        emit rulingsApplied();
+}
+
+void SeatServer::send(Seat &seat, const SeatMessage &message)
+{
+    seat.socket->write(SeatProtocol::encode(message));
+}
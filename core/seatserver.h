@@ -0,0 +1,118 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+
+#include <map>
+#include <memory>
+
+#include "seatprotocol.h"
+#include "taskscheduler.h"
+
+class QIODevice;
+class QLocalServer;
+class QTcpServer;
+class SimulationCore;
+
+// Hands the core's queued manual rulings (SimulationCore::pendingRulings)
+// to adjudication seats in other processes, connected over a local socket
+// or TCP on 127.0.0.1, and submits their rulings as they come back. Each
+// queued task goes to the connected seat with the fewest open requests. A
+// request not answered within the timeout is withdrawn and decided by
+// default: the default ManualAdjudicationState, or a cancellation.
+//
+// Tasks that arrive while no seat is connected stay queued in the core,
+// where the in-process panel can still rule them.
+class SeatServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int DefaultTimeoutMs = 30000;
+
+    struct Stats
+    {
+        qint64 dispatched = 0;
+        qint64 ruled = 0;    // by a seat, cancellations included
+        qint64 timedOut = 0;
+        qint64 withdrawn = 0; // ruled elsewhere or edited away first
+        qint64 latencyNs = 0; // request to ruling, summed over `ruled`
+        qint64 maxLatencyNs = 0;
+    };
+
+    explicit SeatServer(SimulationCore *core, QObject *parent = nullptr);
+    ~SeatServer() override;
+
+    // Listens on the local socket `localName` and, unless tcpPort is 0, on
+    // that port of 127.0.0.1. A stale socket left by a crashed run is removed.
+    bool listen(const QString &localName, quint16 tcpPort = 0, QString *error = nullptr);
+    // Disconnects every seat; open requests stay queued in the core.
+    void close();
+    bool isListening() const;
+
+    int seatCount() const;
+    int openRequestCount() const { return m_requests.size(); }
+    const Stats &stats() const { return m_stats; }
+
+    void setTimeout(int ms);
+    int timeout() const { return m_timeoutMs; }
+    // Timed-out requests are cancelled instead of given the default ruling.
+    void setCancelOnTimeout(bool cancel);
+
+    // Sends newly queued tasks to seats and withdraws requests whose task
+    // is no longer queued. Call after the core advances, seeks or is edited.
+    void sync();
+
+signals:
+    // A seat's ruling or a timeout default changed task statuses in the core.
+    void rulingsApplied();
+    void seatsChanged();
+
+private:
+    struct Seat
+    {
+        QIODevice *socket = nullptr;
+        QString name;
+        SeatFrameReader reader;
+        int openRequests = 0;
+        bool greeted = false;
+    };
+    struct Request
+    {
+        TaskRef task;
+        quint32 seat = 0;
+        qint64 sentNs = 0;
+        qint64 deadlineNs = 0;
+    };
+
+    void acceptLocal();
+    void acceptTcp();
+    quint32 addSeat(QIODevice *socket);
+    void removeSeat(quint32 seatId);
+    // Handles every complete message the seat sent; a protocol error drops the seat.
+    void readSeat(quint32 seatId);
+    // Least-loaded greeted seat, or 0 if none.
+    quint32 pickSeat() const;
+    void sendRequest(quint32 seatId, const TaskRef &task);
+    // Drops the request and tells its seat, if it is still connected.
+    void withdraw(quint64 requestId);
+    void expireRequests();
+    void send(Seat &seat, const SeatMessage &message);
+
+    SimulationCore *m_core;
+    QLocalServer *m_localServer;
+    QTcpServer *m_tcpServer;
+    QTimer m_timeoutTimer;
+    QElapsedTimer m_clock;
+    std::map<quint32, std::unique_ptr<Seat>> m_seats;
+    QHash<quint64, Request> m_requests;    // by request id
+    QHash<quint64, quint64> m_requestByTask; // TaskRef::key() -> request id
+    quint32 m_nextSeatId = 1;
+    quint64 m_nextRequestId = 1;
+    int m_timeoutMs = DefaultTimeoutMs;
+    bool m_cancelOnTimeout = false;
+    Stats m_stats;
+};
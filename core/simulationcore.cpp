@@ -0,0 +1,849 @@
+﻿#include "simulationcore.h"
+#include "scenariofile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+// Chunk sizes fix how a tick is split, independently of the thread count.
+constexpr int kAircraftChunk = 4096;
+constexpr int kTaskChunk = 256;
+}
+
+void SimulationCore::setManualAdjudicator(ManualAdjudicator adjudicator)
+{
+    m_manualAdjudicator = std::move(adjudicator);
+}
+
+void SimulationCore::setManualQueueEnabled(bool enabled)
+{
+    m_manualQueueEnabled = enabled;
+}
+
+void SimulationCore::setManualHoldPolicy(ManualHoldPolicy policy)
+{
+    if (policy == m_holdPolicy)
+        return;
+    m_holdPolicy = policy;
+    rebuildHolds();
+}
+
+QVector<TaskRef> SimulationCore::pendingRulings() const
+{
+    QVector<TaskRef> pending;
+    pending.reserve(m_awaitingSlots.size());
+    for (int row : m_awaiting)
+    {
+        if (row >= 0)
+            pending.append(refForRow(row));
+    }
+    return pending;
+}
+
+bool SimulationCore::submitRuling(const TaskRef &task, const ManualAdjudicationState &ruling)
+{
+    const int row = takeAwaiting(task);
+    if (row < 0)
+        return false;
+    handleTask(row, &ruling);
+    trackChange(row);
+    updateHold(task.aircraft);
+    return true;
+}
+
+bool SimulationCore::cancelRuling(const TaskRef &task)
+{
+    const int row = takeAwaiting(task);
+    if (row < 0)
+        return false;
+    const int ruleIndex = ruleIndexFor(m_state.tasks.rule(row));
+    appendLog(m_state.aircrafts.name(task.aircraft), m_state.tasks.name(row), QStringLiteral("人工裁决被取消，任务失败"));
+    m_state.tasks.setStatus(row, TaskStatus::Failed);
+    recordAdjudication(row, ruleIndex >= 0 ? &m_state.rules.at(ruleIndex) : nullptr, currentModel(), TaskStatus::Failed, {},
+                       JournalRecord::Cancelled);
+    trackChange(row);
+    updateHold(task.aircraft);
+    return true;
+}
+
+void SimulationCore::setReplication(quint64 replication)
+{
+    m_replication = replication;
+}
+
+void SimulationCore::setLoggingEnabled(bool enabled)
+{
+    m_loggingEnabled = enabled;
+}
+
+void SimulationCore::setThreadCount(int threadCount)
+{
+    m_pool.setThreadCount(threadCount);
+}
+
+void SimulationCore::setChangeTrackingEnabled(bool enabled)
+{
+    m_changeTrackingEnabled = enabled;
+    m_changedTasks.clear();
+}
+
+QVector<TaskRef> SimulationCore::takeChangedTasks()
+{
+    QVector<TaskRef> changed;
+    changed.swap(m_changedTasks);
+    return changed;
+}
+
+void SimulationCore::loadSampleScenario(const QSize &gridSize)
+{
+    stopJournal();
+    m_state.logs.clear();
+    m_state.simulationTime = 0;
+    m_state.aircrafts.clear();
+    m_state.tasks.clear();
+    m_state.rules.clear();
+    m_state.models.clear();
+    m_scores.clear();
+    m_state.mode = AdjudicationMode::Automatic;
+    m_state.environment.resize(gridSize.width(), gridSize.height());
+
+    AdjudicationRule baseRule;
+    baseRule.name = QStringLiteral("标准规则");
+    baseRule.successThreshold = 60;
+    baseRule.behaviorWeights.insert(QStringLiteral("fire"), 25);
+    baseRule.behaviorWeights.insert(QStringLiteral("hit"), 25);
+    baseRule.behaviorWeights.insert(QStringLiteral("detect"), 20);
+    baseRule.behaviorWeights.insert(QStringLiteral("jam"), 15);
+    AdjudicationEngine::compileRule(baseRule);
+    const RuleId baseRuleId = m_state.rules.append(baseRule);
+
+    AdjudicationRule aggressiveRule;
+    aggressiveRule.name = QStringLiteral("进攻优先");
+    aggressiveRule.successThreshold = 55;
+    aggressiveRule.behaviorWeights.insert(QStringLiteral("fire"), 30);
+    aggressiveRule.behaviorWeights.insert(QStringLiteral("hit"), 30);
+    aggressiveRule.behaviorWeights.insert(QStringLiteral("detect"), 10);
+    aggressiveRule.behaviorWeights.insert(QStringLiteral("jam"), 15);
+    AdjudicationEngine::compileRule(aggressiveRule);
+    const RuleId aggressiveRuleId = m_state.rules.append(aggressiveRule);
+
+    // Hits count double when the target was detected through a quiet spectrum.
+    AdjudicationRule cooperativeRule = baseRule;
+    cooperativeRule.name = QStringLiteral("协同探测");
+    cooperativeRule.expression = QStringLiteral("fire * w_fire + hit * w_hit * (detect && emInterference < 30 ? 2 : 1)"
+                                                " + detect * w_detect + jam * w_jam");
+    AdjudicationEngine::compileRule(cooperativeRule);
+    m_state.rules.append(cooperativeRule);
+
+    AdjudicationModel envModel;
+    envModel.name = QStringLiteral("环境优先模型");
+    envModel.factorKeys = QStringList{QStringLiteral("oceanDepth"), QStringLiteral("airDryness"), QStringLiteral("emInterference")};
+    envModel.environmentWeight = 0.8;
+    AdjudicationEngine::compileModel(envModel);
+    const ModelId envModelId = m_state.models.append(envModel);
+
+    AdjudicationModel balancedModel;
+    balancedModel.name = QStringLiteral("均衡模型");
+    balancedModel.factorKeys = QStringList{QStringLiteral("temperature"), QStringLiteral("humidity")};
+    balancedModel.environmentWeight = 0.6;
+    AdjudicationEngine::compileModel(balancedModel);
+    m_state.models.append(balancedModel);
+
+    m_state.currentRuleId = baseRuleId;
+    m_state.currentModelId = envModelId;
+
+    Aircraft red;
+    red.name = QStringLiteral("红方-1");
+    red.route = {QPoint(2, 2), QPoint(10, 5), QPoint(20, 15), QPoint(30, 25), QPoint(40, 35)};
+    red.secondsPerStep = 1.5;
+
+    Task patrol;
+    patrol.name = QStringLiteral("空域巡逻");
+    patrol.executionTime = 3;
+    patrol.requiresDetection = true;
+    patrol.targetCell = QPoint(10, 5);
+    patrol.ruleId = baseRuleId;
+    m_state.tasks.append(0, patrol);
+
+    Task strike;
+    strike.name = QStringLiteral("远程打击");
+    strike.executionTime = 8;
+    strike.requiresFire = true;
+    strike.requiresHit = true;
+    strike.requiresJam = true;
+    strike.targetCell = QPoint(30, 25);
+    strike.ruleId = aggressiveRuleId;
+    m_state.tasks.append(0, strike);
+
+    Aircraft blue;
+    blue.name = QStringLiteral("蓝方-1");
+    blue.route = {QPoint(48, 10), QPoint(40, 12), QPoint(32, 20), QPoint(20, 30), QPoint(5, 40)};
+    blue.secondsPerStep = 1.2;
+
+    Task recon;
+    recon.name = QStringLiteral("光电侦察");
+    recon.executionTime = 5;
+    recon.requiresDetection = true;
+    recon.targetCell = QPoint(32, 20);
+    recon.ruleId = baseRuleId;
+    m_state.tasks.append(1, recon);
+
+    Task support;
+    support.name = QStringLiteral("干扰支援");
+    support.executionTime = 9;
+    support.requiresJam = true;
+    support.targetCell = QPoint(20, 30);
+    m_state.tasks.append(1, support);
+
+    m_state.aircrafts.add(red);
+    m_state.aircrafts.add(blue);
+    m_state.tasks.assignRanges(m_state.aircrafts);
+
+    rebuildSchedule();
+    restartTimeline();
+}
+
+bool SimulationCore::loadScenario(const QString &path, QString *error)
+{
+    if (!ScenarioFile::load(path, m_state, error))
+        return false;
+    stopJournal();
+    m_scores.clear();
+    reset();
+    return true;
+}
+
+bool SimulationCore::saveScenario(const QString &path, QString *error) const
+{
+    return ScenarioFile::save(path, m_state, ScenarioFile::formatForPath(path), error);
+}
+
+void SimulationCore::reset()
+{
+    m_state.simulationTime = 0;
+    if (m_journal.isOpen())
+    {
+        m_journal.recordReset();
+    }
+
+    m_state.aircrafts.resetMotion();
+    m_state.tasks.resetStatuses();
+
+    m_state.logs.clear();
+    m_changedTasks.clear();
+    rebuildSchedule();
+    restartTimeline();
+}
+
+void SimulationCore::rebuildSchedule()
+{
+    m_scheduler.rebuild(m_state.tasks);
+    rebuildAwaiting();
+}
+
+void SimulationCore::environmentCellChanged(const QPoint &cell)
+{
+    m_scores.invalidateCell(cell);
+    m_historyEdited = true;
+    if (m_journal.isOpen())
+    {
+        m_journal.recordCell(cell, m_state.environment.at(cell), m_state.simulationTime);
+    }
+}
+
+bool SimulationCore::startJournal(const QString &path, QString *error)
+{
+    // Reloading the snapshot renumbers rules and aircraft exactly as replay
+    // will, so the handles in the records match.
+    const QByteArray scenario = ScenarioFile::toBinary(m_state);
+    if (!ScenarioFile::fromBinary(scenario.constData(), scenario.size(), m_state, error))
+        return false;
+    const bool opened = m_journal.open(path, scenario, m_state, m_replication, error);
+    reset();
+    return opened;
+}
+
+void SimulationCore::stopJournal()
+{
+    m_journal.close();
+}
+
+bool SimulationCore::startResultChannel(const QString &name, int capacity, QString *error)
+{
+    return m_results.open(name, capacity, error);
+}
+
+void SimulationCore::stopResultChannel()
+{
+    m_results.close();
+}
+
+bool SimulationCore::loadReplay(const QString &path, const ReplayJournal::Options &options, QString *error)
+{
+    if (!ReplayJournal::replay(path, m_state, options, error))
+        return false;
+    stopJournal();
+    m_scores.clear();
+    m_changedTasks.clear();
+    rebuildSchedule();
+    restartTimeline();
+    return true;
+}
+
+void SimulationCore::scenarioEdited()
+{
+    m_journal.recordEdits(m_state);
+    checkJournal();
+    m_scores.retainModels(m_state.models);
+    m_historyEdited = true;
+}
+
+void SimulationCore::setSnapshotInterval(double seconds)
+{
+    m_timeline.setInterval(seconds);
+    if (m_timeline.isEmpty())
+    {
+        m_timeline.capture(m_state, m_scheduler);
+    }
+}
+
+void SimulationCore::setSnapshotBudget(qint64 bytes)
+{
+    m_timeline.setBudget(bytes);
+}
+
+bool SimulationCore::seek(double time)
+{
+    settleEdits();
+    time = qMax(0.0, time);
+    const int index = m_timeline.latestAtOrBefore(time);
+    const bool forward = time >= m_state.simulationTime;
+    if (index < 0 && !forward)
+        return false;
+
+    if (index >= 0 && (!forward || m_timeline.time(index) > m_state.simulationTime))
+    {
+        stopJournal();
+        m_timeline.restore(index, m_state, m_scheduler);
+        // Cells edited after the snapshot may still be in the score fields.
+        m_scores.clear();
+        m_changedTasks.clear();
+        rebuildAwaiting();
+        if (m_state.mode == AdjudicationMode::Manual)
+        {
+            // The operator may rule differently this time.
+            m_timeline.truncateFrom(std::nextafter(m_state.simulationTime, std::numeric_limits<double>::infinity()));
+            m_timelineEnd = m_state.simulationTime;
+        }
+    }
+
+    // Each task is adjudicated at its own time, as the stepped run did, so
+    // the log reads the same.
+    while (!m_scheduler.isEmpty() && m_scheduler.nextTime() < time && !isHeld())
+    {
+        advanceTo(qMax(double(m_scheduler.nextTime()), m_state.simulationTime));
+    }
+    advanceTo(time);
+    return true;
+}
+
+void SimulationCore::step(double seconds)
+{
+    advanceTo(m_state.simulationTime + seconds);
+}
+
+void SimulationCore::advanceTo(double time)
+{
+    if (time < m_state.simulationTime || isHeld())
+        return;
+    settleEdits();
+
+    const double elapsed = time - m_state.simulationTime;
+    m_state.simulationTime = time;
+
+    if (elapsed > 0.0)
+    {
+        moveAircraft(elapsed);
+        if (m_journal.isOpen())
+        {
+            m_journal.recordTick(time);
+        }
+    }
+
+    evaluateDueTasks();
+
+    m_timelineEnd = qMax(m_timelineEnd, time);
+    if (m_timeline.isDue(time))
+    {
+        m_timeline.capture(m_state, m_scheduler);
+    }
+    checkJournal();
+}
+
+double SimulationCore::nextEventTime() const
+{
+    const double next = m_scheduler.isEmpty() ? std::numeric_limits<double>::infinity() : m_scheduler.nextTime();
+    return qMin(next, m_state.simulationTime + m_state.aircrafts.timeToNextStep());
+}
+
+bool SimulationCore::isFinished() const
+{
+    return m_scheduler.isEmpty() && !hasPendingRulings();
+}
+
+void SimulationCore::runToCompletion(int maxSimulationTime)
+{
+    // Aircraft positions do not feed adjudication, so only task times matter here.
+    while (!isFinished() && !isHeld() && m_state.simulationTime < maxSimulationTime)
+    {
+        const double next = qMax(double(m_scheduler.nextTime()), m_state.simulationTime);
+        advanceTo(qMin(next, double(maxSimulationTime)));
+    }
+}
+
+int SimulationCore::ruleIndexFor(RuleId rule) const
+{
+    int index = m_state.rules.indexOf(rule == NoId ? m_state.currentRuleId : rule);
+    if (index < 0 && !m_state.rules.isEmpty())
+    {
+        index = 0;
+    }
+    return index;
+}
+
+TaskRef SimulationCore::refForRow(int row) const
+{
+    const int aircraft = m_state.tasks.aircraft(row);
+    return {aircraft, row - m_state.aircrafts.firstTask(aircraft)};
+}
+
+AdjudicationModel *SimulationCore::currentModel()
+{
+    AdjudicationModel *model = m_state.models.find(m_state.currentModelId);
+    if (!model && !m_state.models.isEmpty())
+    {
+        model = &m_state.models[0];
+    }
+    return model;
+}
+
+void SimulationCore::restartTimeline()
+{
+    m_timeline.clear();
+    m_timeline.capture(m_state, m_scheduler);
+    m_timelineEnd = 0.0;
+    m_historyEdited = false;
+}
+
+void SimulationCore::settleEdits()
+{
+    if (!m_historyEdited)
+        return;
+    m_historyEdited = false;
+    m_timeline.truncateFrom(m_state.simulationTime);
+    m_timeline.capture(m_state, m_scheduler);
+    m_timelineEnd = m_state.simulationTime;
+}
+
+template <typename Fn>
+void SimulationCore::forEachChunk(int count, int chunkSize, Fn &&fn)
+{
+    const int chunks = (count + chunkSize - 1) / chunkSize;
+    m_pool.run(chunks, [&](int chunk) {
+        const int begin = chunk * chunkSize;
+        fn(chunk, begin, qMin(begin + chunkSize, count));
+    });
+}
+
+void SimulationCore::moveAircraft(double seconds)
+{
+    AircraftStore &aircrafts = m_state.aircrafts;
+    aircrafts.detachMotion();
+    forEachChunk(aircrafts.size(), kAircraftChunk, [&](int, int begin, int end) {
+        aircrafts.advance(seconds, begin, end);
+    });
+}
+
+void SimulationCore::evaluateDueTasks()
+{
+    QVector<int> due;
+    m_scheduler.popDue(m_state.simulationTime, m_state.tasks, due);
+
+    if (due.isEmpty())
+        return;
+
+    // Every due task leaves Pending, whichever path adjudicates it.
+    if (m_changeTrackingEnabled)
+    {
+        m_changedTasks.reserve(m_changedTasks.size() + due.size());
+        for (int row : due)
+        {
+            m_changedTasks.append(refForRow(row));
+        }
+    }
+
+    m_engine.setRandomStream(m_state.randomSeed, m_replication);
+    if (m_state.mode != AdjudicationMode::Manual)
+    {
+        adjudicateBatch(due);
+        return;
+    }
+
+    for (int row : due)
+    {
+        handleTask(row);
+    }
+}
+
+void SimulationCore::adjudicateBatch(const QVector<int> &due)
+{
+    AdjudicationModel *model = currentModel();
+    // Each task's environment verdict is a single lookup in the model's score field.
+    ScoreField *scores = model ? &m_scores.field(m_state.environment, *model) : nullptr;
+
+    const TaskTable &tasks = m_state.tasks;
+    m_batch.resize(due.size());
+    QVector<int> taskRule(due.size());
+    for (int i = 0; i < due.size(); ++i)
+    {
+        const int row = due.at(i);
+        const int r = ruleIndexFor(tasks.rule(row));
+        taskRule[i] = r;
+
+        const AdjudicationRule *rule = r >= 0 ? &m_state.rules.at(r) : nullptr;
+        const std::array<qint32, TaskEventCount> weights = rule ? rule->eventWeights : std::array<qint32, TaskEventCount>{};
+        const QPoint target = tasks.targetPoint(row);
+        m_batch.requirements[i] = tasks.requirements(row);
+        m_batch.taskKeys[i] = refForRow(row).key();
+        m_batch.baseScores[i] = scores ? scores->at(target) : 0.0;
+        m_batch.fireWeights[i] = weights[int(TaskEvent::Fire)];
+        m_batch.hitWeights[i] = weights[int(TaskEvent::Hit)];
+        m_batch.detectWeights[i] = weights[int(TaskEvent::Detect)];
+        m_batch.jamWeights[i] = weights[int(TaskEvent::Jam)];
+        m_batch.thresholds[i] = rule ? rule->successThreshold : 0;
+        const RuleProgram *program = rule && !rule->program.isEmpty() ? &rule->program : nullptr;
+        m_batch.programs[i] = program;
+        if (program)
+        {
+            m_batch.factors[i] = m_state.environment.at(target);
+        }
+    }
+
+    const AdjudicationBatch batch = m_batch.view();
+    if (model)
+    {
+        forEachChunk(batch.count, kTaskChunk, [&](int, int begin, int end) {
+            m_engine.adjudicateBatch(batch.slice(begin, end - begin), m_state.mode);
+        });
+    }
+
+    for (int i = 0; i < due.size(); ++i)
+    {
+        const bool adjudicated = taskRule.at(i) >= 0 && model;
+        const TaskStatus status = adjudicated ? TaskStatus(batch.statuses[i]) : TaskStatus::Failed;
+        m_state.tasks.setStatus(due.at(i), status);
+        if (m_journal.isOpen() || m_results.isOpen())
+        {
+            const AdjudicationRule *rule = taskRule.at(i) >= 0 ? &m_state.rules.at(taskRule.at(i)) : nullptr;
+            AdjudicationOutcome outcome;
+            outcome.outcomes = adjudicated ? batch.outcomes[i] : 0;
+            outcome.score = adjudicated ? batch.scores[i] : 0.0;
+            const quint8 flags = !rule ? JournalRecord::NoRule : !model ? JournalRecord::NoModel : 0;
+            recordAdjudication(due.at(i), rule, model, status, outcome, flags);
+        }
+    }
+    if (!m_loggingEnabled)
+        return;
+
+    // Building the log text is the costly part; each chunk writes its own
+    // buffer and the buffers are appended in chunk order, so the log reads
+    // the same whatever the thread count.
+    m_chunkLogs.resize(size_t((due.size() + kTaskChunk - 1) / kTaskChunk));
+    forEachChunk(due.size(), kTaskChunk, [&](int chunk, int begin, int end) {
+        std::vector<TaskLogEntry> &logs = m_chunkLogs[size_t(chunk)];
+        logs.clear();
+        QStringList lines;
+        for (int i = begin; i < end; ++i)
+        {
+            const int row = due.at(i);
+            const QString &aircraftName = m_state.aircrafts.name(m_state.tasks.aircraft(row));
+            const QString &taskName = m_state.tasks.name(row);
+            if (taskRule.at(i) < 0)
+            {
+                logs.push_back(logEntry(aircraftName, taskName, QStringLiteral("未找到可用的裁决规则")));
+                continue;
+            }
+            if (!model)
+            {
+                logs.push_back(logEntry(aircraftName, taskName, QStringLiteral("未找到可用的裁决模型")));
+                continue;
+            }
+
+            lines.clear();
+            AdjudicationEngine::describeBatchResult(batch, i, &lines);
+            for (const QString &line : lines)
+            {
+                logs.push_back(logEntry(aircraftName, taskName, line));
+            }
+            const bool success = TaskStatus(batch.statuses[i]) == TaskStatus::Success;
+            logs.push_back(logEntry(aircraftName, taskName, success ? QStringLiteral("任务裁决成功") : QStringLiteral("任务裁决失败")));
+        }
+    });
+    for (const std::vector<TaskLogEntry> &logs : m_chunkLogs)
+    {
+        for (const TaskLogEntry &entry : logs)
+        {
+            m_state.logs.append(entry);
+        }
+    }
+}
+
+void SimulationCore::handleTask(int row, const ManualAdjudicationState *ruling)
+{
+    if (!ruling && m_state.mode == AdjudicationMode::Manual && m_manualQueueEnabled)
+    {
+        queueRuling(row);
+        return;
+    }
+
+    const Aircraft aircraft = m_state.aircrafts.aircraft(m_state.tasks.aircraft(row));
+    Task task = m_state.tasks.task(row);
+
+    const int ruleIndex = ruleIndexFor(task.ruleId);
+    if (ruleIndex < 0)
+    {
+        appendLog(aircraft.name, task.name, QStringLiteral("未找到可用的裁决规则"));
+        m_state.tasks.setStatus(row, TaskStatus::Failed);
+        recordAdjudication(row, nullptr, currentModel(), TaskStatus::Failed, {}, JournalRecord::NoRule);
+        return;
+    }
+    const AdjudicationRule &rule = m_state.rules.at(ruleIndex);
+
+    const AdjudicationModel *model = currentModel();
+    if (!model)
+    {
+        appendLog(aircraft.name, task.name, QStringLiteral("未找到可用的裁决模型"));
+        m_state.tasks.setStatus(row, TaskStatus::Failed);
+        recordAdjudication(row, &rule, nullptr, TaskStatus::Failed, {}, JournalRecord::NoModel);
+        return;
+    }
+
+    // Without an adjudicator attached (batch runs) the default manual ruling applies.
+    ManualAdjudicationState manualState;
+    if (ruling)
+    {
+        manualState = *ruling;
+    }
+    else if (m_state.mode == AdjudicationMode::Manual && m_manualAdjudicator)
+    {
+        if (!m_manualAdjudicator(aircraft, task, manualState))
+        {
+            appendLog(aircraft.name, task.name, QStringLiteral("人工裁决被取消，任务失败"));
+            m_state.tasks.setStatus(row, TaskStatus::Failed);
+            recordAdjudication(row, &rule, model, TaskStatus::Failed, {}, JournalRecord::Cancelled);
+            return;
+        }
+    }
+
+    QStringList logEntries;
+    AdjudicationOutcome outcome;
+    const EnvironmentFactors factors = m_state.environment.at(task.targetCell);
+    // A queued ruling is applied as given, even if the mode has changed since.
+    const AdjudicationMode mode = ruling ? AdjudicationMode::Manual : m_state.mode;
+    const TaskStatus status = m_engine.adjudicate(task, factors, rule, *model, mode, manualState, refForRow(row).key(),
+                                                  &logEntries, &outcome);
+    m_state.tasks.setStatus(row, status);
+    recordAdjudication(row, &rule, model, status, outcome, 0, manualState.bits());
+    for (const QString &line : logEntries)
+    {
+        appendLog(aircraft.name, task.name, line);
+    }
+    appendLog(aircraft.name, task.name, status == TaskStatus::Success ? QStringLiteral("任务裁决成功") : QStringLiteral("任务裁决失败"));
+}
+
+void SimulationCore::queueRuling(int row)
+{
+    const int aircraft = m_state.tasks.aircraft(row);
+    m_state.tasks.setStatus(row, TaskStatus::AwaitingRuling);
+    m_awaitingSlots.insert(row, m_awaiting.size());
+    m_awaiting.append(row);
+    if (aircraft >= m_awaitingPerAircraft.size())
+        m_awaitingPerAircraft.resize(m_state.aircrafts.size());
+    ++m_awaitingPerAircraft[aircraft];
+    appendLog(m_state.aircrafts.name(aircraft), m_state.tasks.name(row), QStringLiteral("等待人工裁决"));
+    if (m_journal.isOpen())
+    {
+        m_journal.recordQueued(m_state.aircrafts.handle(aircraft), refForRow(row).task, m_state.simulationTime);
+    }
+    updateHold(aircraft);
+}
+
+int SimulationCore::takeAwaiting(const TaskRef &task)
+{
+    if (task.aircraft < 0 || task.aircraft >= m_state.aircrafts.size() || task.task < 0
+        || task.task >= m_state.aircrafts.taskCount(task.aircraft))
+        return -1;
+    const int row = m_state.aircrafts.firstTask(task.aircraft) + task.task;
+    const auto slot = m_awaitingSlots.constFind(row);
+    if (slot == m_awaitingSlots.cend())
+        return -1;
+    m_awaiting[slot.value()] = -1;
+    m_awaitingSlots.erase(slot);
+    --m_awaitingPerAircraft[task.aircraft];
+
+    // Compact once ruled rows make up more than half the queue.
+    if (m_awaiting.size() > 2 * m_awaitingSlots.size() + 16)
+    {
+        m_awaiting.erase(std::remove(m_awaiting.begin(), m_awaiting.end(), -1), m_awaiting.end());
+        for (int i = 0; i < m_awaiting.size(); ++i)
+        {
+            m_awaitingSlots[m_awaiting.at(i)] = i;
+        }
+    }
+    return row;
+}
+
+void SimulationCore::rebuildAwaiting()
+{
+    // Row numbers move with task edits, so the queue is rebuilt from the
+    // statuses, oldest execution time first.
+    const TaskTable &tasks = m_state.tasks;
+    m_awaiting.clear();
+    for (int row = 0; row < tasks.size(); ++row)
+    {
+        if (tasks.status(row) == TaskStatus::AwaitingRuling)
+            m_awaiting.append(row);
+    }
+    std::stable_sort(m_awaiting.begin(), m_awaiting.end(), [&tasks](int a, int b) {
+        return tasks.executionTime(a) < tasks.executionTime(b);
+    });
+
+    m_awaitingSlots.clear();
+    m_awaitingSlots.reserve(m_awaiting.size());
+    m_awaitingPerAircraft.fill(0, m_state.aircrafts.size());
+    for (int i = 0; i < m_awaiting.size(); ++i)
+    {
+        m_awaitingSlots.insert(m_awaiting.at(i), i);
+        ++m_awaitingPerAircraft[tasks.aircraft(m_awaiting.at(i))];
+    }
+    rebuildHolds();
+}
+
+void SimulationCore::rebuildHolds()
+{
+    for (int aircraft = 0; aircraft < m_state.aircrafts.size(); ++aircraft)
+    {
+        updateHold(aircraft);
+    }
+}
+
+void SimulationCore::updateHold(int aircraft)
+{
+    setHeld(aircraft, m_holdPolicy == ManualHoldPolicy::HoldAffected && m_awaitingPerAircraft.value(aircraft) > 0);
+}
+
+void SimulationCore::setHeld(int aircraft, bool held)
+{
+    if (m_state.aircrafts.isHeld(aircraft) == held)
+        return;
+    m_state.aircrafts.setHeld(aircraft, held);
+    if (m_journal.isOpen())
+    {
+        m_journal.recordHold(m_state.aircrafts.handle(aircraft), held, m_state.simulationTime);
+    }
+}
+
+void SimulationCore::checkJournal()
+{
+    if (m_journal.isOpen() && m_journal.hasError())
+    {
+        stopJournal();
+    }
+}
+
+void SimulationCore::trackChange(int row)
+{
+    if (m_changeTrackingEnabled)
+    {
+        m_changedTasks.append(refForRow(row));
+    }
+}
+
+void SimulationCore::recordAdjudication(int row,
+                                        const AdjudicationRule *rule,
+                                        const AdjudicationModel *model,
+                                        TaskStatus status,
+                                        const AdjudicationOutcome &outcome,
+                                        quint8 flags,
+                                        quint8 manual)
+{
+    if (!m_journal.isOpen() && !m_results.isOpen())
+        return;
+
+    const TaskRef ref = refForRow(row);
+    const AircraftHandle handle = m_state.aircrafts.handle(ref.aircraft);
+    if (m_results.isOpen())
+    {
+        ResultRecord result;
+        result.time = m_state.simulationTime;
+        result.score = outcome.score;
+        result.aircraftSlot = handle.slot;
+        result.aircraftGeneration = handle.generation;
+        result.task = ref.task;
+        result.threshold = rule ? rule->successThreshold : 0;
+        result.requirements = m_state.tasks.requirements(row);
+        result.outcomes = outcome.outcomes;
+        result.status = quint8(status);
+        result.mode = quint8(m_state.mode);
+        result.flags = flags;
+        result.manual = manual;
+        result.reserved[0] = result.reserved[1] = 0;
+        ResultRecord::setName(result.aircraftName, int(sizeof(result.aircraftName)), m_state.aircrafts.name(ref.aircraft));
+        ResultRecord::setName(result.taskName, int(sizeof(result.taskName)), m_state.tasks.name(row));
+        m_results.publish(result);
+    }
+    if (!m_journal.isOpen())
+        return;
+
+    const EnvironmentFactors factors = m_state.environment.at(m_state.tasks.targetPoint(row));
+    JournalRecord::Adjudication record = JournalRecord::make(JournalRecord::Type::Adjudication, 0.0).adjudication;
+    record.score = outcome.score;
+    record.aircraftSlot = handle.slot;
+    record.aircraftGeneration = handle.generation;
+    record.task = ref.task;
+    record.rule = rule ? rule->id : NoId;
+    record.model = model ? model->id : NoId;
+    record.threshold = rule ? rule->successThreshold : 0;
+    record.requirements = m_state.tasks.requirements(row);
+    record.outcomes = outcome.outcomes;
+    record.status = quint8(status);
+    record.mode = quint8(m_state.mode);
+    record.manual = manual;
+    record.flags = flags;
+    record.factors[int(EnvironmentFactor::OceanDepth)] = quint8(factors.oceanDepth);
+    record.factors[int(EnvironmentFactor::AirDryness)] = quint8(factors.airDryness);
+    record.factors[int(EnvironmentFactor::EmInterference)] = quint8(factors.emInterference);
+    record.factors[int(EnvironmentFactor::Temperature)] = quint8(factors.temperature);
+    record.factors[int(EnvironmentFactor::Humidity)] = quint8(factors.humidity);
+    m_journal.recordAdjudication(record, m_state.simulationTime);
+}
+
+void SimulationCore::appendLog(const QString &aircraftName, const QString &taskName, const QString &message)
+{
+    if (!m_loggingEnabled)
+        return;
+
+    m_state.logs.append(logEntry(aircraftName, taskName, message));
+}
+
+TaskLogEntry SimulationCore::logEntry(const QString &aircraftName, const QString &taskName, const QString &message) const
+{
+    TaskLogEntry entry;
+    entry.aircraftName = aircraftName;
+    entry.taskName = taskName;
+    entry.message = message;
+    entry.timestamp = QStringLiteral("T+%1s").arg(m_state.simulationTime);
+    return entry;
+}
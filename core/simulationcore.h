@@ -0,0 +1,195 @@
+#pragma once
+
+#include <QHash>
+
+#include <functional>
+
+#include "models.h"
+#include "adjudicationengine.h"
+#include "replayjournal.h"
+#include "resultchannel.h"
+#include "scorefieldcache.h"
+#include "simulationtimeline.h"
+#include "taskscheduler.h"
+#include "workstealingpool.h"
+
+#include <vector>
+
+// How manual rulings waiting in the queue hold up the run.
+enum class ManualHoldPolicy
+{
+    HoldAll,     // simulated time stops until every queued ruling is given
+    HoldAffected // only aircraft with a queued ruling stop; the rest run on
+};
+
+// Owns the simulation state and steps it without any widget dependency, so
+// the same scenario can be driven by the GUI timer or by a batch runner.
+class SimulationCore
+{
+public:
+    // Fills in the manual ruling for a task; returning false cancels it.
+    using ManualAdjudicator = std::function<bool(const Aircraft &aircraft, const Task &task, ManualAdjudicationState &state)>;
+
+    SimulationCore() = default;
+
+    SimulationState &state() { return m_state; }
+    const SimulationState &state() const { return m_state; }
+    const AdjudicationEngine &engine() const { return m_engine; }
+
+    void setManualAdjudicator(ManualAdjudicator adjudicator);
+    // With the queue enabled, tasks due in Manual mode are marked
+    // AwaitingRuling and wait for submitRuling() or cancelRuling() instead
+    // of calling the manual adjudicator.
+    void setManualQueueEnabled(bool enabled);
+    void setManualHoldPolicy(ManualHoldPolicy policy);
+    ManualHoldPolicy manualHoldPolicy() const { return m_holdPolicy; }
+    // Tasks awaiting a ruling, oldest first.
+    QVector<TaskRef> pendingRulings() const;
+    bool hasPendingRulings() const { return !m_awaitingSlots.isEmpty(); }
+    // True while HoldAll keeps simulated time from advancing.
+    bool isHeld() const { return m_holdPolicy == ManualHoldPolicy::HoldAll && hasPendingRulings(); }
+    // Rules a queued task now, at the current simulation time. Both return
+    // false if the task is not awaiting a ruling.
+    bool submitRuling(const TaskRef &task, const ManualAdjudicationState &ruling);
+    // The task fails, as when the manual adjudicator cancels.
+    bool cancelRuling(const TaskRef &task);
+    // Replication index used as the Stochastic-mode random stream.
+    void setReplication(quint64 replication);
+    // Batch runs that only need task outcomes can skip building log text.
+    void setLoggingEnabled(bool enabled);
+    // Threads for the motion and adjudication phases of a tick; 1 runs them
+    // inline. Statuses and logs are identical for every thread count.
+    void setThreadCount(int threadCount);
+    int threadCount() const { return m_pool.threadCount(); }
+    // Records which tasks were adjudicated so views can update just those rows.
+    void setChangeTrackingEnabled(bool enabled);
+    // Tasks whose status changed since the last call.
+    QVector<TaskRef> takeChangedTasks();
+
+    // The map dimensions are part of the scenario (1..MaxGridSize per side).
+    void loadSampleScenario(const QSize &gridSize = QSize(DefaultGridSize, DefaultGridSize));
+    // JSON or binary scenario files (see ScenarioFile); the state is left
+    // untouched when loading fails.
+    bool loadScenario(const QString &path, QString *error = nullptr);
+    bool saveScenario(const QString &path, QString *error = nullptr) const;
+    void reset();
+    // Must be called after tasks are added, removed or edited outside the core.
+    void rebuildSchedule();
+    // Must be called after a single environment cell is edited outside the
+    // core; replacing the whole field is detected automatically.
+    void environmentCellChanged(const QPoint &cell);
+
+    // Records the run to a replay journal (see ReplayJournal). The scenario
+    // as it is now is written to the journal and the run restarts from it
+    // at time 0. Loading a scenario or seeking back stops the journal.
+    bool startJournal(const QString &path, QString *error = nullptr);
+    void stopJournal();
+    // Replaces the state with the run rebuilt from a journal; the journal
+    // being recorded, if any, is stopped. The state is left untouched when
+    // the journal cannot be read.
+    bool loadReplay(const QString &path, const ReplayJournal::Options &options, QString *error = nullptr);
+    bool isJournaling() const { return m_journal.isOpen(); }
+    // A failed write stops the journal; this says why until the next start.
+    const QString &journalError() const { return m_journal.errorString(); }
+    // Must be called after routes, tasks, rules, models, the mode or the
+    // current rule or model are edited, or the environment is replaced,
+    // outside the core, so the journal records the edit, later snapshots are
+    // dropped and score fields of deleted models are freed.
+    void scenarioEdited();
+
+    // Publishes every ruling to the shared-memory result channel `name`
+    // (see ResultPublisher) for external displays. Seeking re-simulates
+    // and so publishes the rulings of the re-simulated span again.
+    bool startResultChannel(const QString &name, int capacity = ResultPublisher::DefaultCapacity, QString *error = nullptr);
+    void stopResultChannel();
+    bool isPublishingResults() const { return m_results.isOpen(); }
+
+    // Timeline snapshots (see SimulationTimeline), off until an interval is set.
+    void setSnapshotInterval(double seconds);
+    void setSnapshotBudget(qint64 bytes);
+    const SimulationTimeline &timeline() const { return m_timeline; }
+    // Latest time reached since the last reset or edit; seeking up to here
+    // restores or re-simulates the run as it went.
+    double timelineEnd() const { return qMax(m_timelineEnd, m_state.simulationTime); }
+    // Moves the run to `time`: from the latest snapshot at or before it, or
+    // from the current state if that is closer, simulating forward task by
+    // task. Returns false when going back with no snapshot to go back to.
+    // Manual rulings in the re-simulated span are asked for again.
+    bool seek(double time);
+
+    // Advances the timeline by `seconds` of simulated time.
+    void step(double seconds = 1.0);
+    // Jumps straight to `time`, moving aircraft and adjudicating every task
+    // that falls due on the way in one pass.
+    void advanceTo(double time);
+    // Earliest upcoming task execution or route step, or infinity if none.
+    double nextEventTime() const;
+    bool isFinished() const;
+    // Jumps from task to task; cost follows the number of events, not the
+    // scenario duration.
+    void runToCompletion(int maxSimulationTime);
+
+private:
+    // The task's rule, or the current rule for NoId; the first rule if that
+    // one was removed, and -1 if there are no rules.
+    int ruleIndexFor(RuleId rule) const;
+    TaskRef refForRow(int row) const;
+    // The current model, else the first; null if there are no models.
+    AdjudicationModel *currentModel();
+
+    // Runs fn(chunk, begin, end) over [0, count) in fixed-size chunks on the pool.
+    template <typename Fn>
+    void forEachChunk(int count, int chunkSize, Fn &&fn);
+    void restartTimeline();
+    // Snapshots after an edit no longer describe the run; drop them and
+    // snapshot the edited state.
+    void settleEdits();
+    void moveAircraft(double seconds);
+    void evaluateDueTasks();
+    void adjudicateBatch(const QVector<int> &due);
+    // `ruling` is the operator's ruling for a queued task; null asks the
+    // manual adjudicator, if any, or queues the task.
+    void handleTask(int row, const ManualAdjudicationState *ruling = nullptr);
+    void queueRuling(int row);
+    // Removes the task from the queue and returns its row, or -1 if it is
+    // not queued.
+    int takeAwaiting(const TaskRef &task);
+    // Rebuilds m_awaiting from task statuses and the holds from it.
+    void rebuildAwaiting();
+    void rebuildHolds();
+    void updateHold(int aircraft);
+    void setHeld(int aircraft, bool held);
+    void trackChange(int row);
+    // Stops the journal once a write to it has failed.
+    void checkJournal();
+    // Writes the ruling to the journal and the result channel, whichever are open.
+    void recordAdjudication(int row, const AdjudicationRule *rule, const AdjudicationModel *model, TaskStatus status,
+                            const AdjudicationOutcome &outcome, quint8 flags, quint8 manual = 0);
+    void appendLog(const QString &aircraftName, const QString &taskName, const QString &message);
+    TaskLogEntry logEntry(const QString &aircraftName, const QString &taskName, const QString &message) const;
+
+    SimulationState m_state;
+    AdjudicationEngine m_engine;
+    ManualAdjudicator m_manualAdjudicator;
+    bool m_manualQueueEnabled = false;
+    ManualHoldPolicy m_holdPolicy = ManualHoldPolicy::HoldAffected;
+    // Task rows with status AwaitingRuling, oldest first. Ruled rows are
+    // left as -1 until enough pile up to compact, so taking one is O(1).
+    QVector<int> m_awaiting;
+    QHash<int, int> m_awaitingSlots; // row -> index in m_awaiting
+    QVector<int> m_awaitingPerAircraft; // queued rows per aircraft index
+    TaskScheduler m_scheduler;
+    AdjudicationBatchStorage m_batch;
+    ScoreFieldCache m_scores;
+    WorkStealingPool m_pool;
+    JournalRecorder m_journal;
+    ResultPublisher m_results;
+    SimulationTimeline m_timeline;
+    double m_timelineEnd = 0.0;
+    bool m_historyEdited = false;
+    std::vector<std::vector<TaskLogEntry>> m_chunkLogs; // per adjudication chunk, merged in order
+    quint64 m_replication = 0;
+    bool m_loggingEnabled = true;
+    bool m_changeTrackingEnabled = false;
+    QVector<TaskRef> m_changedTasks;
+};
@@ -0,0 +1,46 @@
+﻿#include "simulationpacer.h"
+
+#include <QtMath>
+
+#include <limits>
+
+void SimulationPacer::setMultiplier(double multiplier, double simulationTime)
+{
+    m_multiplier = qMax(AsFastAsPossible, multiplier);
+    if (isRunning())
+    {
+        start(simulationTime);
+    }
+}
+
+void SimulationPacer::start(double simulationTime)
+{
+    m_anchorSimulationTime = simulationTime;
+    m_clock.start();
+}
+
+void SimulationPacer::stop()
+{
+    m_clock.invalidate();
+}
+
+qint64 SimulationPacer::stepsDue(double simulationTime) const
+{
+    if (!isRunning())
+        return 0;
+    if (isAsFastAsPossible())
+        return std::numeric_limits<qint64>::max();
+
+    const double wallSeconds = m_clock.nsecsElapsed() / 1e9;
+    const double target = m_anchorSimulationTime + wallSeconds * m_multiplier;
+    const double owed = (target - simulationTime) / FixedStep;
+    return owed > 0.0 ? qint64(qFloor(owed)) : 0;
+}
+
+void SimulationPacer::resync(double simulationTime)
+{
+    if (isRunning())
+    {
+        start(simulationTime);
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <QElapsedTimer>
+
+// Maps wall-clock time onto simulated time. The simulation advances in fixed
+// steps; the number owed is derived from a monotonic clock anchored when
+// pacing (re)starts, so timer jitter never accumulates into drift.
+class SimulationPacer
+{
+public:
+    static constexpr double FixedStep = 0.125;     // simulated seconds per step, exact in binary
+    static constexpr double AsFastAsPossible = 0.0; // multiplier value
+
+    void setMultiplier(double multiplier, double simulationTime);
+    double multiplier() const { return m_multiplier; }
+    bool isAsFastAsPossible() const { return m_multiplier <= AsFastAsPossible; }
+
+    void start(double simulationTime);
+    void stop();
+    bool isRunning() const { return m_clock.isValid(); }
+
+    // Fixed steps needed for the simulation to catch up with the wall clock.
+    // Unbounded in as-fast-as-possible mode; callers cap work per frame.
+    qint64 stepsDue(double simulationTime) const;
+    // Drops any backlog the caller could not work off, e.g. after a frame
+    // budget overrun, so the timeline does not try to sprint afterwards.
+    void resync(double simulationTime);
+
+private:
+    QElapsedTimer m_clock;
+    double m_multiplier = 1.0;
+    double m_anchorSimulationTime = 0.0;
+};
@@ -0,0 +1,148 @@
+﻿#include "simulationtimeline.h"
+#include "memoryledger.h"
+
+#include <algorithm>
+#include <limits>
+
+void SimulationTimeline::setInterval(double seconds)
+{
+    m_interval = qMax(0.0, seconds);
+    if (!isEnabled())
+    {
+        clear();
+    }
+}
+
+void SimulationTimeline::setBudget(qint64 bytes)
+{
+    m_budget = qMax<qint64>(0, bytes);
+    enforceBudget();
+}
+
+void SimulationTimeline::clear()
+{
+    m_snapshots.clear();
+    m_blocks.clear();
+    m_bytes = 0;
+}
+
+bool SimulationTimeline::isDue(double time) const
+{
+    return isEnabled() && (m_snapshots.empty() || time >= m_snapshots.back().state.simulationTime + m_interval);
+}
+
+void SimulationTimeline::capture(const SimulationState &state, const TaskScheduler &scheduler)
+{
+    if (!isEnabled())
+        return;
+
+    // Seeking back and running forward again passes times that already have
+    // snapshots; keep the order by time.
+    const double time = state.simulationTime;
+    auto at = std::upper_bound(m_snapshots.begin(), m_snapshots.end(), time, [](double t, const Snapshot &snapshot) {
+        return t < snapshot.state.simulationTime;
+    });
+    Snapshot snapshot{state, scheduler, {}};
+    retain(snapshot);
+    if (at != m_snapshots.begin() && (at - 1)->state.simulationTime == time)
+    {
+        --at;
+        release(*at);
+        *at = std::move(snapshot);
+    }
+    else
+    {
+        m_snapshots.insert(at, std::move(snapshot));
+    }
+    enforceBudget();
+}
+
+int SimulationTimeline::latestAtOrBefore(double time) const
+{
+    auto at = std::upper_bound(m_snapshots.begin(), m_snapshots.end(), time, [](double t, const Snapshot &snapshot) {
+        return t < snapshot.state.simulationTime;
+    });
+    return int(at - m_snapshots.begin()) - 1;
+}
+
+void SimulationTimeline::restore(int index, SimulationState &state, TaskScheduler &scheduler) const
+{
+    const Snapshot &snapshot = m_snapshots[size_t(index)];
+    const bool paused = state.paused;
+    state = snapshot.state;
+    state.paused = paused;
+    scheduler = snapshot.scheduler;
+}
+
+void SimulationTimeline::truncateFrom(double time)
+{
+    auto from = std::lower_bound(m_snapshots.begin(), m_snapshots.end(), time, [](const Snapshot &snapshot, double t) {
+        return snapshot.state.simulationTime < t;
+    });
+    if (from == m_snapshots.end())
+        return;
+    for (auto it = from; it != m_snapshots.end(); ++it)
+    {
+        release(*it);
+    }
+    m_snapshots.erase(from, m_snapshots.end());
+}
+
+void SimulationTimeline::retain(Snapshot &snapshot)
+{
+    MemoryLedger ledger;
+    snapshot.state.aircrafts.accountMemory(ledger);
+    snapshot.state.tasks.accountMemory(ledger);
+    snapshot.state.environment.accountMemory(ledger);
+    snapshot.state.logs.accountMemory(ledger);
+    snapshot.scheduler.accountMemory(ledger);
+    snapshot.blocks = ledger.blocks();
+
+    for (auto it = snapshot.blocks.cbegin(); it != snapshot.blocks.cend(); ++it)
+    {
+        BlockUse &use = m_blocks[it.key()];
+        if (use.snapshots++ == 0)
+        {
+            use.bytes = it.value();
+            m_bytes += use.bytes;
+        }
+    }
+}
+
+void SimulationTimeline::release(const Snapshot &snapshot)
+{
+    // A block stays allocated while any snapshot holds it, so its address
+    // cannot be reused by another block before its count drops to zero.
+    for (auto it = snapshot.blocks.cbegin(); it != snapshot.blocks.cend(); ++it)
+    {
+        auto use = m_blocks.find(it.key());
+        Q_ASSERT(use != m_blocks.end());
+        if (--use->snapshots == 0)
+        {
+            m_bytes -= use->bytes;
+            m_blocks.erase(use);
+        }
+    }
+}
+
+void SimulationTimeline::enforceBudget()
+{
+    while (m_bytes > m_budget && m_snapshots.size() > 1)
+    {
+        // With two left, the later one goes; otherwise the one whose
+        // neighbours are closest, never the first or the latest.
+        size_t victim = m_snapshots.size() - 1;
+        double narrowest = std::numeric_limits<double>::infinity();
+        for (size_t i = 1; i + 1 < m_snapshots.size(); ++i)
+        {
+            const double gap = m_snapshots[i + 1].state.simulationTime - m_snapshots[i - 1].state.simulationTime;
+            if (gap < narrowest)
+            {
+                narrowest = gap;
+                victim = i;
+            }
+        }
+        release(m_snapshots[victim]);
+        m_snapshots.erase(m_snapshots.begin() + qint64(victim));
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <QHash>
+#include <QtGlobal>
+
+#include <vector>
+
+#include "models.h"
+#include "taskscheduler.h"
+
+// Periodic snapshots of a running simulation, for seeking back and forth
+// along the timeline and rolling back. A snapshot is a plain copy of the
+// SimulationState and the task queue: aircraft and task columns, catalogs,
+// environment tiles and log chunks are all implicitly shared, so a snapshot
+// holds on to just what was written since the previous one, and restoring
+// one only swaps shared references.
+//
+// Memory retained by the snapshots (shared blocks counted once) is tracked
+// per block: each snapshot lists the blocks it holds, and a block counts
+// while any snapshot does, so capturing or dropping a snapshot costs only
+// that snapshot's blocks. The total is kept under a budget by thinning: the
+// snapshot whose neighbours are closest together is dropped first, so the
+// ones left stay spread over the run. The earliest snapshot is never thinned.
+class SimulationTimeline
+{
+public:
+    static constexpr qint64 DefaultBudget = qint64(256) * 1024 * 1024;
+
+    // Simulated seconds between snapshots; 0 (the default) disables them.
+    void setInterval(double seconds);
+    double interval() const { return m_interval; }
+    bool isEnabled() const { return m_interval > 0.0; }
+    void setBudget(qint64 bytes);
+    qint64 budget() const { return m_budget; }
+
+    void clear();
+    bool isEmpty() const { return m_snapshots.empty(); }
+    int size() const { return int(m_snapshots.size()); }
+    double time(int index) const { return m_snapshots[size_t(index)].state.simulationTime; }
+    // Bytes kept alive by the snapshots.
+    qint64 memoryUsage() const { return m_bytes; }
+
+    // True when the interval has passed since the latest snapshot.
+    bool isDue(double time) const;
+    void capture(const SimulationState &state, const TaskScheduler &scheduler);
+    // Latest snapshot at or before `time`, or -1.
+    int latestAtOrBefore(double time) const;
+    // Copies snapshot `index` into the state and queue; `paused` is kept.
+    void restore(int index, SimulationState &state, TaskScheduler &scheduler) const;
+    // Drops the snapshots at or after `time`, which an edit made then has
+    // invalidated.
+    void truncateFrom(double time);
+
+private:
+    struct Snapshot
+    {
+        SimulationState state;
+        TaskScheduler scheduler;
+        QHash<const void *, qint64> blocks; // heap blocks held, with sizes
+    };
+    struct BlockUse
+    {
+        qint64 bytes = 0;
+        int snapshots = 0;
+    };
+
+    // Lists the snapshot's blocks and counts them in.
+    void retain(Snapshot &snapshot);
+    void release(const Snapshot &snapshot);
+    void enforceBudget();
+
+    std::vector<Snapshot> m_snapshots; // by time
+    QHash<const void *, BlockUse> m_blocks; // held by at least one snapshot
+    double m_interval = 0.0;
+    qint64 m_budget = DefaultBudget;
+    qint64 m_bytes = 0;
+};
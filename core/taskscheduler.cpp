@@ -0,0 +1,62 @@
+﻿#include "taskscheduler.h"
+#include "memoryledger.h"
+
+#include <algorithm>
+#include <limits>
+
+bool TaskScheduler::later(const Entry &a, const Entry &b)
+{
+    if (a.time != b.time)
+        return a.time > b.time;
+    return a.row > b.row;
+}
+
+void TaskScheduler::rebuild(const TaskTable &tasks)
+{
+    m_heap.clear();
+    const qint32 *times = tasks.executionTimes();
+    for (int row = 0; row < tasks.size(); ++row)
+    {
+        if (tasks.status(row) == TaskStatus::Pending)
+        {
+            m_heap.append({times[row], row});
+        }
+    }
+    std::make_heap(m_heap.begin(), m_heap.end(), later);
+}
+
+void TaskScheduler::clear()
+{
+    m_heap.clear();
+}
+
+int TaskScheduler::nextTime() const
+{
+    return m_heap.isEmpty() ? std::numeric_limits<int>::max() : m_heap.first().time;
+}
+
+void TaskScheduler::popDue(double now, const TaskTable &tasks, QVector<int> &due)
+{
+    const int first = due.size();
+    while (!m_heap.isEmpty() && m_heap.first().time <= now)
+    {
+        std::pop_heap(m_heap.begin(), m_heap.end(), later);
+        const Entry entry = m_heap.takeLast();
+
+        if (entry.row >= tasks.size())
+            continue;
+        if (tasks.status(entry.row) != TaskStatus::Pending || tasks.executionTime(entry.row) != entry.time)
+            continue;
+
+        due.append(entry.row);
+    }
+
+    // Tasks falling due in the same tick are handled in aircraft/task order,
+    // whatever their individual execution times.
+    std::sort(due.begin() + first, due.end());
+}
+
+void TaskScheduler::accountMemory(MemoryLedger &ledger) const
+{
+    ledger.add(m_heap);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <QVector>
+
+#include "models.h"
+
+class MemoryLedger;
+
+// A task addressed by owner and position, as the views see it.
+struct TaskRef
+{
+    int aircraft = 0;
+    int task = 0;
+
+    quint64 key() const { return (quint64(quint32(aircraft)) << 32) | quint32(task); }
+};
+
+// Min-heap of pending task rows keyed by execution time, so a tick only
+// touches the tasks that are actually due. Entries are not updated in place:
+// after tasks are added, removed or retimed the queue must be rebuilt.
+class TaskScheduler
+{
+public:
+    void rebuild(const TaskTable &tasks);
+    void clear();
+
+    bool isEmpty() const { return m_heap.isEmpty(); }
+    // Execution time of the earliest pending task, or INT_MAX when empty.
+    int nextTime() const;
+
+    // Moves every task row due at or before `now` into `due`, in row (that
+    // is aircraft/task) order. Entries whose row no longer exists or is no
+    // longer pending are dropped.
+    void popDue(double now, const TaskTable &tasks, QVector<int> &due);
+
+    void accountMemory(MemoryLedger &ledger) const;
+
+private:
+    struct Entry
+    {
+        int time = 0;
+        int row = 0;
+    };
+
+    static bool later(const Entry &a, const Entry &b);
+
+    QVector<Entry> m_heap;
+};
@@ -0,0 +1,171 @@
+﻿#include "tasktable.h"
+#include "memoryledger.h"
+#include "models.h"
+
+#include <algorithm>
+
+namespace
+{
+template <typename T>
+void rotateRows(QVector<T> &column, int first, int middle)
+{
+    std::rotate(column.begin() + first, column.begin() + middle, column.end());
+}
+
+template <typename T>
+void rotateRows(ChunkedColumn<T> &column, int first, int middle)
+{
+    column.rotate(first, middle);
+}
+}
+
+template <typename Fn>
+void TaskTable::forEachColumn(Fn &&fn)
+{
+    fn(m_executionTimes);
+    fn(m_requirements);
+    fn(m_targetCells);
+    fn(m_rules);
+    fn(m_statuses);
+    fn(m_aircraft);
+    fn(m_names);
+}
+
+void TaskTable::clear()
+{
+    forEachColumn([](auto &column) { column.clear(); });
+}
+
+void TaskTable::reserve(int rows)
+{
+    forEachColumn([rows](auto &column) { column.reserve(rows); });
+}
+
+int TaskTable::append(int aircraft, const Task &task)
+{
+    Q_ASSERT(m_aircraft.isEmpty() || m_aircraft.last() <= aircraft);
+    m_executionTimes.append(task.executionTime);
+    m_requirements.append(task.requirementMask());
+    m_targetCells.append(packCell(task.targetCell));
+    m_rules.append(task.ruleId);
+    m_statuses.append(quint8(task.status));
+    m_aircraft.append(aircraft);
+    m_names.append(task.name);
+    return size() - 1;
+}
+
+void TaskTable::assignRanges(AircraftStore &aircrafts) const
+{
+    int row = 0;
+    for (int a = 0; a < aircrafts.size(); ++a)
+    {
+        const int first = row;
+        while (row < size() && m_aircraft.at(row) == a)
+            ++row;
+        aircrafts.setTaskRange(a, first, row - first);
+    }
+    Q_ASSERT(row == size());
+}
+
+int TaskTable::insert(AircraftStore &aircrafts, int aircraft, int index, const Task &task)
+{
+    Q_ASSERT(index >= 0 && index <= aircrafts.taskCount(aircraft));
+    const int row = aircrafts.firstTask(aircraft) + index;
+
+    m_executionTimes.insert(row, task.executionTime);
+    m_requirements.insert(row, task.requirementMask());
+    m_targetCells.insert(row, packCell(task.targetCell));
+    m_rules.insert(row, task.ruleId);
+    m_statuses.insert(row, quint8(task.status));
+    m_aircraft.insert(row, aircraft);
+    m_names.insert(row, task.name);
+
+    aircrafts.setTaskRange(aircraft, aircrafts.firstTask(aircraft), aircrafts.taskCount(aircraft) + 1);
+    for (int a = aircraft + 1; a < aircrafts.size(); ++a)
+    {
+        aircrafts.setTaskRange(a, aircrafts.firstTask(a) + 1, aircrafts.taskCount(a));
+    }
+    return row;
+}
+
+void TaskTable::remove(AircraftStore &aircrafts, int aircraft, int index)
+{
+    Q_ASSERT(index >= 0 && index < aircrafts.taskCount(aircraft));
+    const int row = aircrafts.firstTask(aircraft) + index;
+
+    forEachColumn([row](auto &column) { column.removeAt(row); });
+
+    aircrafts.setTaskRange(aircraft, aircrafts.firstTask(aircraft), aircrafts.taskCount(aircraft) - 1);
+    for (int a = aircraft + 1; a < aircrafts.size(); ++a)
+    {
+        aircrafts.setTaskRange(a, aircrafts.firstTask(a) - 1, aircrafts.taskCount(a));
+    }
+}
+
+void TaskTable::removeAircraft(AircraftStore &aircrafts, int aircraft)
+{
+    const int first = aircrafts.firstTask(aircraft);
+    const int count = aircrafts.taskCount(aircraft);
+    const int last = aircrafts.size() - 1;
+
+    forEachColumn([first, count](auto &column) { column.remove(first, count); });
+    aircrafts.setTaskRange(aircraft, first, 0);
+    for (int a = aircraft + 1; a <= last; ++a)
+    {
+        aircrafts.setTaskRange(a, aircrafts.firstTask(a) - count, aircrafts.taskCount(a));
+    }
+
+    if (aircraft != last)
+    {
+        // The last aircraft's rows are the tail of the table; rotate them
+        // into the gap so they follow the rows of aircraft - 1.
+        const int moved = aircrafts.firstTask(last);
+        const int movedCount = aircrafts.taskCount(last);
+        forEachColumn([first, moved](auto &column) { rotateRows(column, first, moved); });
+        std::fill(m_aircraft.begin() + first, m_aircraft.begin() + first + movedCount, aircraft);
+        for (int a = aircraft + 1; a < last; ++a)
+        {
+            aircrafts.setTaskRange(a, aircrafts.firstTask(a) + movedCount, aircrafts.taskCount(a));
+        }
+        aircrafts.setTaskRange(last, first, movedCount);
+    }
+    aircrafts.removeAt(aircraft);
+}
+
+Task TaskTable::task(int row) const
+{
+    Task task;
+    task.name = m_names.at(row);
+    task.executionTime = m_executionTimes.at(row);
+    task.setRequirementMask(m_requirements.at(row));
+    task.targetCell = targetPoint(row);
+    task.status = status(row);
+    task.ruleId = m_rules.at(row);
+    return task;
+}
+
+void TaskTable::set(int row, const Task &task)
+{
+    m_executionTimes[row] = task.executionTime;
+    m_requirements[row] = task.requirementMask();
+    m_targetCells[row] = packCell(task.targetCell);
+    m_rules[row] = task.ruleId;
+    m_statuses.set(row, quint8(task.status));
+    m_names[row] = task.name;
+}
+
+void TaskTable::resetStatuses()
+{
+    m_statuses.fill(quint8(TaskStatus::Pending));
+}
+
+void TaskTable::accountMemory(MemoryLedger &ledger) const
+{
+    ledger.add(m_executionTimes);
+    ledger.add(m_requirements);
+    ledger.add(m_targetCells);
+    ledger.add(m_rules);
+    m_statuses.accountMemory(ledger);
+    ledger.add(m_aircraft);
+    ledger.add(m_names);
+}
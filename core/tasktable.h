@@ -0,0 +1,99 @@
+#pragma once
+
+#include <QPoint>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+#include "catalog.h"
+#include "chunkedcolumn.h"
+
+class AircraftStore;
+class MemoryLedger;
+struct Task;
+enum class TaskStatus : quint8;
+using RuleId = CatalogId;
+
+// Every task of a scenario as parallel columns, one row per task. Rows are
+// grouped by owning aircraft in aircraft order, and the AircraftStore keeps
+// each aircraft's rows as [firstTask, firstTask + taskCount), so scheduling, adjudication
+// and status sweeps read only the columns they need. Task is the row's
+// value type at the edit and serialization boundary.
+//
+// Columns are implicitly shared: copying the table (replications, timeline
+// snapshots) costs nothing until a column is written, and only that column
+// is copied. Statuses, written as tasks are ruled, are a ChunkedColumn, so a
+// ruling copies only the chunk of its row.
+class TaskTable
+{
+public:
+    // Target cells are stored packed: x in the low 16 bits, y in the high
+    // 16 bits, both signed, so out-of-map targets survive a round trip.
+    // Coordinates outside int16 do not fit; loaders reject such targets.
+    static bool canPackCell(const QPoint &cell)
+    {
+        return cell.x() >= -32768 && cell.x() <= 32767 && cell.y() >= -32768 && cell.y() <= 32767;
+    }
+    static quint32 packCell(const QPoint &cell)
+    {
+        Q_ASSERT(canPackCell(cell));
+        return (quint32(quint16(cell.y())) << 16) | quint16(cell.x());
+    }
+    static QPoint unpackCell(quint32 packed) { return QPoint(qint16(packed & 0xffff), qint16(packed >> 16)); }
+
+    int size() const { return m_executionTimes.size(); }
+    bool isEmpty() const { return m_executionTimes.isEmpty(); }
+    void clear();
+    void reserve(int rows);
+
+    // Bulk building (loading): rows must be appended in aircraft order.
+    // Call assignRanges() once all rows are in.
+    int append(int aircraft, const Task &task);
+    void assignRanges(AircraftStore &aircrafts) const;
+
+    // Edits: `index` is the position within the aircraft's own tasks. Rows
+    // after it move, so schedules built on row numbers must be rebuilt.
+    int insert(AircraftStore &aircrafts, int aircraft, int index, const Task &task);
+    void remove(AircraftStore &aircrafts, int aircraft, int index);
+    // Drops the aircraft's rows and removes it from the store. The store
+    // moves its last aircraft into the hole, so that aircraft's rows move
+    // too, keeping rows in aircraft order.
+    void removeAircraft(AircraftStore &aircrafts, int aircraft);
+
+    Task task(int row) const;
+    // Replaces every field of the row; the owner does not change.
+    void set(int row, const Task &task);
+
+    int executionTime(int row) const { return m_executionTimes.at(row); }
+    quint8 requirements(int row) const { return m_requirements.at(row); }
+    quint32 targetCell(int row) const { return m_targetCells.at(row); }
+    QPoint targetPoint(int row) const { return unpackCell(m_targetCells.at(row)); }
+    RuleId rule(int row) const { return m_rules.at(row); }
+    TaskStatus status(int row) const { return TaskStatus(m_statuses.at(row)); }
+    int aircraft(int row) const { return m_aircraft.at(row); }
+    const QString &name(int row) const { return m_names.at(row); }
+
+    void setStatus(int row, TaskStatus status) { m_statuses.set(row, quint8(status)); }
+    // Marks every task Pending again.
+    void resetStatuses();
+
+    // Whole columns, `size()` entries each, for sweeps.
+    const qint32 *executionTimes() const { return m_executionTimes.constData(); }
+    const quint8 *requirementMasks() const { return m_requirements.constData(); }
+
+    // Adds the column buffers to `ledger`.
+    void accountMemory(MemoryLedger &ledger) const;
+
+private:
+    // Calls fn(column) for every column.
+    template <typename Fn>
+    void forEachColumn(Fn &&fn);
+
+    QVector<qint32> m_executionTimes;
+    QVector<quint8> m_requirements; // TaskRequirementFlag bits
+    QVector<quint32> m_targetCells; // packCell()
+    QVector<RuleId> m_rules;
+    ChunkedColumn<quint8> m_statuses; // TaskStatus
+    QVector<qint32> m_aircraft;     // owning index into SimulationState::aircrafts
+    QVector<QString> m_names;       // cold; display and logs only
+};
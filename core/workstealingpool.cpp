@@ -0,0 +1,164 @@
+﻿#include "workstealingpool.h"
+
+WorkStealingPool::WorkStealingPool(int threadCount)
+{
+    start(qMax(1, threadCount) - 1);
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    stop();
+}
+
+void WorkStealingPool::setThreadCount(int threadCount)
+{
+    threadCount = qMax(1, threadCount);
+    if (threadCount == this->threadCount())
+        return;
+    stop();
+    start(threadCount - 1);
+}
+
+void WorkStealingPool::start(int workerCount)
+{
+    quint64 generation = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = false;
+        generation = m_generation;
+    }
+    m_shares.reset(new Share[size_t(workerCount) + 1]);
+    m_workers.reserve(size_t(workerCount));
+    for (int i = 1; i <= workerCount; ++i)
+    {
+        m_workers.emplace_back(&WorkStealingPool::workerLoop, this, i, generation);
+    }
+}
+
+void WorkStealingPool::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (std::thread &worker : m_workers)
+    {
+        worker.join();
+    }
+    m_workers.clear();
+}
+
+void WorkStealingPool::run(int chunkCount, const std::function<void(int chunk)> &job)
+{
+    if (chunkCount <= 0)
+        return;
+    const int participants = threadCount();
+    if (participants == 1 || chunkCount == 1)
+    {
+        for (int chunk = 0; chunk < chunkCount; ++chunk)
+        {
+            job(chunk);
+        }
+        return;
+    }
+
+    for (int p = 0; p < participants; ++p)
+    {
+        const quint32 begin = quint32(qint64(chunkCount) * p / participants);
+        const quint32 end = quint32(qint64(chunkCount) * (p + 1) / participants);
+        m_shares[p].range.store(pack(begin, end), std::memory_order_relaxed);
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = &job;
+        m_running = int(m_workers.size());
+        ++m_generation;
+    }
+    m_wake.notify_all();
+
+    participate(0);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_running == 0; });
+    m_job = nullptr;
+}
+
+void WorkStealingPool::workerLoop(int participant, quint64 seen)
+{
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stopping || m_generation != seen; });
+            if (m_stopping)
+                return;
+            seen = m_generation;
+        }
+
+        participate(participant);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_running == 0)
+            m_done.notify_one();
+    }
+}
+
+void WorkStealingPool::participate(int participant)
+{
+    const std::function<void(int)> &job = *m_job;
+    int chunk = 0;
+    for (;;)
+    {
+        while (takeOwn(participant, &chunk))
+        {
+            job(chunk);
+        }
+        if (!steal(participant))
+            return;
+    }
+}
+
+bool WorkStealingPool::takeOwn(int participant, int *chunk)
+{
+    std::atomic<quint64> &range = m_shares[participant].range;
+    quint64 current = range.load(std::memory_order_acquire);
+    for (;;)
+    {
+        const quint32 begin = quint32(current >> 32);
+        const quint32 end = quint32(current);
+        if (begin >= end)
+            return false;
+        if (range.compare_exchange_weak(current, pack(begin + 1, end), std::memory_order_acq_rel))
+        {
+            *chunk = int(begin);
+            return true;
+        }
+    }
+}
+
+bool WorkStealingPool::steal(int thief)
+{
+    const int participants = threadCount();
+    for (int offset = 1; offset < participants; ++offset)
+    {
+        std::atomic<quint64> &victim = m_shares[(thief + offset) % participants].range;
+        quint64 current = victim.load(std::memory_order_acquire);
+        for (;;)
+        {
+            const quint32 begin = quint32(current >> 32);
+            const quint32 end = quint32(current);
+            if (begin >= end)
+                break;
+            const quint32 split = end - qMax<quint32>(1, (end - begin) / 2);
+            if (victim.compare_exchange_weak(current, pack(begin, split), std::memory_order_acq_rel))
+            {
+                // Only this thread takes from its own empty share, so a
+                // plain store hands it the stolen chunks.
+                m_shares[thief].range.store(pack(split, end), std::memory_order_release);
+                return true;
+            }
+        }
+    }
+    return false;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <QtGlobal>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent worker threads that run a job over chunks 0..chunkCount-1.
+// Every participant (the workers and the calling thread) starts on its own
+// contiguous share of the chunks and takes them from the front; once its
+// share runs dry it steals the back half of another participant's share.
+// Chunk boundaries are the caller's, so as long as each chunk writes only
+// its own results, the outcome does not depend on the thread count or on
+// which thread ran which chunk.
+class WorkStealingPool
+{
+public:
+    explicit WorkStealingPool(int threadCount = 1);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    // Total participants including the calling thread; 1 runs every job inline.
+    int threadCount() const { return int(m_workers.size()) + 1; }
+    void setThreadCount(int threadCount);
+
+    // Calls job(chunk) once for every chunk and returns when all are done.
+    // Not reentrant: job must not call run() on the same pool.
+    void run(int chunkCount, const std::function<void(int chunk)> &job);
+
+private:
+    // [begin, end) packed as begin << 32 | end, updated by compare-exchange
+    // from both ends.
+    struct alignas(64) Share
+    {
+        std::atomic<quint64> range{0};
+    };
+
+    static quint64 pack(quint32 begin, quint32 end) { return (quint64(begin) << 32) | end; }
+
+    void start(int workerCount);
+    void stop();
+    // `seen` is the generation at start-up; only later runs wake the worker.
+    void workerLoop(int participant, quint64 seen);
+    void participate(int participant);
+    bool takeOwn(int participant, int *chunk);
+    bool steal(int thief);
+
+    std::vector<std::thread> m_workers;
+    std::unique_ptr<Share[]> m_shares;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    const std::function<void(int)> *m_job = nullptr;
+    quint64 m_generation = 0;
+    int m_running = 0; // workers still inside the current run
+    bool m_stopping = false;
+};
@@ -0,0 +1,118 @@
+﻿#include "models.h"
+#include "resultchannel.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QTextStream>
+#include <QThread>
+
+namespace
+{
+constexpr int kBatch = 256;
+constexpr int kAttachRetryMs = 500;
+
+QString statusName(quint8 status)
+{
+    switch (TaskStatus(status))
+    {
+    case TaskStatus::Pending:
+        return QStringLiteral("pending");
+    case TaskStatus::Success:
+        return QStringLiteral("success");
+    case TaskStatus::Failed:
+        return QStringLiteral("failed");
+    case TaskStatus::AwaitingRuling:
+        return QStringLiteral("awaiting");
+    }
+    return QString::number(status);
+}
+
+// Event letters, upper case for events that succeeded: F fire, H hit, D detection, J jam.
+QString eventLetters(quint8 requirements, quint8 outcomes)
+{
+    const TaskRequirementFlag flags[] = {RequiresFire, RequiresHit, RequiresDetection, RequiresJam};
+    const char letters[] = "fhdj";
+    QString text;
+    for (int i = 0; i < 4; ++i)
+    {
+        if (requirements & flags[i])
+            text += (outcomes & flags[i]) ? QChar::fromLatin1(letters[i]).toUpper() : QChar::fromLatin1(letters[i]);
+    }
+    return text.isEmpty() ? QStringLiteral("-") : text;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("ruling_display"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral(
+        "Tails the adjudication results a running simulation publishes to shared memory and prints them as CSV."));
+    parser.addHelpOption();
+    QCommandLineOption channelOption(QStringLiteral("channel"),
+                                     QStringLiteral("Shared memory key of the result channel (default ruling-results)."),
+                                     QStringLiteral("name"),
+                                     QString::fromLatin1(ResultPublisher::DefaultName));
+    QCommandLineOption pollOption(QStringLiteral("poll-us"),
+                                  QStringLiteral("Sleep <us> microseconds when no result is waiting; 0 spins (default 100)."),
+                                  QStringLiteral("us"),
+                                  QStringLiteral("100"));
+    parser.addOption(channelOption);
+    parser.addOption(pollOption);
+    parser.process(app);
+
+    bool pollOk = false;
+    const int pollUs = parser.value(pollOption).toInt(&pollOk);
+    if (!pollOk || pollUs < 0)
+    {
+        QTextStream(stderr) << "invalid numeric option value\n";
+        return 1;
+    }
+
+    QTextStream out(stdout);
+    out.setCodec("UTF-8");
+    ResultSubscriber results;
+    QString error;
+    bool waiting = false;
+    while (!results.attach(parser.value(channelOption), &error))
+    {
+        if (!waiting)
+        {
+            QTextStream(stderr) << error << ", waiting for the simulation\n";
+            waiting = true;
+        }
+        QThread::msleep(kAttachRetryMs);
+    }
+
+    out << "time,aircraft,task,status,score,threshold,events" << '\n';
+    out.flush();
+    ResultRecord records[kBatch];
+    for (;;)
+    {
+        // Check before reading so records published just before closing are not lost.
+        const bool open = results.isPublisherOpen();
+        const int count = results.read(records, kBatch);
+        for (int i = 0; i < count; ++i)
+        {
+            const ResultRecord &r = records[i];
+            out << r.time << ',' << r.aircraftNameString() << ',' << r.taskNameString() << ',' << statusName(r.status)
+                << ',' << QString::number(r.score, 'f', 2) << ',' << r.threshold << ','
+                << eventLetters(r.requirements, r.outcomes) << '\n';
+        }
+        if (count > 0)
+        {
+            out.flush();
+            continue;
+        }
+        if (!open)
+            break;
+        if (pollUs > 0)
+            QThread::usleep(ulong(pollUs));
+    }
+
+    if (results.droppedCount() > 0)
+        QTextStream(stderr) << results.droppedCount() << " results were overwritten before they could be shown\n";
+    return 0;
+}
@@ -0,0 +1,190 @@
+﻿#include "seatclient.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QTextStream>
+#include <QTimer>
+
+#include <thread>
+
+namespace
+{
+QString describeRequirements(quint8 mask)
+{
+    QStringList names;
+    if (mask & RequiresFire)
+        names << QStringLiteral("fire");
+    if (mask & RequiresHit)
+        names << QStringLiteral("hit");
+    if (mask & RequiresDetection)
+        names << QStringLiteral("detect");
+    if (mask & RequiresJam)
+        names << QStringLiteral("jam");
+    return names.isEmpty() ? QStringLiteral("-") : names.join(QLatin1Char(','));
+}
+
+// Ruling bits as letters: f fire allowed, h hit, d detection, j jam.
+QString rulingLetters(quint8 bits)
+{
+    QString letters;
+    const char flags[] = "fhdj";
+    for (int i = 0; i < 4; ++i)
+    {
+        if (bits & (1 << i))
+            letters += QLatin1Char(flags[i]);
+    }
+    return letters.isEmpty() ? QStringLiteral("-") : letters;
+}
+
+bool parseRulingLetters(const QString &text, ManualAdjudicationState *state)
+{
+    quint8 bits = 0;
+    if (text != QLatin1String("-"))
+    {
+        for (QChar c : text)
+        {
+            const int flag = QStringLiteral("fhdj").indexOf(c);
+            if (flag < 0)
+                return false;
+            bits |= quint8(1 << flag);
+        }
+    }
+    *state = ManualAdjudicationState::fromBits(bits);
+    return true;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("ruling_seat"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral(
+        "Adjudication seat: rules manual tasks queued by a running simulation.\n"
+        "Commands: <id> takes the default ruling, <id> <fhdj> sets fire allowed, hit,\n"
+        "detection and jam success by letter (- for none), <id> cancel fails the task, quit exits."));
+    parser.addHelpOption();
+    QCommandLineOption serverOption(QStringLiteral("server"),
+                                    QStringLiteral("Local socket name of the simulation (default ruling-seats)."),
+                                    QStringLiteral("name"),
+                                    QString::fromLatin1(SeatProtocol::DefaultServerName));
+    QCommandLineOption portOption(QStringList{QStringLiteral("p"), QStringLiteral("port")},
+                                  QStringLiteral("Connect over TCP to <port> on 127.0.0.1 instead of the local socket."),
+                                  QStringLiteral("port"));
+    QCommandLineOption nameOption(QStringLiteral("name"),
+                                  QStringLiteral("Seat name shown to the simulation (default seat-<pid>)."),
+                                  QStringLiteral("name"));
+    QCommandLineOption autoOption(QStringLiteral("auto"),
+                                  QStringLiteral("Answer every request with its default ruling after <ms> instead of reading commands."),
+                                  QStringLiteral("ms"));
+    parser.addOption(serverOption);
+    parser.addOption(portOption);
+    parser.addOption(nameOption);
+    parser.addOption(autoOption);
+    parser.process(app);
+
+    bool portOk = true;
+    const uint port = parser.isSet(portOption) ? parser.value(portOption).toUInt(&portOk) : 0;
+    bool delayOk = true;
+    const int autoDelay = parser.isSet(autoOption) ? parser.value(autoOption).toInt(&delayOk) : -1;
+    if (!portOk || port > 65535 || !delayOk || (parser.isSet(autoOption) && autoDelay < 0))
+    {
+        QTextStream(stderr) << "invalid numeric option value\n";
+        return 1;
+    }
+
+    const QString name = parser.isSet(nameOption) ? parser.value(nameOption)
+                                                   : QStringLiteral("seat-%1").arg(QCoreApplication::applicationPid());
+    SeatClient client(name);
+    QTextStream out(stdout);
+    out.setCodec("UTF-8");
+
+    QObject::connect(&client, &SeatClient::connected, [&] {
+        out << "connected as seat " << client.seatId() << " (" << name << ")\n";
+        out.flush();
+    });
+    QObject::connect(&client, &SeatClient::disconnected, [&] {
+        out << "disconnected\n";
+        out.flush();
+        app.exit(0);
+    });
+    QObject::connect(&client, &SeatClient::errorOccurred, [&](const QString &message) {
+        QTextStream(stderr) << message << '\n';
+        app.exit(1);
+    });
+    QObject::connect(&client, &SeatClient::requestReceived, [&](const SeatMessage &request) {
+        if (autoDelay >= 0)
+        {
+            const quint64 id = request.requestId;
+            const ManualAdjudicationState ruling = ManualAdjudicationState::fromBits(request.ruling);
+            QTimer::singleShot(autoDelay, &client, [&client, id, ruling] { client.submit(id, ruling); });
+            return;
+        }
+        out << '#' << request.requestId << ' ' << request.aircraftName << '/' << request.taskName
+            << " t=" << request.executionTime << " target=(" << request.target.x() << ',' << request.target.y()
+            << ") requires=" << describeRequirements(request.requirements)
+            << " default=" << rulingLetters(request.ruling) << " within " << request.timeoutMs / 1000 << "s\n";
+        out.flush();
+    });
+    QObject::connect(&client, &SeatClient::requestWithdrawn, [&](quint64 requestId) {
+        if (autoDelay >= 0)
+            return;
+        out << '#' << requestId << " withdrawn\n";
+        out.flush();
+    });
+
+    if (port != 0)
+        client.connectToTcp(quint16(port));
+    else
+        client.connectToLocal(parser.value(serverOption));
+
+    if (autoDelay < 0)
+    {
+        // Blocking console reads stay off the event loop; each line is handled on the main thread.
+        auto handleLine = [&](const QString &line) {
+            const QStringList words = line.split(QLatin1Char(' '), Qt::SkipEmptyParts);
+            if (words.isEmpty())
+                return;
+            if (words.first() == QLatin1String("quit"))
+            {
+                client.disconnectFromServer();
+                app.exit(0);
+                return;
+            }
+            bool idOk = false;
+            const quint64 id = words.first().toULongLong(&idOk);
+            ManualAdjudicationState ruling;
+            if (!idOk || words.size() > 2)
+            {
+                out << "expected <id> [fhdj | - | cancel]\n";
+            }
+            else if (words.size() == 2 && words.at(1) == QLatin1String("cancel"))
+            {
+                client.cancel(id);
+            }
+            else if (words.size() == 2 && !parseRulingLetters(words.at(1), &ruling))
+            {
+                out << "ruling letters are f, h, d and j\n";
+            }
+            else
+            {
+                client.submit(id, ruling);
+            }
+            out.flush();
+        };
+        std::thread reader([&app, handleLine] {
+            QTextStream in(stdin);
+            in.setCodec("UTF-8");
+            QString line;
+            while (in.readLineInto(&line))
+            {
+                QMetaObject::invokeMethod(&app, [handleLine, line] { handleLine(line); }, Qt::QueuedConnection);
+            }
+            QMetaObject::invokeMethod(&app, [&app] { app.exit(0); }, Qt::QueuedConnection);
+        });
+        reader.detach();
+    }
+
+    return app.exec();
+}